@@ -0,0 +1,359 @@
+/*
+ * SUMMARY:      Calib_Objective.c
+ * USAGE:        goodness of fit of the simulated discharge to the observation
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the observed daily discharge (FP_QOBS) is matched to the days of
+ *               the simulation period, and the simulated outlet discharge is scored
+ *               by the Nash-Sutcliffe (NSE) or Kling-Gupta (KGE) efficiency
+ * DESCRIP-END.
+ * FUNCTIONS:    Calib_Obs_Import(); Calib_Obs_Free(); Calib_Stats_Reset();
+ *               Calib_Stats_Add(); Calib_Stats_Score(); Calib_Eval_Init();
+ *               Calib_Eval_Step(); Calib_Eval_Score(); Calib_Objective()
+ *
+ * COMMENTS:
+ * FP_QOBS: one day per line, either "yyyy m d Q" (Qobs_daily_Chitan_*.txt)
+ * or "yyyy-mm-dd Q" (Qobs_daily_Jianning.txt), separated by tabs or blanks;
+ * other lines (headers) are skipped, negative Q is taken as missing.
+ * The scores need only the sums of CALIB_STATS, so they can be accumulated
+ * day by day (CALIB_EVAL) inside the simulation loop. As the remaining days
+ * only add to the squared error, and (Q >= 0) to the simulated volume, the
+ * final score is bounded from above at any step:
+ * - NSE <= 1 - sum((s - o)^2, days so far) / sum((o - mean_o)^2, all days)
+ * - KGE <= 1 - |beta - 1| <= 2 - sum(s, days so far) / sum(o, all days), if beta > 1
+ * A run whose bound is not above score_min cannot beat it and is aborted.
+ *
+ * REFERENCES:
+ * Nash, J. E., Sutcliffe, J. V., River flow forecasting through conceptual
+ *      models part I - A discussion of principles, Journal of Hydrology, 10 (3), 282-290, 1970.
+ * Gupta, H. V., Kling, H., Yilmaz, K. K., Martinez, G. F., Decomposition of the mean squared
+ *      error and NSE performance criteria, Journal of Hydrology, 377 (1-2), 80-91, 2009.
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * char FP_QOBS[]                   - file path of the observed daily discharge
+ * time_t start_time                - start of the simulation
+ * int time_steps_run               - number of simulation steps
+ * int STEP_TIME                    - the step length, [h]
+ * CALIB_OBS *obs                   - the observation on the days of the simulation period
+ * CALIB_STATS *stats               - the sums of the compared days
+ * double *Qout                     - the simulated discharge at the outlet, time_steps_run steps, [m3/s]
+ * int warmup_steps                 - the first steps, not compared
+ * int objective                    - CALIB_NSE or CALIB_KGE
+ * CALIB_EVAL *eval                 - the score of a run, step by step
+ * int outlet                       - the compared outlet
+ * double score_min                 - the run is aborted once its final score cannot exceed score_min
+ * int t                            - the simulation step
+ * double Q                         - the simulated discharge at the outlet of step t, [m3/s]
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "Constants.h"
+#include "Calib_Objective.h"
+
+static long Calib_Day_Number(
+    int year,
+    int month,
+    int day
+)
+{
+    /* days since 1970-01-01 of a date (proleptic Gregorian calendar) */
+    long y = year - (month <= 2);
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void Calib_Obs_Import(
+    char FP_QOBS[],
+    time_t start_time,
+    int time_steps_run,
+    int STEP_TIME,
+    CALIB_OBS *obs
+)
+{
+    FILE *fp;
+    char row[MAXCHAR];
+    int year, month, day;
+    double Q;
+    long day0 = 0, day_obs;
+    time_t run_time;
+    struct tm *tm_run;
+
+    /* the days of the simulation steps */
+    if (time_steps_run <= 0)
+    {
+        printf("Error: no simulation step to compare with %s\n", FP_QOBS);
+        exit(0);
+    }
+    obs->step_day = (int *)malloc(sizeof(int) * time_steps_run);
+    if (obs->step_day == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    run_time = start_time;
+    for (int t = 0; t < time_steps_run; t++)
+    {
+        tm_run = gmtime(&run_time);
+        day_obs = Calib_Day_Number(tm_run->tm_year + 1900, tm_run->tm_mon + 1, tm_run->tm_mday);
+        if (t == 0)
+        {
+            day0 = day_obs;
+        }
+        *(obs->step_day + t) = (int)(day_obs - day0);
+        run_time += 3600 * STEP_TIME;
+    }
+    obs->day_count = *(obs->step_day + time_steps_run - 1) + 1;
+    obs->day_steps = (int *)calloc(obs->day_count, sizeof(int));
+    obs->obs = (double *)malloc(sizeof(double) * obs->day_count);
+    if (obs->day_steps == NULL || obs->obs == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (int t = 0; t < time_steps_run; t++)
+    {
+        *(obs->day_steps + *(obs->step_day + t)) += 1;
+    }
+    for (int d = 0; d < obs->day_count; d++)
+    {
+        *(obs->obs + d) = -1.0;
+    }
+
+    /* the observation */
+    if ((fp = fopen(FP_QOBS, "r")) == NULL)
+    {
+        printf("cannot open file %s\n", FP_QOBS);
+        exit(0);
+    }
+    while (fgets(row, MAXCHAR, fp) != NULL)
+    {
+        if (sscanf(row, "%d-%d-%d %lf", &year, &month, &day, &Q) != 4 &&
+            sscanf(row, "%d %d %d %lf", &year, &month, &day, &Q) != 4)
+        {
+            continue;
+        }
+        day_obs = Calib_Day_Number(year, month, day) - day0;
+        if (day_obs >= 0 && day_obs < obs->day_count && Q >= 0.0)
+        {
+            *(obs->obs + day_obs) = Q;
+        }
+    }
+    fclose(fp);
+    obs->obs_count = 0;
+    for (int d = 0; d < obs->day_count; d++)
+    {
+        if (*(obs->obs + d) >= 0.0)
+        {
+            obs->obs_count++;
+        }
+    }
+    if (obs->obs_count == 0)
+    {
+        printf("Error: no observation in %s within the simulation period\n", FP_QOBS);
+        exit(0);
+    }
+}
+
+void Calib_Obs_Free(
+    CALIB_OBS *obs
+)
+{
+    free(obs->step_day); free(obs->day_steps); free(obs->obs);
+}
+
+void Calib_Stats_Reset(
+    CALIB_STATS *stats
+)
+{
+    stats->n = 0;
+    stats->sum_s = 0.0;
+    stats->sum_o = 0.0;
+    stats->sum_ss = 0.0;
+    stats->sum_oo = 0.0;
+    stats->sum_so = 0.0;
+    stats->sum_ee = 0.0;
+}
+
+void Calib_Stats_Add(
+    CALIB_STATS *stats,
+    double s,
+    double o
+)
+{
+    stats->n += 1;
+    stats->sum_s += s;
+    stats->sum_o += o;
+    stats->sum_ss += s * s;
+    stats->sum_oo += o * o;
+    stats->sum_so += s * o;
+    stats->sum_ee += (s - o) * (s - o);
+}
+
+double Calib_Stats_Score(
+    CALIB_STATS *stats,
+    int objective
+)
+{
+    /**********
+     * NSE = 1 - sum((s - o)^2) / sum((o - mean_o)^2)
+     * KGE = 1 - sqrt((r - 1)^2 + (sd_s / sd_o - 1)^2 + (mean_s / mean_o - 1)^2)
+     */
+    double n, mean_s, mean_o, var_s, var_o, cov;
+    double r, alpha, beta;
+    if (stats->n < 2)
+    {
+        return -INFINITY;
+    }
+    n = (double)stats->n;
+    mean_s = stats->sum_s / n;
+    mean_o = stats->sum_o / n;
+    var_s = stats->sum_ss / n - mean_s * mean_s;
+    var_o = stats->sum_oo / n - mean_o * mean_o;
+    cov = stats->sum_so / n - mean_s * mean_o;
+    if (var_o <= 0.0)
+    {
+        return -INFINITY;
+    }
+    if (objective == CALIB_KGE)
+    {
+        if (var_s <= 0.0 || mean_o <= 0.0)
+        {
+            return -INFINITY;
+        }
+        r = cov / sqrt(var_s * var_o);
+        alpha = sqrt(var_s / var_o);
+        beta = mean_s / mean_o;
+        return 1.0 - sqrt((r - 1) * (r - 1) + (alpha - 1) * (alpha - 1) + (beta - 1) * (beta - 1));
+    }
+    return 1.0 - stats->sum_ee / (n * var_o);
+}
+
+void Calib_Eval_Init(
+    CALIB_EVAL *eval,
+    CALIB_OBS *obs,
+    int outlet,
+    int warmup_steps,
+    int objective,
+    double score_min
+)
+{
+    int t = 0;  // the first step of day d
+    eval->obs = obs;
+    eval->outlet = outlet;
+    eval->warmup_steps = warmup_steps;
+    eval->objective = objective;
+    eval->score_min = score_min;
+    Calib_Stats_Reset(&eval->total);
+    for (int d = 0; d < obs->day_count; d++)
+    {
+        if (t >= warmup_steps && *(obs->obs + d) >= 0.0)
+        {
+            Calib_Stats_Add(&eval->total, *(obs->obs + d), *(obs->obs + d));
+        }
+        t += *(obs->day_steps + d);
+    }
+    Calib_Stats_Reset(&eval->stats);
+    eval->t_day = 0;
+    eval->Q_day = 0.0;
+    eval->status = CALIB_RUN_ON;
+    eval->steps = 0;
+    eval->score_bound = INFINITY;
+}
+
+int Calib_Eval_Step(
+    CALIB_EVAL *eval,
+    int t,
+    double Q
+)
+{
+    /******
+     * add the discharge of step t (steps in order); at the end of a compared day,
+     * the bound of the final score: returns 1 if the run is to be aborted
+     */
+    CALIB_OBS *obs = eval->obs;
+    CALIB_STATS *total = &eval->total;
+    int d = *(obs->step_day + t);
+    double n, mean_o, var_o, beta;
+    eval->steps = t + 1;
+    eval->Q_day += Q;
+    if (t + 1 - eval->t_day < *(obs->day_steps + d))
+    {
+        return 0;
+    }
+    // the last step of day d
+    if (eval->t_day >= eval->warmup_steps && *(obs->obs + d) >= 0.0)
+    {
+        Calib_Stats_Add(&eval->stats, eval->Q_day / *(obs->day_steps + d), *(obs->obs + d));
+        n = (double)total->n;
+        mean_o = total->sum_o / n;
+        var_o = total->sum_oo / n - mean_o * mean_o;
+        if (total->n < 2 || var_o <= 0.0 || mean_o <= 0.0)
+        {
+            // no valid final score: see Calib_Stats_Score()
+            eval->score_bound = -INFINITY;
+        }
+        else if (eval->objective == CALIB_KGE)
+        {
+            beta = (eval->stats.sum_s / n) / mean_o;
+            eval->score_bound = (beta > 1.0) ? 2.0 - beta : 1.0;
+        }
+        else
+        {
+            eval->score_bound = 1.0 - eval->stats.sum_ee / (n * var_o);
+        }
+        if (eval->score_bound <= eval->score_min)
+        {
+            eval->status = CALIB_RUN_BOUND;
+        }
+    }
+    eval->t_day = t + 1;
+    eval->Q_day = 0.0;
+    return eval->status;
+}
+
+double Calib_Eval_Score(
+    CALIB_EVAL *eval
+)
+{
+    /* the final score; the bound of the final score, if aborted */
+    if (eval->status == CALIB_RUN_BOUND)
+    {
+        return eval->score_bound;
+    }
+    return Calib_Stats_Score(&eval->stats, eval->objective);
+}
+
+double Calib_Objective(
+    CALIB_OBS *obs,
+    double *Qout,
+    int warmup_steps,
+    int objective
+)
+{
+    /* the score of a simulated discharge series: the daily means of the days after the warm-up */
+    CALIB_EVAL eval;
+    int t = 0;
+    Calib_Eval_Init(&eval, obs, 0, warmup_steps, objective, -INFINITY);
+    for (int d = 0; d < obs->day_count; d++)
+    {
+        for (int k = 0; k < *(obs->day_steps + d); k++)
+        {
+            Calib_Eval_Step(&eval, t, *(Qout + t));
+            t++;
+        }
+    }
+    return Calib_Eval_Score(&eval);
+}
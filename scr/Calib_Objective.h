@@ -0,0 +1,104 @@
+#ifndef CALIB_OBJ
+#define CALIB_OBJ
+
+#include <time.h>
+
+/* CALIB_OBJECTIVE: the goodness of fit of the simulated outlet discharge, 1: perfect */
+#define CALIB_NSE 0   // Nash-Sutcliffe efficiency
+#define CALIB_KGE 1   // Kling-Gupta efficiency
+
+/* CALIB_EVAL.status */
+#define CALIB_RUN_ON 0      // running, or run to the end
+#define CALIB_RUN_BOUND 1   // aborted: the final score cannot exceed score_min
+
+typedef struct
+{
+    /******
+     * the observed daily discharge on the days of the simulation period;
+     * the simulated discharge is compared as the daily mean of the steps of a day
+     */
+    int day_count;      /* number of days of the simulation period */
+    int *step_day;      /* the day (from 0) of each simulation step */
+    int *day_steps;     /* number of simulation steps of each day */
+    double *obs;        /* the observed discharge of each day, [m3/s]; negative: not observed */
+    int obs_count;      /* number of days with an observation */
+} CALIB_OBS;
+
+typedef struct
+{
+    /* sums over the compared days of the simulated s and observed o discharge */
+    int n;
+    double sum_s;
+    double sum_o;
+    double sum_ss;
+    double sum_oo;
+    double sum_so;
+    double sum_ee;      /* sum of (s - o)^2 */
+} CALIB_STATS;
+
+typedef struct
+{
+    /******
+     * the score of a run, accumulated step by step inside the simulation loop;
+     * the run is aborted as soon as an upper bound of its final score is not
+     * above score_min, see Calib_Eval_Step()
+     */
+    CALIB_OBS *obs;
+    int outlet;         /* the compared outlet */
+    int warmup_steps;
+    int objective;
+    double score_min;   /* -INFINITY: never aborted */
+    CALIB_STATS total;  /* the observation of all the compared days (as s and o) */
+    CALIB_STATS stats;  /* the compared days so far */
+    int t_day;          /* the first step of the current day */
+    double Q_day;       /* sum of the simulated discharge over the steps of the current day, [m3/s] */
+    int status;         /* CALIB_RUN_ON or CALIB_RUN_BOUND */
+    int steps;          /* number of steps simulated */
+    double score_bound; /* upper bound of the final score when aborted */
+} CALIB_EVAL;
+
+void Calib_Obs_Import(
+    char FP_QOBS[],
+    time_t start_time,
+    int time_steps_run,
+    int STEP_TIME,
+    CALIB_OBS *obs);
+
+void Calib_Obs_Free(
+    CALIB_OBS *obs);
+
+void Calib_Stats_Reset(
+    CALIB_STATS *stats);
+
+void Calib_Stats_Add(
+    CALIB_STATS *stats,
+    double s,
+    double o);
+
+double Calib_Stats_Score(
+    CALIB_STATS *stats,
+    int objective);
+
+void Calib_Eval_Init(
+    CALIB_EVAL *eval,
+    CALIB_OBS *obs,
+    int outlet,
+    int warmup_steps,
+    int objective,
+    double score_min);
+
+int Calib_Eval_Step(
+    CALIB_EVAL *eval,
+    int t,
+    double Q);
+
+double Calib_Eval_Score(
+    CALIB_EVAL *eval);
+
+double Calib_Objective(
+    CALIB_OBS *obs,
+    double *Qout,
+    int warmup_steps,
+    int objective);
+
+#endif
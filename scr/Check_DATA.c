@@ -9,7 +9,7 @@
  * DESCRIPTION:  the investigated attributes: ncols, nrows, cellsize_m, STEP_TIME
  *               and the model simulation period
  * DESCRIP-END.
- * FUNCTIONS:    Check_weather()
+ * FUNCTIONS:    Check_weather(); Check_GEO(); Check_State()
  * 
  * COMMENTS:
  * 
@@ -22,6 +22,7 @@
 
 #include "NC_copy_global_att.h"
 #include "Check_Data.h"
+#include "State_IO.h"
 
 void Check_weather(
     int ncID_PRE, 
@@ -250,6 +251,47 @@ void Check_GEO(
     status_nc = nc_inq_varid(ncID_GEO, "VEGFRAC", &varID); handle_error(status_nc, "GEO.nc: VEGFRAC"); 
     status_nc = nc_inq_varid(ncID_GEO, "SOILTYPE", &varID); handle_error(status_nc, "GEO.nc: SOILTYPE"); 
 }
+void Check_State(
+    int ncID_GEO,
+    int ncID_STATE,
+    char FP_STATE[]
+)
+{
+    /* a state file (see State_IO.c) has to be on the grid of the GEO data */
+    int status_nc;
+    int varID;
+    int attV_GEO, attV_STATE;
+    double attD_GEO, attD_STATE;
+    char *att_int[3] = {"ncols", "nrows", "cellsize_m"};
+    char *att_double[3] = {"xllcorner", "yllcorner", "cellsize"};
+    for (size_t i = 0; i < 3; i++)
+    {
+        nc_get_att_int(ncID_GEO, NC_GLOBAL, att_int[i], &attV_GEO);
+        status_nc = nc_get_att_int(ncID_STATE, NC_GLOBAL, att_int[i], &attV_STATE); handle_error(status_nc, FP_STATE);
+        if (attV_GEO != attV_STATE)
+        {
+            printf("Error: state file and GEO data have different global attribute: %s\n", att_int[i]);
+            exit(-2);
+        }
+    }
+    for (size_t i = 0; i < 3; i++)
+    {
+        nc_get_att_double(ncID_GEO, NC_GLOBAL, att_double[i], &attD_GEO);
+        status_nc = nc_get_att_double(ncID_STATE, NC_GLOBAL, att_double[i], &attD_STATE); handle_error(status_nc, FP_STATE);
+        if (attD_GEO != attD_STATE)
+        {
+            printf("Error: state file and GEO data have different global attribute: %s\n", att_double[i]);
+            exit(-2);
+        }
+    }
+    char FP_var[MAXCHAR];
+    for (size_t v = 0; v < STATE_VARS_CELL + STATE_VARS_STREAM; v++)
+    {
+        snprintf(FP_var, MAXCHAR, "%s: %s", FP_STATE, state_name[v]);
+        status_nc = nc_inq_varid(ncID_STATE, state_name[v], &varID); handle_error(status_nc, FP_var);
+    }
+}
+
 // int main(int argc, char const *argv[])
 // {
 //     /* code */
@@ -20,5 +20,11 @@ void Check_GEO(
     int ncID_GEO
 );
 
+void Check_State(
+    int ncID_GEO,
+    int ncID_STATE,
+    char FP_STATE[]
+);
+
 #endif
 
@@ -0,0 +1,373 @@
+/*
+ * SUMMARY:      Checkpoint.c
+ * USAGE:        write and read the model state for restarting a simulation
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  save the complete state of a running simulation into a
+ *               binary checkpoint file every CHECKPOINT_STEPS steps, so that
+ *               a run that was killed can be resumed with "--restart" from
+ *               the last checkpoint instead of from the start
+ * DESCRIP-END.
+ * FUNCTIONS:    Checkpoint_Header(); Checkpoint_Write(); Checkpoint_Read();
+ *               Checkpoint_IO(); Checkpoint_Arrays(); Checkpoint_State()
+ *
+ * COMMENTS:
+ * layout of the file (version 1), all values in the native binary format:
+ * - CHECKPOINT_HEADER
+ * - the state arrays of data_RADIA, data_ET and data_SOIL, in the order of
+ *   the members in "HM_ST.h", cell_counts_total doubles each
+ * - data_STREAM, cell_counts_total CELL_VAR_STREAM
+ * - the UH partial sums: UH_ring_Infil, UH_ring_Satur (STREAM);
+ *   ring_Infil, ring_Satur of each outlet (CLASS)
+ * - the outlet discharge of steps 0, ..., t-1 of each outlet:
+ *   Qout_SF_Infil, Qout_SF_Satur (STREAM, CLASS) and Qout_Sub
+ * - the surface runoff maps of steps 0, ..., t-1 (BATCH)
+ * - CHECKPOINT_MAGIC again, marking a complete file
+ * the file is written to FP.tmp, flushed to disk and then renamed to FP:
+ * a run killed while writing leaves the previous checkpoint intact.
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * char FP[]                        - file path of the checkpoint
+ * CHECKPOINT_HEADER *header        - configuration of the run, see "Checkpoint.h"
+ * int t                            - the number of completed steps
+ * CELL_VAR_RADIA *data_RADIA       - radiation state of all the cells
+ * CELL_VAR_ET *data_ET             - evapotranspiration state (interception storages)
+ * CELL_VAR_SOIL *data_SOIL         - soil water state (soil moisture, water table)
+ * CELL_VAR_STREAM *data_STREAM     - channel state (water volume, discharge)
+ * int cell_counts_total            - number of raster cells
+ * double *UH_ring_*                - streaming UH routing: partial sums of the outlet discharge
+ * UH_CLASS *uh_class               - UH of flow-time classes, with the class runoff sums
+ * double *Qout_*                   - discharge series at the outlets, [m3/h]
+ * int *out_SW_Run_*                - surface runoff series, 0.1 mm (BATCH)
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "Constants.h"
+#include "HM_ST.h"
+#include "UH_Routing.h"
+#include "Checkpoint.h"
+
+void Checkpoint_Header(
+    CHECKPOINT_HEADER *header,
+    int ncols,
+    int nrows,
+    int cell_count,
+    int STEP_TIME,
+    long start_time,
+    int time_steps_run,
+    int UH_mode,
+    int outlet_count,
+    int UH_ring_count
+)
+{
+    memset(header, 0, sizeof(CHECKPOINT_HEADER));
+    memcpy(header->magic, CHECKPOINT_MAGIC, 8);
+    header->version = CHECKPOINT_VERSION;
+    header->ncols = ncols;
+    header->nrows = nrows;
+    header->cell_count = cell_count;
+    header->STEP_TIME = STEP_TIME;
+    header->start_time = start_time;
+    header->time_steps_run = time_steps_run;
+    header->UH_mode = UH_mode;
+    header->outlet_count = outlet_count;
+    header->UH_ring_count = UH_ring_count;
+    header->stream_size = sizeof(CELL_VAR_STREAM);
+    header->t = 0;
+}
+
+static void Checkpoint_IO(
+    FILE *fp,
+    void *data,
+    size_t size,
+    size_t count,
+    int write,
+    char FP[]
+)
+{
+    /* write == 1: write count items of size bytes; 0: read them; stop the program when it fails */
+    size_t done;
+    if (write == 1)
+    {
+        done = fwrite(data, size, count, fp);
+    }
+    else
+    {
+        done = fread(data, size, count, fp);
+    }
+    if (done != count)
+    {
+        printf("error in %s the checkpoint file %s (truncated or disk full?)\n",
+               (write == 1) ? "writing" : "reading", FP);
+        exit(0);
+    }
+}
+
+#define CHECKPOINT_ARRAYS 38  /* the cell arrays of data_RADIA (7), data_ET (10) and data_SOIL (21) */
+
+static void Checkpoint_Arrays(
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    double **cell_var
+)
+{
+    /* the cell arrays of the state structures, in the order of the members in "HM_ST.h" */
+    int n = 0;
+    cell_var[n++] = data_RADIA->Rs;
+    cell_var[n++] = data_RADIA->L_sky;
+    cell_var[n++] = data_RADIA->Rno;
+    cell_var[n++] = data_RADIA->Rno_short;
+    cell_var[n++] = data_RADIA->Rnu;
+    cell_var[n++] = data_RADIA->Rnu_short;
+    cell_var[n++] = data_RADIA->Rns;
+    cell_var[n++] = data_ET->Prec_throughfall;
+    cell_var[n++] = data_ET->Prec_net;
+    cell_var[n++] = data_ET->Ep;
+    cell_var[n++] = data_ET->EI_o;
+    cell_var[n++] = data_ET->ET_o;
+    cell_var[n++] = data_ET->EI_u;
+    cell_var[n++] = data_ET->ET_u;
+    cell_var[n++] = data_ET->ET_s;
+    cell_var[n++] = data_ET->Interception_o;
+    cell_var[n++] = data_ET->Interception_u;
+    cell_var[n++] = data_SOIL->SM_Upper;
+    cell_var[n++] = data_SOIL->SM_Lower;
+    cell_var[n++] = data_SOIL->SW_Infiltration;
+    cell_var[n++] = data_SOIL->SW_Percolation_Upper;
+    cell_var[n++] = data_SOIL->SW_Percolation_Lower;
+    cell_var[n++] = data_SOIL->SW_SR_Infil;
+    cell_var[n++] = data_SOIL->SW_SR_Satur;
+    cell_var[n++] = data_SOIL->z;
+    for (int d = 0; d < 8; d++)
+    {
+        cell_var[n++] = data_SOIL->q[d];
+    }
+    cell_var[n++] = data_SOIL->Qout;
+    cell_var[n++] = data_SOIL->Qin;
+    cell_var[n++] = data_SOIL->SW_rise_lower;
+    cell_var[n++] = data_SOIL->SW_rise_upper;
+    cell_var[n++] = data_SOIL->SW_rf;
+}
+
+static void Checkpoint_State(
+    FILE *fp,
+    int write,
+    char FP[],
+    CHECKPOINT_HEADER *header,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    int cell_counts_total,
+    double *UH_ring_Infil,
+    double *UH_ring_Satur,
+    UH_CLASS *uh_class,
+    double *Qout_SF_Infil,
+    double *Qout_SF_Satur,
+    double *Qout_Sub,
+    int *out_SW_Run_Infil,
+    int *out_SW_Run_Satur
+)
+{
+    /******
+     * the arrays following the header, in the same order for writing and reading;
+     * the cell arrays of the state structures are listed by Checkpoint_Arrays()
+     */
+    double *cell_var[CHECKPOINT_ARRAYS];
+    int t = header->t;
+    long length;
+    Checkpoint_Arrays(data_RADIA, data_ET, data_SOIL, cell_var);
+    for (int i = 0; i < CHECKPOINT_ARRAYS; i++)
+    {
+        Checkpoint_IO(fp, cell_var[i], sizeof(double), cell_counts_total, write, FP);
+    }
+    Checkpoint_IO(fp, data_STREAM, sizeof(CELL_VAR_STREAM), cell_counts_total, write, FP);
+
+    if (header->UH_mode == UH_MODE_STREAM)
+    {
+        Checkpoint_IO(fp, UH_ring_Infil, sizeof(double), header->UH_ring_count, write, FP);
+        Checkpoint_IO(fp, UH_ring_Satur, sizeof(double), header->UH_ring_count, write, FP);
+    }
+    else if (header->UH_mode == UH_MODE_CLASS)
+    {
+        for (int s = 0; s < header->outlet_count; s++)
+        {
+            length = (long)(uh_class + s)->class_count * (uh_class + s)->UH_steps;
+            Checkpoint_IO(fp, (uh_class + s)->ring_Infil, sizeof(double), length, write, FP);
+            Checkpoint_IO(fp, (uh_class + s)->ring_Satur, sizeof(double), length, write, FP);
+        }
+    }
+    for (int s = 0; s < header->outlet_count; s++)
+    {
+        // BATCH: the surface runoff is routed after the simulation, Qout_SF_* not yet set
+        if (header->UH_mode != UH_MODE_BATCH)
+        {
+            Checkpoint_IO(fp, Qout_SF_Infil + s * header->time_steps_run, sizeof(double), t, write, FP);
+            Checkpoint_IO(fp, Qout_SF_Satur + s * header->time_steps_run, sizeof(double), t, write, FP);
+        }
+        Checkpoint_IO(fp, Qout_Sub + s * header->time_steps_run, sizeof(double), t, write, FP);
+    }
+    if (header->UH_mode == UH_MODE_BATCH)
+    {
+        length = (long)t * cell_counts_total;
+        Checkpoint_IO(fp, out_SW_Run_Infil, sizeof(int), length, write, FP);
+        Checkpoint_IO(fp, out_SW_Run_Satur, sizeof(int), length, write, FP);
+    }
+}
+
+void Checkpoint_Write(
+    char FP[],
+    CHECKPOINT_HEADER *header,
+    int t,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    int cell_counts_total,
+    double *UH_ring_Infil,
+    double *UH_ring_Satur,
+    UH_CLASS *uh_class,
+    double *Qout_SF_Infil,
+    double *Qout_SF_Satur,
+    double *Qout_Sub,
+    int *out_SW_Run_Infil,
+    int *out_SW_Run_Satur
+)
+{
+    /* the state after t completed steps */
+    FILE *fp;
+    char FP_tmp[MAXCHAR + 4];
+    snprintf(FP_tmp, sizeof(FP_tmp), "%s.tmp", FP);
+    if ((fp = fopen(FP_tmp, "wb")) == NULL)
+    {
+        printf("cannot create the checkpoint file %s\n", FP_tmp);
+        exit(0);
+    }
+    header->t = t;
+    Checkpoint_IO(fp, header, sizeof(CHECKPOINT_HEADER), 1, 1, FP_tmp);
+    Checkpoint_State(
+        fp, 1, FP_tmp, header,
+        data_RADIA, data_ET, data_SOIL, data_STREAM, cell_counts_total,
+        UH_ring_Infil, UH_ring_Satur, uh_class,
+        Qout_SF_Infil, Qout_SF_Satur, Qout_Sub,
+        out_SW_Run_Infil, out_SW_Run_Satur);
+    Checkpoint_IO(fp, CHECKPOINT_MAGIC, 1, 8, 1, FP_tmp);
+    /* on disk before it replaces the previous checkpoint */
+    if (fflush(fp) != 0)
+    {
+        printf("error in writing the checkpoint file %s\n", FP_tmp);
+        exit(0);
+    }
+#ifdef _WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+    fclose(fp);
+#ifdef _WIN32
+    if (MoveFileExA(FP_tmp, FP, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == 0)
+#else
+    if (rename(FP_tmp, FP) != 0)
+#endif
+    {
+        printf("cannot replace the checkpoint file %s\n", FP);
+        exit(0);
+    }
+}
+
+int Checkpoint_Read(
+    char FP[],
+    CHECKPOINT_HEADER *header,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    int cell_counts_total,
+    double *UH_ring_Infil,
+    double *UH_ring_Satur,
+    UH_CLASS *uh_class,
+    double *Qout_SF_Infil,
+    double *Qout_SF_Satur,
+    double *Qout_Sub,
+    int *out_SW_Run_Infil,
+    int *out_SW_Run_Satur
+)
+{
+    /**********
+     * restore the state saved by Checkpoint_Write(); header holds the
+     * configuration of the current run and has to match the one of the
+     * checkpoint; returns the number of completed steps t
+     */
+    FILE *fp;
+    CHECKPOINT_HEADER saved;
+    char magic_end[8];
+    if ((fp = fopen(FP, "rb")) == NULL)
+    {
+        printf("cannot open the checkpoint file %s\n", FP);
+        exit(0);
+    }
+    Checkpoint_IO(fp, &saved, sizeof(CHECKPOINT_HEADER), 1, 0, FP);
+    if (memcmp(saved.magic, CHECKPOINT_MAGIC, 8) != 0)
+    {
+        printf("%s is not an xHM checkpoint file\n", FP);
+        exit(0);
+    }
+    if (saved.version != CHECKPOINT_VERSION)
+    {
+        printf("checkpoint file %s: version %d, this xHM reads version %d\n", FP, saved.version, CHECKPOINT_VERSION);
+        exit(0);
+    }
+    if (saved.ncols != header->ncols || saved.nrows != header->nrows || saved.cell_count != header->cell_count)
+    {
+        printf("checkpoint file %s: written for a different GEO grid (%d x %d, %d active cells)\n",
+               FP, saved.nrows, saved.ncols, saved.cell_count);
+        exit(0);
+    }
+    if (saved.STEP_TIME != header->STEP_TIME || saved.start_time != header->start_time ||
+        saved.time_steps_run != header->time_steps_run)
+    {
+        printf("checkpoint file %s: written for a different simulation period or STEP_TIME\n", FP);
+        exit(0);
+    }
+    if (saved.UH_mode != header->UH_mode || saved.outlet_count != header->outlet_count ||
+        saved.UH_ring_count != header->UH_ring_count || saved.stream_size != header->stream_size)
+    {
+        printf("checkpoint file %s: written with a different UH_MODE, UH or xHM build\n", FP);
+        exit(0);
+    }
+    if (saved.t < 1 || saved.t > saved.time_steps_run)
+    {
+        printf("checkpoint file %s: invalid number of completed steps %d\n", FP, saved.t);
+        exit(0);
+    }
+    header->t = saved.t;
+    Checkpoint_State(
+        fp, 0, FP, header,
+        data_RADIA, data_ET, data_SOIL, data_STREAM, cell_counts_total,
+        UH_ring_Infil, UH_ring_Satur, uh_class,
+        Qout_SF_Infil, Qout_SF_Satur, Qout_Sub,
+        out_SW_Run_Infil, out_SW_Run_Satur);
+    Checkpoint_IO(fp, magic_end, 1, 8, 0, FP);
+    if (memcmp(magic_end, CHECKPOINT_MAGIC, 8) != 0)
+    {
+        printf("checkpoint file %s is incomplete\n", FP);
+        exit(0);
+    }
+    fclose(fp);
+    return saved.t;
+}
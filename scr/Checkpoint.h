@@ -0,0 +1,79 @@
+#ifndef CHECKPOINT
+#define CHECKPOINT
+
+#include "HM_ST.h"
+#include "UH_Routing.h"
+
+/* the binary checkpoint file: a CHECKPOINT_HEADER followed by the state arrays, see Checkpoint.c */
+#define CHECKPOINT_MAGIC "xHM-CKPT"  // 8 characters, without the terminating '\0'
+#define CHECKPOINT_VERSION 1         // increased whenever the layout of the file changes
+
+typedef struct
+{
+    /******
+     * the configuration a checkpoint was written with; a restart is only
+     * accepted when all the fields match the current run, except t
+     */
+    char magic[8];          /* CHECKPOINT_MAGIC */
+    int version;            /* CHECKPOINT_VERSION */
+    int ncols;              /* raster dimensions of the GEO data */
+    int nrows;
+    int cell_count;         /* number of active cells */
+    int STEP_TIME;          /* [h] */
+    long start_time;        /* simulation start, time_t */
+    int time_steps_run;     /* number of simulation steps */
+    int UH_mode;            /* UH_MODE_BATCH, UH_MODE_STREAM or UH_MODE_CLASS */
+    int outlet_count;
+    int UH_ring_count;      /* length of the UH partial sums: UH_steps_total (STREAM), sum of K * U (CLASS), 0 (BATCH) */
+    int stream_size;        /* sizeof(CELL_VAR_STREAM), guards against files from other builds */
+    int t;                  /* steps 0, ..., t-1 are completed, the run resumes with step t */
+} CHECKPOINT_HEADER;
+
+void Checkpoint_Header(
+    CHECKPOINT_HEADER *header,
+    int ncols,
+    int nrows,
+    int cell_count,
+    int STEP_TIME,
+    long start_time,
+    int time_steps_run,
+    int UH_mode,
+    int outlet_count,
+    int UH_ring_count);
+
+void Checkpoint_Write(
+    char FP[],
+    CHECKPOINT_HEADER *header,
+    int t,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    int cell_counts_total,
+    double *UH_ring_Infil,
+    double *UH_ring_Satur,
+    UH_CLASS *uh_class,
+    double *Qout_SF_Infil,
+    double *Qout_SF_Satur,
+    double *Qout_Sub,
+    int *out_SW_Run_Infil,
+    int *out_SW_Run_Satur);
+
+int Checkpoint_Read(
+    char FP[],
+    CHECKPOINT_HEADER *header,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    int cell_counts_total,
+    double *UH_ring_Infil,
+    double *UH_ring_Satur,
+    UH_CLASS *uh_class,
+    double *Qout_SF_Infil,
+    double *Qout_SF_Satur,
+    double *Qout_Sub,
+    int *out_SW_Run_Infil,
+    int *out_SW_Run_Satur);
+
+#endif
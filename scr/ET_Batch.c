@@ -0,0 +1,751 @@
+/*
+ * SUMMARY:      ET_Batch.c
+ * USAGE:        Evapotranspiration and unsaturated zone of batches of cells,
+ *               the array form of ET_CELL() and UnsaturatedWaterMove()
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  Sort the active cells by the stories they have (kind),
+ *               and compute the radiation, evapotranspiration and unsaturated
+ *               soil water movement of a batch of cells of one kind at a time
+ * DESCRIP-END.
+ * FUNCTIONS:    ET_Batch_Plan(); ET_Batch_Free(); ET_Batch_Gather();
+ *               ET_Batch_Run(); ET_Batch_Scatter(); ET_Batch_Check();
+ *               ET_Batch_Step(); ET_BATCH_KIND()
+ * COMMENTS:
+ * ET_CELL() takes one cell through scalar arguments and pointers and branches
+ * on the stories of the cell (overstory, understory, bare soil) at every step.
+ * The stories only depend on the canopy fraction and the vegetation class, so
+ * the active cells are sorted by kind once (ET_Batch_Plan()); a batch holds
+ * the inputs of up to ET_BATCH_SIZE cells of one kind as contiguous arrays
+ * (ET_Batch_Gather()), the terms depending only on the vegetation class and
+ * month (the shortwave transmission of the stories) taken from the vegetation table.
+ * ET_Batch_Run() calls the kernel of the kind, ET_BATCH_KIND() expanded with
+ * the stories as constants: ET_Batch_Kernel() and ET_Batch_Iteration() (ET_CELL()
+ * and ET_iteration()), then ET_Batch_Unsat() (UnsaturatedWaterMove(), in which
+ * the evapotranspiration of absent stories drops out of the water balance),
+ * all without branches on the stories; ET_Batch_Scatter() writes the results
+ * back to the raster arrays.
+ * Whether the water input ponds (Soil_Infiltration()) depends on the input of
+ * the step, and remains a branch per cell. The cells are not sorted further by
+ * vegetation or soil class: neither decides a branch, and the row-major order
+ * within a kind keeps the raster arrays read in sequence.
+ *
+ * ET_CELL() and UnsaturatedWaterMove() remain the reference: the batch evaluates
+ * the same expressions in the same order (less the terms that are 0.0),
+ * so that the results are identical bit for bit;
+ * ET_KERNEL CHECK compares the two at every cell and step (ET_Batch_Check()).
+ *
+ */
+
+/*********************************************************
+ * VARIABLEs:
+ * ET_BATCH_PLAN *plan          - the active cells sorted by kind, cut into batches
+ * ET_BATCH *batch              - the inputs, states and outputs of the cells of a batch
+ * int b                        - the batch, from 0 to plan->batch_count - 1
+ * int *data_forcing[]          - the forcing of the step, FORCING_VARS rasters (see Forcing_Reader.h)
+ * double scale_forcing[]       - the scale factors of the forcing variables
+ * RADIA_ASTRO *radia_astro     - the astronomical radiation terms of the rows, see Radiation_Astro_Rows()
+ * ST_VEG_CLASS *veg_table      - the vegetation parameters of the classes and months, see Lookup_VegLib_Table()
+ * double Soil_d1, Soil_d2      - the thickness of the upper and lower soil layer, [m]
+ * int i_m                      - the month, from 0
+ * int et_kernel                - ET_KERNEL_BATCH or ET_KERNEL_CHECK
+ * long *check_diff             - ET_KERNEL_CHECK: incremented by the cells differing from the reference
+ *
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Constants.h"
+#include "HM_ST.h"
+#include "Forcing_Reader.h"
+#include "Evapotranspiration.h"
+#include "Evapotranspiration_Energy.h"
+#include "Resistance.h"
+#include "Evaporation_soil.h"
+#include "Soil_Desorption.h"
+#include "Soil_Infiltration.h"
+#include "Soil_Percolation.h"
+#include "Soil_UnsaturatedMove.h"
+#include "ET_Batch.h"
+
+/* the kernels are expanded into each kind, where over and under are constants */
+#ifdef __GNUC__
+#define ET_BATCH_INLINE static inline __attribute__((always_inline))
+#else
+#define ET_BATCH_INLINE static inline
+#endif
+
+void ET_Batch_Plan(
+    ET_BATCH_PLAN *plan,
+    CELL_LIST *cell_list,
+    ST_CELL_VEG *cell_veg,
+    ST_VEG_CLASS *veg_table
+)
+{
+    int c, k, b, index_geo;
+    int *cell_kind;
+    int kind_fill[ET_KIND_COUNT];
+    double Frac;
+    int Understory;
+
+    plan->cell_count = cell_list->cell_count;
+    plan->cell_index = (int *)malloc(sizeof(int) * (plan->cell_count + 1));
+    cell_kind = (int *)malloc(sizeof(int) * (plan->cell_count + 1));
+    if (plan->cell_index == NULL || cell_kind == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (k = 0; k <= ET_KIND_COUNT; k++)
+    {
+        plan->kind_start[k] = 0;
+    }
+    /* the kind of the cells: the thresholds of ET_CELL() / Radiation_net() and ET_iteration() */
+    for (c = 0; c < plan->cell_count; c++)
+    {
+        index_geo = *(cell_list->cell_index + c);
+        Frac = (cell_veg + index_geo)->CAN_FRAC;
+        Understory = (veg_table + (cell_veg + index_geo)->CLASS * 12)->Understory; // the same in all months
+        if (Frac >= 0.001)
+        {
+            *(cell_kind + c) = (Understory == 1) ? ET_KIND_OU : ET_KIND_O;
+        }
+        else if (Frac < 0.0001)
+        {
+            *(cell_kind + c) = (Understory == 1) ? ET_KIND_U : ET_KIND_S;
+        }
+        else
+        {
+            *(cell_kind + c) = ET_KIND_MIX;
+        }
+        plan->kind_start[*(cell_kind + c) + 1]++;
+    }
+    /* counting sort, the row-major order is kept within a kind */
+    for (k = 0; k < ET_KIND_COUNT; k++)
+    {
+        plan->kind_start[k + 1] += plan->kind_start[k];
+        kind_fill[k] = plan->kind_start[k];
+    }
+    for (c = 0; c < plan->cell_count; c++)
+    {
+        *(plan->cell_index + kind_fill[*(cell_kind + c)]++) = *(cell_list->cell_index + c);
+    }
+    free(cell_kind);
+
+    /* batches: at most ET_BATCH_SIZE cells, never across two kinds */
+    plan->batch_count = 0;
+    for (k = 0; k < ET_KIND_COUNT; k++)
+    {
+        plan->batch_count += (plan->kind_start[k + 1] - plan->kind_start[k] + ET_BATCH_SIZE - 1) / ET_BATCH_SIZE;
+    }
+    plan->batch_start = (int *)malloc(sizeof(int) * (plan->batch_count + 1));
+    plan->batch_kind = (int *)malloc(sizeof(int) * (plan->batch_count + 1));
+    if (plan->batch_start == NULL || plan->batch_kind == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    b = 0;
+    for (k = 0; k < ET_KIND_COUNT; k++)
+    {
+        for (c = plan->kind_start[k]; c < plan->kind_start[k + 1]; c += ET_BATCH_SIZE)
+        {
+            *(plan->batch_start + b) = c;
+            *(plan->batch_kind + b) = k;
+            b++;
+        }
+    }
+    *(plan->batch_start + b) = plan->cell_count;
+}
+
+void ET_Batch_Free(
+    ET_BATCH_PLAN *plan
+)
+{
+    free(plan->cell_index);
+    free(plan->batch_start);
+    free(plan->batch_kind);
+}
+
+void ET_Batch_Gather(
+    ET_BATCH *batch,
+    ET_BATCH_PLAN *plan,
+    int b,
+    int *data_forcing[],
+    double scale_forcing[],
+    RADIA_ASTRO *radia_astro,
+    int ncols,
+    ST_CELL_VEG *cell_veg,
+    ST_VEG_CLASS *veg_table,
+    int i_m,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_d1,
+    double Soil_d2,
+    int step_time
+)
+{
+    /* the inputs and states of the cells of batch b, as in the scalar cell loop of xHM_main.c */
+    int i, index_geo;
+    int c_begin = *(plan->batch_start + b);
+    ST_VEG_CLASS *veg;
+    ST_SOIL_PARA_CELL *soil;
+
+    batch->n = *(plan->batch_start + b + 1) - c_begin;
+    batch->kind = *(plan->batch_kind + b);
+    batch->Soil_d1 = Soil_d1;
+    batch->Soil_d2 = Soil_d2;
+    for (i = 0; i < batch->n; i++)
+    {
+        index_geo = *(plan->cell_index + c_begin + i);
+        batch->astro[i] = *(radia_astro + index_geo / ncols);
+        batch->Prec[i] = *(data_forcing[FORCING_PRE] + index_geo) * scale_forcing[FORCING_PRE] / 1000; // [m]
+        batch->Prs[i] = *(data_forcing[FORCING_PRS] + index_geo) * scale_forcing[FORCING_PRS];
+        batch->Ssd[i] = *(data_forcing[FORCING_SSD] + index_geo) * scale_forcing[FORCING_SSD];
+        batch->Rhu[i] = *(data_forcing[FORCING_RHU] + index_geo) * scale_forcing[FORCING_RHU];
+        batch->Win[i] = *(data_forcing[FORCING_WIN] + index_geo) * scale_forcing[FORCING_WIN];
+        batch->Tem_avg[i] = *(data_forcing[FORCING_TEM_AVG] + index_geo) * scale_forcing[FORCING_TEM_AVG];
+        batch->Tem_max[i] = *(data_forcing[FORCING_TEM_MAX] + index_geo) * scale_forcing[FORCING_TEM_MAX];
+        batch->Tem_min[i] = *(data_forcing[FORCING_TEM_MIN] + index_geo) * scale_forcing[FORCING_TEM_MIN];
+
+        veg = veg_table + (cell_veg + index_geo)->CLASS * 12 + i_m;
+        batch->Frac[i] = (cell_veg + index_geo)->CAN_FRAC;
+        batch->Ref_o[i] = veg->Albedo_o;
+        batch->Ref_u[i] = veg->Albedo_u;
+        batch->LAI_o[i] = veg->LAI_o;
+        batch->LAI_u[i] = veg->LAI_u;
+        batch->Tau_o[i] = veg->Tau_o;
+        batch->Tau_u[i] = veg->Tau_u;
+        batch->Rpc[i] = veg->Rpc;
+        batch->rs_min[i] = veg->rs_min_o;
+        batch->aero[i] = veg->aero;
+        batch->Understory[i] = veg->Understory;
+
+        soil = soil_para + index_geo;
+        batch->soil[i] = soil;
+        batch->SM[i] = *(data_SOIL->SM_Upper + index_geo);
+        batch->SM_lower[i] = *(data_SOIL->SM_Lower + index_geo);
+        batch->SM_wp[i] = soil->WiltingPoint;
+        batch->SM_free[i] = soil->FieldCapacity;
+        batch->Soil_Fe[i] = Soil_Desorption(
+            batch->SM[i], soil->Ksat_upper, soil->PoreSize_index,
+            soil->Porosity_upper, soil->Bubbling, step_time); // unit: m
+        batch->SW_rise_upper[i] = *(data_SOIL->SW_rise_upper + index_geo);
+        batch->SW_rise_lower[i] = *(data_SOIL->SW_rise_lower + index_geo);
+
+        batch->Interception_o[i] = *(data_ET->Interception_o + index_geo);
+        batch->Interception_u[i] = *(data_ET->Interception_u + index_geo);
+        batch->Rnu[i] = *(data_RADIA->Rnu + index_geo);
+        batch->Rnu_short[i] = *(data_RADIA->Rnu_short + index_geo);
+    }
+}
+
+ET_BATCH_INLINE void ET_Batch_Iteration(
+    ET_BATCH *batch,
+    int i,
+    double Radia_net,
+    double Resist_canopy_o,
+    double Resist_canopy_u,
+    double Resist_aero_o,
+    double Resist_aero_u,
+    int over,       /* 1: overstory */
+    int under,      /* 1: understory */
+    int step_time
+)
+{
+    /* ET_iteration() on cell i of the batch, with the stories as constants */
+    double Ep_u;
+    if (over == 1)
+    {
+        batch->Ep[i] = PotentialEvaporation(
+            batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i],
+            batch->Prs[i], batch->Rhu[i], Radia_net, Resist_aero_o);
+        ET_story(batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i], batch->Prs[i],
+                 batch->Prec[i], batch->Prec_throughfall + i,
+                 batch->Ep[i],
+                 batch->EI_o + i, batch->ET_o + i,
+                 batch->Interception_o + i, Resist_canopy_o, Resist_aero_o, batch->LAI_o[i],
+                 batch->Frac[i], step_time);
+    }
+    else
+    {
+        batch->ET_o[i] = 0.0;
+        batch->EI_o[i] = 0.0;
+        batch->Prec_throughfall[i] = batch->Prec[i];
+        batch->Interception_o[i] = 0.0;
+        batch->Ep[i] = PotentialEvaporation(
+            batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i],
+            batch->Prs[i], batch->Rhu[i], Radia_net, Resist_aero_u);
+    }
+
+    Ep_u = batch->Ep[i] - (batch->ET_o[i] + batch->EI_o[i]) / step_time;
+    if (under == 1)
+    {
+        ET_story(batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i], batch->Prs[i],
+                 batch->Prec_throughfall[i], batch->Prec_net + i,
+                 Ep_u,
+                 batch->EI_u + i, batch->ET_u + i,
+                 batch->Interception_u + i, Resist_canopy_u, Resist_aero_u, batch->LAI_u[i],
+                 1.0, step_time);
+        batch->ET_s[i] = 0.0;
+    }
+    else
+    {
+        batch->ET_s[i] = ET_soil(Ep_u, batch->Soil_Fe[i] / step_time) * step_time;
+        batch->EI_u[i] = 0.0;
+        batch->ET_u[i] = 0.0;
+        batch->Interception_u[i] = 0.0;
+        batch->Prec_net[i] = batch->Prec_throughfall[i] - batch->ET_s[i];
+        if (batch->Prec_net[i] < 0.0)
+        {
+            batch->Prec_net[i] = 0.0;
+        }
+    }
+}
+
+ET_BATCH_INLINE void ET_Batch_Kernel(
+    ET_BATCH *batch,
+    int over,       /* 1: overstory */
+    int under,      /* 1: understory */
+    int step_time
+)
+{
+    /******
+     * ET_CELL() over the cells of a batch, with the stories fixed by the kind:
+     * inlined with constant over and under, the branches of Radiation_net()
+     * and ET_CELL() on the stories vanish from the loops;
+     * the calls into the C library (exp, pow) and the other modules are kept
+     * in scalar loops ahead of the arithmetic loops (omp simd), as in
+     * Soil_Satu_Outflow_Band()
+     */
+    int i, n = batch->n;
+    double L[ET_BATCH_SIZE];      // longwave emission at the air temperature: overstory, understory and soil, [kJ/m2/h]
+    double R_net[ET_BATCH_SIZE];
+    double Rp_o[ET_BATCH_SIZE], Rp_u[ET_BATCH_SIZE];
+    double Res_canopy_o[ET_BATCH_SIZE], Res_canopy_u[ET_BATCH_SIZE];
+    double Res_aero_o[ET_BATCH_SIZE], Res_aero_u[ET_BATCH_SIZE];
+    double Ref_s = ALBEDO_SOIL;
+
+    /* sky radiation, [MJ/m2/d] to [kJ/m2/h] */
+    for (i = 0; i < n; i++)
+    {
+        batch->Rs[i] = Radiation_downward_short_astro(batch->astro + i, batch->Ssd[i]) * 1000/24;
+        batch->L_sky[i] = Radiation_downward_long_astro(
+            batch->astro + i, batch->Tem_avg[i], batch->Rhu[i], batch->Ssd[i], 0.0) * 1000/24;
+        L[i] = Emissivity(batch->Tem_avg[i]);
+    }
+
+    /* net radiation of the stories, Radiation_net() */
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for (i = 0; i < n; i++)
+    {
+        double Frac, Lo, Ls, Lu, Tau_o, Tau_u;
+        Frac = (over == 1) ? batch->Frac[i] : 0.0;
+        Tau_o = (over == 1) ? batch->Tau_o[i] : 0.0;  // from the vegetation table, see Lookup_VegLib_Table()
+        Tau_u = (under == 1) ? batch->Tau_u[i] : 1.0;
+        Lo = (over == 1) ? L[i] : 0.0;
+        Ls = (under == 1) ? L[i] : 0.0;
+        Lu = L[i];
+        if (over == 1)
+        {
+            batch->Rno_short[i] = batch->Rs[i] * ((1 - batch->Ref_o[i]) - Tau_o * (1 - batch->Ref_u[i])) * Frac;
+            batch->Rno[i] = batch->Rno_short[i] + (batch->L_sky[i] + Lu - 2 * Lo) * Frac;
+        }
+        else
+        {
+            batch->Rno_short[i] = 0.0;
+            batch->Rno[i] = 0.0;
+        }
+        if (under == 1)
+        {
+            batch->Rnu_short[i] = batch->Rs[i] * ((1 - batch->Ref_u[i]) - Tau_u * (1 - Ref_s)) * (1 - Frac + Tau_o * Frac);
+            batch->Rnu[i] = batch->Rnu_short[i] +
+                            (1 - Frac) * (batch->L_sky[i] + Ls - 2 * Lu) + Frac * (Lo + Ls - 2 * Lu);
+        }
+        batch->Rns[i] = batch->Rs[i] * Tau_u * (1 - Ref_s) * (1 - Frac + Tau_o * Frac) +
+                        Lo * Frac + batch->L_sky[i] * (1 - Frac) - Ls;
+        if (over == 1)
+        {
+            R_net[i] = batch->Rno[i];
+        }
+        else if (under == 1)
+        {
+            R_net[i] = batch->Rnu[i];
+        }
+        else
+        {
+            R_net[i] = batch->Rns[i];
+        }
+        Rp_o[i] = VISFRACT * batch->Rno_short[i] * 1000/3600;  // convert kJ/m2/h to W/m2, the same unit as Rpc
+        Rp_u[i] = VISFRACT * batch->Rnu_short[i] * 1000/3600;
+    }
+
+    /* canopy and aerodynamic resistances */
+    for (i = 0; i < n; i++)
+    {
+        if (over == 1)
+        {
+            Res_canopy_o[i] = Resist_Stomatal(
+                batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i], batch->Rhu[i],
+                Rp_o[i], batch->Rpc[i], batch->rs_min[i], RS_MAX,
+                batch->SM[i], batch->SM_wp[i], batch->SM_free[i]) / batch->LAI_o[i];
+            Res_aero_o[i] = Resist_aero_o_Pre(batch->Win[i], batch->aero + i);
+        }
+        else
+        {
+            Res_canopy_o[i] = 1.0;
+            Res_aero_o[i] = 1.0;
+        }
+        if (under == 1)
+        {
+            Res_canopy_u[i] = Resist_Stomatal(
+                batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i], batch->Rhu[i],
+                Rp_u[i], batch->Rpc[i], batch->rs_min[i], RS_MAX,
+                batch->SM[i], batch->SM_wp[i], batch->SM_free[i]) / batch->LAI_u[i];
+            Res_aero_u[i] = Resist_aero_u_Pre(batch->Win[i], batch->aero + i);
+        }
+        else
+        {
+            Res_canopy_u[i] = 1.0;
+            Res_aero_u[i] = 1.0;
+        }
+    }
+
+    /* evaporation and transpiration of the stories */
+    for (i = 0; i < n; i++)
+    {
+        ET_Batch_Iteration(
+            batch, i, R_net[i],
+            Res_canopy_o[i], Res_canopy_u[i],
+            Res_aero_o[i], Res_aero_u[i],
+            over, under, step_time);
+    }
+}
+
+ET_BATCH_INLINE void ET_Batch_Unsat(
+    ET_BATCH *batch,
+    int over,       /* 1: overstory */
+    int under,      /* 1: understory */
+    int step_time
+)
+{
+    /******
+     * UnsaturatedWaterMove() over the cells of a batch, after ET_Batch_Kernel():
+     * with constant over and under, the transpiration of an absent story and the
+     * soil evaporation under an understory (0.0, see ET_Batch_Iteration())
+     * drop out of the water balance of the upper layer
+     */
+    int i;
+    double Water_input, SM_d, SM_buff, ET_o_lowersoil;
+    double Soil_d1 = batch->Soil_d1, Soil_d2 = batch->Soil_d2;
+    ST_SOIL_PARA_CELL *soil;
+
+    for (i = 0; i < batch->n; i++)
+    {
+        soil = batch->soil[i];
+        Water_input = batch->Prec_net[i] / step_time;
+        if (Water_input > 0.0)
+        {
+            batch->SW_Infiltration[i] = Soil_Infiltration(
+                Water_input, batch->SM[i],
+                soil->Porosity_upper, soil->Ksat_upper, soil->Tension_effective,
+                step_time);
+            if (Water_input * step_time > batch->SW_Infiltration[i])
+            {
+                batch->SW_Run_Infil[i] = Water_input * step_time - batch->SW_Infiltration[i];
+            }
+            else
+            {
+                batch->SW_Run_Infil[i] = 0.0;
+            }
+        }
+        else
+        {
+            batch->SW_Infiltration[i] = 0.0;
+            batch->SW_Run_Infil[i] = 0.0;
+        }
+        batch->SW_Percolation_Upper[i] = Percolation(
+            batch->SM[i], batch->SW_Infiltration[i], Soil_d1,
+            soil->Porosity_upper, soil->Residual_upper, soil->Ksat_upper, soil->BC_exp_upper,
+            step_time);
+        batch->SW_Percolation_Lower[i] = Percolation(
+            batch->SM_lower[i], batch->SW_Percolation_Upper[i], Soil_d2,
+            soil->Porosity_lower, soil->Residual_lower, soil->Ksat_lower, soil->BC_exp_lower,
+            step_time);
+
+        /* upper soil layer */
+        SM_d = batch->SM[i] * Soil_d1 + batch->SW_Infiltration[i] - batch->SW_Percolation_Upper[i] -
+               ((under == 1) ? batch->ET_u[i] : batch->ET_s[i]) + batch->SW_rise_upper[i];
+        if (over == 1)
+        {
+            SM_d = SM_d - batch->ET_o[i];
+        }
+        if (SM_d >= 0.0)
+        {
+            ET_o_lowersoil = 0.0;
+            SM_buff = SM_d / Soil_d1;
+        }
+        else
+        {
+            ET_o_lowersoil = - SM_d;
+            SM_buff = 0.0;
+        }
+        batch->SW_Run_Satur[i] = 0.0;
+        if (SM_buff > soil->Porosity_upper)
+        {
+            batch->SW_Run_Satur[i] += (SM_buff - soil->Porosity_upper) * Soil_d1;
+            batch->SM[i] = soil->Porosity_upper;
+        }
+        else
+        {
+            batch->SM[i] = SM_buff;
+        }
+
+        /* lower soil layer */
+        SM_d = batch->SM_lower[i] * Soil_d2 + batch->SW_Percolation_Upper[i] - batch->SW_Percolation_Lower[i] -
+               ET_o_lowersoil + batch->SW_rise_lower[i];
+        SM_buff = (SM_d >= 0.0) ? SM_d / Soil_d2 : 0.0;
+        if (SM_buff > soil->Porosity_lower)
+        {
+            batch->SW_Run_Satur[i] += (SM_buff - soil->Porosity_lower) * Soil_d2;
+            batch->SM_lower[i] = soil->Porosity_lower;
+        }
+        else
+        {
+            batch->SM_lower[i] = SM_buff;
+        }
+    }
+}
+
+/* the kernel of a kind: the stories compiled in as constants */
+#define ET_BATCH_KIND(NAME, OVER, UNDER)                  \
+    static void NAME(ET_BATCH *batch, int step_time)      \
+    {                                                     \
+        ET_Batch_Kernel(batch, OVER, UNDER, step_time);   \
+        ET_Batch_Unsat(batch, OVER, UNDER, step_time);    \
+    }
+
+ET_BATCH_KIND(ET_Batch_Kind_OU, 1, 1)
+ET_BATCH_KIND(ET_Batch_Kind_O, 1, 0)
+ET_BATCH_KIND(ET_Batch_Kind_U, 0, 1)
+ET_BATCH_KIND(ET_Batch_Kind_S, 0, 0)
+
+static void ET_Batch_Cell(
+    ET_BATCH *batch,
+    int i,
+    int step_time
+)
+{
+    /* ET_CELL() and UnsaturatedWaterMove() on cell i of the batch */
+    ET_CELL(
+        batch->astro + i,
+        batch->Prec[i], batch->Tem_avg[i], batch->Tem_min[i], batch->Tem_max[i],
+        batch->Rhu[i], batch->Prs[i], batch->Win[i], batch->Ssd[i],
+        batch->Rs + i, batch->L_sky + i,
+        batch->Rno + i, batch->Rno_short + i,
+        batch->Rnu + i, batch->Rnu_short + i,
+        batch->Rns + i,
+        batch->Frac[i],
+        batch->Ref_o[i], batch->Ref_u[i], ALBEDO_SOIL,
+        batch->LAI_o[i], batch->LAI_u[i],
+        batch->Rpc[i], batch->rs_min[i], RS_MAX,
+        batch->Rpc[i], batch->rs_min[i], RS_MAX,
+        batch->aero + i,
+        batch->SM[i], batch->SM_wp[i], batch->SM_free[i], batch->Soil_Fe[i],
+        batch->Prec_throughfall + i, batch->Prec_net + i,
+        batch->Ep + i,
+        batch->EI_o + i, batch->ET_o + i, batch->EI_u + i, batch->ET_u + i, batch->ET_s + i,
+        batch->Interception_o + i, batch->Interception_u + i,
+        batch->Understory[i],
+        step_time);
+    UnsaturatedWaterMove(
+        batch->Prec_net[i] / step_time,
+        batch->ET_o[i], batch->ET_u[i], batch->ET_s[i],
+        batch->SM + i, batch->SM_lower + i,
+        batch->SW_Infiltration + i, batch->SW_Percolation_Upper + i, batch->SW_Percolation_Lower + i,
+        batch->SW_rise_lower[i], batch->SW_rise_upper[i],
+        batch->SW_Run_Infil + i, batch->SW_Run_Satur + i,
+        batch->Soil_d1, batch->Soil_d2,
+        batch->soil[i],
+        step_time);
+}
+
+void ET_Batch_Run(
+    ET_BATCH *batch,
+    int step_time
+)
+{
+    switch (batch->kind)
+    {
+    case ET_KIND_OU:
+        ET_Batch_Kind_OU(batch, step_time);
+        break;
+    case ET_KIND_O:
+        ET_Batch_Kind_O(batch, step_time);
+        break;
+    case ET_KIND_U:
+        ET_Batch_Kind_U(batch, step_time);
+        break;
+    case ET_KIND_S:
+        ET_Batch_Kind_S(batch, step_time);
+        break;
+    default:
+        // ET_KIND_MIX: the overstory is on for the radiation but off for the ET
+        for (int i = 0; i < batch->n; i++)
+        {
+            ET_Batch_Cell(batch, i, step_time);
+        }
+        break;
+    }
+}
+
+void ET_Batch_Scatter(
+    ET_BATCH *batch,
+    ET_BATCH_PLAN *plan,
+    int b,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL
+)
+{
+    int i, index_geo;
+    int c_begin = *(plan->batch_start + b);
+    for (i = 0; i < batch->n; i++)
+    {
+        index_geo = *(plan->cell_index + c_begin + i);
+        *(data_RADIA->Rs + index_geo) = batch->Rs[i];
+        *(data_RADIA->L_sky + index_geo) = batch->L_sky[i];
+        *(data_RADIA->Rno + index_geo) = batch->Rno[i];
+        *(data_RADIA->Rno_short + index_geo) = batch->Rno_short[i];
+        *(data_RADIA->Rnu + index_geo) = batch->Rnu[i];
+        *(data_RADIA->Rnu_short + index_geo) = batch->Rnu_short[i];
+        *(data_RADIA->Rns + index_geo) = batch->Rns[i];
+        *(data_ET->Prec_throughfall + index_geo) = batch->Prec_throughfall[i];
+        *(data_ET->Prec_net + index_geo) = batch->Prec_net[i];
+        *(data_ET->Ep + index_geo) = batch->Ep[i];
+        *(data_ET->EI_o + index_geo) = batch->EI_o[i];
+        *(data_ET->ET_o + index_geo) = batch->ET_o[i];
+        *(data_ET->EI_u + index_geo) = batch->EI_u[i];
+        *(data_ET->ET_u + index_geo) = batch->ET_u[i];
+        *(data_ET->ET_s + index_geo) = batch->ET_s[i];
+        *(data_ET->Interception_o + index_geo) = batch->Interception_o[i];
+        *(data_ET->Interception_u + index_geo) = batch->Interception_u[i];
+        *(data_SOIL->SM_Upper + index_geo) = batch->SM[i];
+        *(data_SOIL->SM_Lower + index_geo) = batch->SM_lower[i];
+        *(data_SOIL->SW_Infiltration + index_geo) = batch->SW_Infiltration[i];
+        *(data_SOIL->SW_Percolation_Upper + index_geo) = batch->SW_Percolation_Upper[i];
+        *(data_SOIL->SW_Percolation_Lower + index_geo) = batch->SW_Percolation_Lower[i];
+        *(data_SOIL->SW_SR_Infil + index_geo) = batch->SW_Run_Infil[i];
+        *(data_SOIL->SW_SR_Satur + index_geo) = batch->SW_Run_Satur[i];
+    }
+}
+
+int ET_Batch_Check(
+    ET_BATCH *batch,
+    ET_BATCH *batch_in,
+    int step_time
+)
+{
+    /******
+     * the reference: ET_CELL() and UnsaturatedWaterMove() on every cell of batch_in
+     * (the batch as gathered, before ET_Batch_Run()), compared bit for bit with
+     * the outputs and states of batch; returns the number of cells that differ
+     */
+    int i, diff = 0;
+    double *out[24], *ref[24];
+    for (i = 0; i < batch_in->n; i++)
+    {
+        ET_Batch_Cell(batch_in, i, step_time);
+    }
+    out[0] = batch->Rs; out[1] = batch->L_sky; out[2] = batch->Rno; out[3] = batch->Rno_short;
+    out[4] = batch->Rnu; out[5] = batch->Rnu_short; out[6] = batch->Rns;
+    out[7] = batch->Prec_throughfall; out[8] = batch->Prec_net; out[9] = batch->Ep;
+    out[10] = batch->EI_o; out[11] = batch->ET_o; out[12] = batch->EI_u; out[13] = batch->ET_u;
+    out[14] = batch->ET_s; out[15] = batch->Interception_o; out[16] = batch->Interception_u;
+    out[17] = batch->SM; out[18] = batch->SM_lower; out[19] = batch->SW_Infiltration;
+    out[20] = batch->SW_Percolation_Upper; out[21] = batch->SW_Percolation_Lower;
+    out[22] = batch->SW_Run_Infil; out[23] = batch->SW_Run_Satur;
+    ref[0] = batch_in->Rs; ref[1] = batch_in->L_sky; ref[2] = batch_in->Rno; ref[3] = batch_in->Rno_short;
+    ref[4] = batch_in->Rnu; ref[5] = batch_in->Rnu_short; ref[6] = batch_in->Rns;
+    ref[7] = batch_in->Prec_throughfall; ref[8] = batch_in->Prec_net; ref[9] = batch_in->Ep;
+    ref[10] = batch_in->EI_o; ref[11] = batch_in->ET_o; ref[12] = batch_in->EI_u; ref[13] = batch_in->ET_u;
+    ref[14] = batch_in->ET_s; ref[15] = batch_in->Interception_o; ref[16] = batch_in->Interception_u;
+    ref[17] = batch_in->SM; ref[18] = batch_in->SM_lower; ref[19] = batch_in->SW_Infiltration;
+    ref[20] = batch_in->SW_Percolation_Upper; ref[21] = batch_in->SW_Percolation_Lower;
+    ref[22] = batch_in->SW_Run_Infil; ref[23] = batch_in->SW_Run_Satur;
+    for (i = 0; i < batch->n; i++)
+    {
+        for (int v = 0; v < 24; v++)
+        {
+            if (memcmp(out[v] + i, ref[v] + i, sizeof(double)) != 0)
+            {
+                diff++;
+                break;
+            }
+        }
+    }
+    return diff;
+}
+
+void ET_Batch_Step(
+    ET_BATCH_PLAN *plan,
+    int et_kernel,
+    int *data_forcing[],
+    double scale_forcing[],
+    RADIA_ASTRO *radia_astro,
+    int ncols,
+    ST_CELL_VEG *cell_veg,
+    ST_VEG_CLASS *veg_table,
+    int i_m,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_d1,
+    double Soil_d2,
+    int step_time,
+    long *check_diff
+)
+{
+    /******
+     * the evapotranspiration and unsaturated zone of all the active cells at a step,
+     * batch by batch; the batches write disjoint cells, they are distributed over the threads
+     */
+    long diff = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:diff)
+#endif
+    for (int b = 0; b < plan->batch_count; b++)
+    {
+        ET_BATCH batch;
+        ET_BATCH batch_in;
+        ET_Batch_Gather(
+            &batch, plan, b,
+            data_forcing, scale_forcing, radia_astro, ncols,
+            cell_veg, veg_table, i_m,
+            data_RADIA, data_ET, data_SOIL, soil_para, Soil_d1, Soil_d2, step_time);
+        if (et_kernel == ET_KERNEL_CHECK)
+        {
+            batch_in = batch;
+        }
+        ET_Batch_Run(&batch, step_time);
+        if (et_kernel == ET_KERNEL_CHECK)
+        {
+            diff += ET_Batch_Check(&batch, &batch_in, step_time);
+        }
+        ET_Batch_Scatter(&batch, plan, b, data_RADIA, data_ET, data_SOIL);
+    }
+    *check_diff += diff;
+}
@@ -0,0 +1,169 @@
+#ifndef ET_BATCH_H
+#define ET_BATCH_H
+
+#include "HM_ST.h"
+#include "Radiation_Calc.h"
+#include "Evapotranspiration_ST.h"
+#include "Lookup_SoilLib.h"
+
+/* ET_KERNEL: the evapotranspiration and the unsaturated zone of the active cells in the time loop */
+#define ET_KERNEL_SCALAR 0   // ET_CELL() and UnsaturatedWaterMove(), cell by cell: the reference
+#define ET_KERNEL_BATCH 1    // ET_Batch_Run(), batches of cells of one kind, see ET_Batch_Step()
+#define ET_KERNEL_CHECK 2    // ET_KERNEL_BATCH, every cell compared with the reference bit for bit
+
+/* the kind of a cell: the stories, as resolved inside ET_CELL() and ET_iteration() */
+#define ET_KIND_OU 0     // overstory (CAN_FRAC >= 0.001) and understory
+#define ET_KIND_O 1      // overstory above bare soil
+#define ET_KIND_U 2      // understory only (CAN_FRAC < 0.0001)
+#define ET_KIND_S 3      // bare soil
+#define ET_KIND_MIX 4    // CAN_FRAC in [0.0001, 0.001): overstory radiation without overstory ET, left to ET_CELL()
+#define ET_KIND_COUNT 5
+#define ET_BATCH_SIZE 64 // the most cells per batch
+
+typedef struct
+{
+    /******
+     * the active cells sorted by kind and cut into batches of
+     * at most ET_BATCH_SIZE cells of the same kind;
+     * built once by ET_Batch_Plan()
+     */
+    int cell_count;
+    int *cell_index;    /* 1D raster index of the active cells, sorted by kind, row-major order within a kind */
+    int kind_start[ET_KIND_COUNT + 1];  /* the cells of kind k: cell_index[kind_start[k]], ..., cell_index[kind_start[k + 1] - 1] */
+    int batch_count;
+    int *batch_start;   /* the cells of batch b: cell_index[batch_start[b]], ..., cell_index[batch_start[b + 1] - 1] */
+    int *batch_kind;
+} ET_BATCH_PLAN;
+
+typedef struct
+{
+    /******
+     * the inputs, states and outputs of the cells of a batch,
+     * contiguous over the cells (structure of arrays), see ET_CELL() for the units
+     */
+    int n;
+    int kind;
+    /* weather forcing and radiation terms */
+    RADIA_ASTRO astro[ET_BATCH_SIZE];
+    double Prec[ET_BATCH_SIZE];
+    double Tem_avg[ET_BATCH_SIZE];
+    double Tem_min[ET_BATCH_SIZE];
+    double Tem_max[ET_BATCH_SIZE];
+    double Rhu[ET_BATCH_SIZE];
+    double Prs[ET_BATCH_SIZE];
+    double Win[ET_BATCH_SIZE];
+    double Ssd[ET_BATCH_SIZE];
+    /* vegetation of the class and month, see Lookup_VegLib_Table() */
+    double Frac[ET_BATCH_SIZE];
+    double Ref_o[ET_BATCH_SIZE];
+    double Ref_u[ET_BATCH_SIZE];
+    double LAI_o[ET_BATCH_SIZE];
+    double LAI_u[ET_BATCH_SIZE];
+    double Rpc[ET_BATCH_SIZE];
+    double Tau_o[ET_BATCH_SIZE];
+    double Tau_u[ET_BATCH_SIZE];
+    double rs_min[ET_BATCH_SIZE];   // both stories, as the scalar call in the cell loop
+    int Understory[ET_BATCH_SIZE];
+    ST_AERO_PRE aero[ET_BATCH_SIZE];
+    /* soil */
+    ST_SOIL_PARA_CELL *soil[ET_BATCH_SIZE];
+    double Soil_d1;                 // the thickness of the upper soil layer, [m]
+    double Soil_d2;                 // the thickness of the lower soil layer, [m]
+    double SM_wp[ET_BATCH_SIZE];
+    double SM_free[ET_BATCH_SIZE];
+    double Soil_Fe[ET_BATCH_SIZE];
+    double SW_rise_upper[ET_BATCH_SIZE];
+    double SW_rise_lower[ET_BATCH_SIZE];
+    /* states, updated */
+    double Interception_o[ET_BATCH_SIZE];
+    double Interception_u[ET_BATCH_SIZE];
+    double SM[ET_BATCH_SIZE];       // the soil moisture of the upper layer
+    double SM_lower[ET_BATCH_SIZE];
+    /* outputs; Rnu and Rnu_short are kept as they are without understory, as in Radiation_net() */
+    double Rs[ET_BATCH_SIZE];
+    double L_sky[ET_BATCH_SIZE];
+    double Rno[ET_BATCH_SIZE];
+    double Rno_short[ET_BATCH_SIZE];
+    double Rnu[ET_BATCH_SIZE];
+    double Rnu_short[ET_BATCH_SIZE];
+    double Rns[ET_BATCH_SIZE];
+    double Prec_throughfall[ET_BATCH_SIZE];
+    double Prec_net[ET_BATCH_SIZE];
+    double Ep[ET_BATCH_SIZE];
+    double EI_o[ET_BATCH_SIZE];
+    double ET_o[ET_BATCH_SIZE];
+    double EI_u[ET_BATCH_SIZE];
+    double ET_u[ET_BATCH_SIZE];
+    double ET_s[ET_BATCH_SIZE];
+    double SW_Infiltration[ET_BATCH_SIZE];
+    double SW_Percolation_Upper[ET_BATCH_SIZE];
+    double SW_Percolation_Lower[ET_BATCH_SIZE];
+    double SW_Run_Infil[ET_BATCH_SIZE];
+    double SW_Run_Satur[ET_BATCH_SIZE];
+} ET_BATCH;
+
+void ET_Batch_Plan(
+    ET_BATCH_PLAN *plan,
+    CELL_LIST *cell_list,
+    ST_CELL_VEG *cell_veg,
+    ST_VEG_CLASS *veg_table);
+
+void ET_Batch_Free(
+    ET_BATCH_PLAN *plan);
+
+void ET_Batch_Gather(
+    ET_BATCH *batch,
+    ET_BATCH_PLAN *plan,
+    int b,
+    int *data_forcing[],
+    double scale_forcing[],
+    RADIA_ASTRO *radia_astro,
+    int ncols,
+    ST_CELL_VEG *cell_veg,
+    ST_VEG_CLASS *veg_table,
+    int i_m,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_d1,
+    double Soil_d2,
+    int step_time);
+
+void ET_Batch_Run(
+    ET_BATCH *batch,
+    int step_time);
+
+void ET_Batch_Scatter(
+    ET_BATCH *batch,
+    ET_BATCH_PLAN *plan,
+    int b,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL);
+
+int ET_Batch_Check(
+    ET_BATCH *batch,
+    ET_BATCH *batch_in,
+    int step_time);
+
+void ET_Batch_Step(
+    ET_BATCH_PLAN *plan,
+    int et_kernel,
+    int *data_forcing[],
+    double scale_forcing[],
+    RADIA_ASTRO *radia_astro,
+    int ncols,
+    ST_CELL_VEG *cell_veg,
+    ST_VEG_CLASS *veg_table,
+    int i_m,
+    CELL_VAR_RADIA *data_RADIA,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_d1,
+    double Soil_d2,
+    int step_time,
+    long *check_diff);
+
+#endif
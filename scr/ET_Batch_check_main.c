@@ -0,0 +1,254 @@
+/*
+ * SUMMARY:      ET_Batch_check_main.c
+ * USAGE:        ET_BATCH_CHECK VegeLib.txt SOIL_LIB.txt [seed]
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  Fuzz check of the batched evapotranspiration (ET_Batch.c)
+ *               against ET_CELL() and UnsaturatedWaterMove()
+ * DESCRIP-END.
+ * FUNCTIONS:    main(); Check_Rand(); Check_Uniform(); Check_Run()
+ * COMMENTS:
+ * A raster of CHECK_NROWS x CHECK_NCOLS random cells: every vegetation class,
+ * canopy fractions of all the kinds (0, within [0.0001, 0.001) and at the
+ * limits between the kinds included), random soil textures of the upper and
+ * lower layer, the weather forcing drawn as the integers of the forcing nc
+ * files (scale factors of Weather2NC_main.c), random soil moisture and
+ * interception, and rows of different latitude. ET_Batch_Step() runs with
+ * ET_KERNEL_CHECK over CHECK_STEPS steps through the months, daily and hourly,
+ * the states carried over from step to step; every cell and step is compared
+ * with the reference bit for bit (ET_Batch_Check()).
+ * The exit status is 0 if no cell differs, 1 otherwise (ctest: et_batch_check).
+ *
+ */
+
+/*********************************************************
+ * VARIABLEs:
+ * unsigned long long *state    - the state of the random generator
+ * int step_time                - the time step, [h]: 24 or 1
+ * ST_CELL_VEG *cell_veg        - the random vegetation class and canopy fraction of the cells
+ * ST_SOIL_PARA_CELL *soil_para - the soil parameters of the random textures
+ * long check_diff              - the cell steps differing from the reference
+ *
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Constants.h"
+#include "HM_ST.h"
+#include "Forcing_Reader.h"
+#include "Radiation_Calc.h"
+#include "Evapotranspiration_ST.h"
+#include "Lookup_VegLib.h"
+#include "Lookup_SoilLib.h"
+#include "Initial_VAR.h"
+#include "ET_Batch.h"
+
+#define CHECK_NROWS 40
+#define CHECK_NCOLS 50
+#define CHECK_STEPS 36
+
+double Check_Uniform(
+    unsigned long long *state
+);
+
+int Check_Rand(
+    unsigned long long *state,
+    int lo,
+    int hi
+);
+
+long Check_Run(
+    int step_time,
+    unsigned long long seed,
+    ST_VEG_CLASS *veg_table,
+    ST_SoilLib soillib[]
+);
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("usage: ET_BATCH_CHECK VegeLib.txt SOIL_LIB.txt [seed]\n");
+        exit(0);
+    }
+    unsigned long long seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : 20261017ULL;
+
+    ST_VegLib veglib[11];
+    ST_VEG_CLASS veg_table[VEG_CLASS_COUNT * 12];
+    ST_SoilLib soillib[13];
+    Import_veglib(argv[1], veglib);
+    Import_soillib(argv[2], soillib);
+    Lookup_VegLib_Table(veglib, 10.0, veg_table);
+
+    long check_diff = 0;
+    printf("* ET_BATCH_CHECK, seed %llu\n", seed);
+    check_diff += Check_Run(24, seed, veg_table, soillib);
+    check_diff += Check_Run(1, seed + 1, veg_table, soillib);
+    return (check_diff > 0) ? 1 : 0;
+}
+
+double Check_Uniform(
+    unsigned long long *state
+)
+{
+    /* in [0, 1): a 64-bit linear congruential generator, the same sequence on every platform */
+    *state = (*state * 6364136223846793005ULL + 1442695040888963407ULL) & 0xFFFFFFFFFFFFFFFFULL;
+    return (double)((*state >> 11) & 0x1FFFFFFFFFFFFFULL) / 9007199254740992.0;
+}
+
+int Check_Rand(
+    unsigned long long *state,
+    int lo,
+    int hi
+)
+{
+    /* in [lo, hi] */
+    return lo + (int)(Check_Uniform(state) * (hi - lo + 1));
+}
+
+long Check_Run(
+    int step_time,
+    unsigned long long seed,
+    ST_VEG_CLASS *veg_table,
+    ST_SoilLib soillib[]
+)
+{
+    /* the canopy fractions at and around the limits of the kinds, see ET_BATCH_KIND */
+    double frac_limits[6] = {0.0, 0.00005, 0.0001, 0.0005, 0.001, 1.0};
+    int cell_counts_total = CHECK_NROWS * CHECK_NCOLS;
+    unsigned long long state = seed;
+    int i, v, t;
+
+    int *data_DEM, *data_SOILTYPE, *data_STR;
+    int *data_forcing[FORCING_VARS];
+    ST_CELL_VEG *cell_veg;
+    ST_SOIL_PARA_CELL *soil_para;
+    ST_SOIL_LIB_CELL cell_soil;
+    RADIA_ASTRO radia_astro[CHECK_NROWS];
+    double data_lat[CHECK_NROWS];
+    data_DEM = (int *)malloc(sizeof(int) * cell_counts_total);
+    data_SOILTYPE = (int *)malloc(sizeof(int) * cell_counts_total);
+    data_STR = (int *)malloc(sizeof(int) * cell_counts_total);
+    cell_veg = (ST_CELL_VEG *)malloc(sizeof(ST_CELL_VEG) * cell_counts_total);
+    soil_para = (ST_SOIL_PARA_CELL *)malloc(sizeof(ST_SOIL_PARA_CELL) * cell_counts_total);
+    if (data_DEM == NULL || data_SOILTYPE == NULL || data_STR == NULL || cell_veg == NULL || soil_para == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (v = 0; v < FORCING_VARS; v++)
+    {
+        data_forcing[v] = (int *)malloc(sizeof(int) * cell_counts_total);
+        if (data_forcing[v] == NULL)
+        {
+            printf("memory allocation failed!\n");
+            exit(-3);
+        }
+    }
+    double scale_forcing[FORCING_VARS];
+    scale_forcing[FORCING_PRE] = 0.1;
+    scale_forcing[FORCING_PRS] = 1.0;
+    scale_forcing[FORCING_SSD] = 0.1;
+    scale_forcing[FORCING_RHU] = 1.0;
+    scale_forcing[FORCING_WIN] = 0.1;
+    scale_forcing[FORCING_TEM_AVG] = 0.1;
+    scale_forcing[FORCING_TEM_MAX] = 0.1;
+    scale_forcing[FORCING_TEM_MIN] = 0.1;
+
+    /* the cells: a tenth of them without DEM (NODATA), the others active */
+    for (i = 0; i < cell_counts_total; i++)
+    {
+        *(data_DEM + i) = (Check_Uniform(&state) < 0.1) ? -9999 : 100;
+        *(data_SOILTYPE + i) = (*(data_DEM + i) == -9999) ? -9999 : 1;
+        *(data_STR + i) = 0;
+        (cell_veg + i)->CLASS = Check_Rand(&state, 0, VEG_CLASS_COUNT - 1);
+        if (Check_Uniform(&state) < 0.5)
+        {
+            (cell_veg + i)->CAN_FRAC = frac_limits[Check_Rand(&state, 0, 5)];
+        }
+        else
+        {
+            (cell_veg + i)->CAN_FRAC = Check_Uniform(&state);
+        }
+        cell_soil.Topsoil = soillib + Check_Rand(&state, 0, 12);
+        cell_soil.Subsoil = soillib + Check_Rand(&state, 0, 12);
+        Derive_Soil_Para_CELL(&cell_soil, soil_para + i);
+    }
+    for (i = 0; i < CHECK_NROWS; i++)
+    {
+        data_lat[i] = -60.0 + 130.0 * i / (CHECK_NROWS - 1);
+    }
+    CELL_LIST cell_list;
+    Initialize_CELL_LIST(&cell_list, data_DEM, data_SOILTYPE, data_STR, -9999, CHECK_NCOLS, CHECK_NROWS);
+
+    /* the states, carried over from step to step */
+    CELL_VAR_RADIA data_RADIA;
+    CELL_VAR_ET data_ET;
+    CELL_VAR_SOIL data_SOIL;
+    Allocate_RADIA(&data_RADIA, cell_counts_total);
+    Allocate_ET(&data_ET, cell_counts_total);
+    Allocate_SOIL(&data_SOIL, cell_counts_total);
+    Initialize_RADIA(&data_RADIA, cell_counts_total);
+    Initialize_ET(&data_ET, cell_counts_total);
+    Initialize_SOIL(&data_SOIL, cell_counts_total);
+    for (i = 0; i < cell_counts_total; i++)
+    {
+        *(data_SOIL.SM_Upper + i) = (soil_para + i)->Residual_upper +
+            Check_Uniform(&state) * ((soil_para + i)->Porosity_upper - (soil_para + i)->Residual_upper);
+        *(data_SOIL.SM_Lower + i) = (soil_para + i)->Residual_lower +
+            Check_Uniform(&state) * ((soil_para + i)->Porosity_lower - (soil_para + i)->Residual_lower);
+        *(data_ET.Interception_o + i) = Check_Uniform(&state) * 0.0005;
+        *(data_ET.Interception_u + i) = Check_Uniform(&state) * 0.0005;
+    }
+
+    ET_BATCH_PLAN plan;
+    ET_Batch_Plan(&plan, &cell_list, cell_veg, veg_table);
+
+    long check_diff = 0;
+    int month, day, tem_avg;
+    for (t = 0; t < CHECK_STEPS; t++)
+    {
+        month = t % 12 + 1;
+        day = Check_Rand(&state, 1, 28);
+        Radiation_Astro_Rows(2003, month, day, data_lat, CHECK_NROWS, radia_astro);
+        for (i = 0; i < cell_counts_total; i++)
+        {
+            /* dry about half of the cells, heavy rain at some */
+            *(data_forcing[FORCING_PRE] + i) = (Check_Uniform(&state) < 0.5) ? 0 : Check_Rand(&state, 1, (step_time == 24) ? 800 : 200);
+            *(data_forcing[FORCING_PRS] + i) = Check_Rand(&state, 60, 103);
+            *(data_forcing[FORCING_SSD] + i) = Check_Rand(&state, 0, step_time == 24 ? 140 : 10);
+            *(data_forcing[FORCING_RHU] + i) = Check_Rand(&state, 10, 100);
+            *(data_forcing[FORCING_WIN] + i) = Check_Rand(&state, 0, 150);
+            tem_avg = Check_Rand(&state, -250, 350);
+            *(data_forcing[FORCING_TEM_AVG] + i) = tem_avg;
+            *(data_forcing[FORCING_TEM_MAX] + i) = tem_avg + Check_Rand(&state, 0, 120);
+            *(data_forcing[FORCING_TEM_MIN] + i) = tem_avg - Check_Rand(&state, 0, 120);
+            *(data_SOIL.SW_rise_upper + i) = (Check_Uniform(&state) < 0.5) ? 0.0 : Check_Uniform(&state) * 0.01;
+            *(data_SOIL.SW_rise_lower + i) = (Check_Uniform(&state) < 0.5) ? 0.0 : Check_Uniform(&state) * 0.01;
+        }
+        ET_Batch_Step(
+            &plan, ET_KERNEL_CHECK,
+            data_forcing, scale_forcing, radia_astro, CHECK_NCOLS,
+            cell_veg, veg_table, month - 1,
+            &data_RADIA, &data_ET, &data_SOIL, soil_para, 0.2, 0.2,
+            step_time, &check_diff);
+    }
+
+    printf("* step_time %2d: %ld of %ld cell steps differ from ET_CELL() and UnsaturatedWaterMove()\n",
+           step_time, check_diff, (long)cell_list.cell_count * CHECK_STEPS);
+
+    ET_Batch_Free(&plan);
+    Free_RADIA(&data_RADIA); Free_ET(&data_ET); Free_SOIL(&data_SOIL);
+    for (v = 0; v < FORCING_VARS; v++)
+    {
+        free(data_forcing[v]);
+    }
+    free(data_DEM); free(data_SOILTYPE); free(data_STR);
+    free(cell_veg); free(soil_para);
+    free(cell_list.cell_index); free(cell_list.stream_index);
+    return check_diff;
+}
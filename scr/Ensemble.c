@@ -0,0 +1,919 @@
+/*
+ * SUMMARY:      Ensemble.c
+ * USAGE:        parameter ensemble: many parameter sets in one process
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the M parameter sets (members) of the table FP_ENSEMBLE are simulated
+ *               side by side: the GEO data, the soil and vegetation libraries and
+ *               the UH are read once, each forcing step is read once and all the
+ *               member states are advanced through it; each member has its own
+ *               state and writes only the discharge at the outlets
+ * DESCRIP-END.
+ * FUNCTIONS:    Ensemble_Para_Field(); Ensemble_Para_Index(); Ensemble_Para_Name();
+ *               Ensemble_Para_Default(); Ensemble_Import(); Ensemble_UH_Base(); Ensemble_State_Load();
+ *               Ensemble_Allocate();
+ *               Ensemble_Reset(); Ensemble_Step(); Ensemble_Forcing_Load(); Ensemble_Run();
+ *               Ensemble_Write_Qout(); Ensemble_Free()
+ *
+ * COMMENTS:
+ * - Ensemble_Para_*():      the member parameters by position and name, the defaults from GLOBAL_PARA
+ * - Ensemble_Import():      read the parameter table
+ * - Ensemble_UH_Base():     the GEO-derived maps for the UH of other velocities
+ * - Ensemble_State_Load():  read the initial state FP_STATE_IN once for all the members
+ * - Ensemble_Allocate():    allocate the state of a member
+ * - Ensemble_Reset():       the initial state and the UH of a member, for its parameter set
+ * - Ensemble_Step():        advance a member by one step
+ * - Ensemble_Forcing_Load(): read the forcing of the whole period into memory
+ * - Ensemble_Run():         simulate all the members over the simulation period
+ * - Ensemble_Write_Qout():  write the outlet discharge of all the members
+ * - Ensemble_Free():        free the members
+ *
+ * FP_ENSEMBLE is a comma-separated table: a header line with the parameter names
+ * (any of SOIL_D, SOIL_d1, SOIL_d2, ROUTE_CHANNEL_k, STREAM_D, STREAM_W,
+ * Velocity_avg, Velocity_max, Velocity_min), then one line per member;
+ * lines starting with # are skipped.
+ * The members run in parallel (OpenMP), the cell loops of one member serially.
+ * The surface runoff is routed at every step (as UH_MODE STREAM) with the sparse
+ * UH of FP_UH (ENSEMBLE_DATA.uh_sparse), or, for members of other velocities,
+ * with the sparse UH built in memory.
+ * A member with a CALIB_EVAL (calibration) is scored during the run and no longer
+ * simulated once aborted, see Calib_Eval_Step(); the run ends when all are aborted.
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * char FP[]                        - file path of the parameter table (FP_ENSEMBLE)
+ * GLOBAL_PARA *GP                  - the global parameters, the defaults of the members
+ * ENSEMBLE_PARA *para              - the parameter sets of the members
+ * ENSEMBLE_DATA *ens               - the data shared by the members, see "Ensemble.h"
+ * ENSEMBLE_MEMBER *member          - the state and outlet discharge of the members
+ * int member_count                 - number of members, M
+ * int t                            - the simulation step
+ * int year, month, day             - the date of the step
+ * int **data_forcing               - the forcing maps of the step, see Forcing_Reader.h
+ * RADIA_ASTRO *radia_astro         - the astronomical radiation terms of the rows at the step, see Radiation_Astro()
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netcdf.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "Constants.h"
+#include "HM_ST.h"
+#include "Initial_VAR.h"
+#include "Evapotranspiration.h"
+#include "Soil_Desorption.h"
+#include "Soil_UnsaturatedMove.h"
+#include "Soil_SaturatedFlow.h"
+#include "Soil_SaturatedImplicit.h"
+#include "Route_Channel.h"
+#include "Route_Outlet.h"
+#include "UH_Generation.h"
+#include "UH_Routing.h"
+#include "State_IO.h"
+#include "NC_copy_global_att.h"
+#include "Ensemble.h"
+
+static char *para_name[ENSEMBLE_PARA_COUNT] = {
+    "SOIL_D", "SOIL_d1", "SOIL_d2", "ROUTE_CHANNEL_k", "STREAM_D", "STREAM_W",
+    "Velocity_avg", "Velocity_max", "Velocity_min"};
+
+double *Ensemble_Para_Field(
+    ENSEMBLE_PARA *para,
+    int k
+)
+{
+    /* the k-th parameter of a set, in the order of para_name */
+    double *field[ENSEMBLE_PARA_COUNT] = {
+        &para->SOIL_D, &para->SOIL_d1, &para->SOIL_d2, &para->ROUTE_CHANNEL_k, &para->STREAM_D, &para->STREAM_W,
+        &para->Velocity_avg, &para->Velocity_max, &para->Velocity_min};
+    return field[k];
+}
+
+int Ensemble_Para_Index(
+    char *name
+)
+{
+    /* the position of a parameter name in para_name; -1: not a member parameter */
+    for (int k = 0; k < ENSEMBLE_PARA_COUNT; k++)
+    {
+        if (strcmp(name, para_name[k]) == 0)
+        {
+            return k;
+        }
+    }
+    return -1;
+}
+
+char *Ensemble_Para_Name(
+    int k
+)
+{
+    return para_name[k];
+}
+
+void Ensemble_Para_Default(
+    GLOBAL_PARA *GP,
+    ENSEMBLE_PARA *para
+)
+{
+    /* the parameter set of the global parameter file */
+    para->SOIL_D = GP->SOIL_D;
+    para->SOIL_d1 = GP->SOIL_d1;
+    para->SOIL_d2 = GP->SOIL_d2;
+    para->ROUTE_CHANNEL_k = GP->ROUTE_CHANNEL_k;
+    para->STREAM_D = GP->STREAM_D;
+    para->STREAM_W = GP->STREAM_W;
+    para->Velocity_avg = GP->Velocity_avg;
+    para->Velocity_max = GP->Velocity_max;
+    para->Velocity_min = GP->Velocity_min;
+}
+
+int Ensemble_Import(
+    char FP[],
+    GLOBAL_PARA *GP,
+    ENSEMBLE_PARA **para
+)
+{
+    FILE *fp;
+    if ((fp = fopen(FP, "r")) == NULL)
+    {
+        printf("cannot open file %s\n", FP);
+        exit(0);
+    }
+    char row[MAXCHAR];
+    char *token;
+    int column[ENSEMBLE_PARA_COUNT];  // the parameter of each column of the table
+    int column_count = 0;
+    int member_count = 0;
+    int k;
+    ENSEMBLE_PARA para_default;
+    Ensemble_Para_Default(GP, &para_default);
+    *para = NULL;
+    while (fgets(row, MAXCHAR, fp) != NULL)
+    {
+        if (strlen(row) <= 1 || row[0] == '#')
+        {
+            continue;
+        }
+        if (column_count == 0)
+        {
+            /* the header line: parameter names */
+            token = strtok(row, ", \t\r\n");
+            while (token != NULL)
+            {
+                k = Ensemble_Para_Index(token);
+                if (k < 0 || column_count == ENSEMBLE_PARA_COUNT)
+                {
+                    printf("Unrecognized ensemble parameter in %s: %s\n", FP, token);
+                    exit(0);
+                }
+                column[column_count] = k;
+                column_count++;
+                token = strtok(NULL, ", \t\r\n");
+            }
+            continue;
+        }
+        *para = (ENSEMBLE_PARA *)realloc(*para, sizeof(ENSEMBLE_PARA) * (member_count + 1));
+        if (*para == NULL)
+        {
+            printf("memory allocation failed!\n");
+            exit(-3);
+        }
+        *(*para + member_count) = para_default;
+        token = strtok(row, ", \t\r\n");
+        for (int j = 0; j < column_count; j++)
+        {
+            if (token == NULL)
+            {
+                printf("Error: %s, member %d: %d values expected\n", FP, member_count, column_count);
+                exit(0);
+            }
+            *Ensemble_Para_Field(*para + member_count, column[j]) = atof(token);
+            token = strtok(NULL, ", \t\r\n");
+        }
+        member_count++;
+    }
+    fclose(fp);
+    if (member_count == 0)
+    {
+        printf("Error: no parameter set in %s\n", FP);
+        exit(0);
+    }
+    return member_count;
+}
+
+void Ensemble_UH_Base(
+    ENSEMBLE_DATA *ens
+)
+{
+    /******
+     * the velocity-independent steps of UH_Generation(): flow distance,
+     * slope-area term and the outlet masks, from FP_GEO
+     */
+    int ncols, nrows, NODATA_value;
+    int varID;
+    double *data_Slope;
+    ncols = ens->GEO_header.ncols;
+    nrows = ens->GEO_header.nrows;
+    NODATA_value = ens->GEO_header.NODATA_value;
+    data_Slope = (double *)malloc(sizeof(double) * ens->cell_counts_total);
+    ens->data_FlowDistance = (double *)malloc(sizeof(double) * ens->cell_counts_total);
+    ens->data_SlopeArea = (double *)malloc(sizeof(double) * ens->cell_counts_total);
+    ens->data_FAC = (int *)malloc(sizeof(int) * ens->cell_counts_total);
+    ens->data_Mask = (int *)malloc(sizeof(int) * ens->cell_counts_total * ens->outlet_count);
+    if (data_Slope == NULL || ens->data_FlowDistance == NULL || ens->data_SlopeArea == NULL ||
+        ens->data_FAC == NULL || ens->data_Mask == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    nc_inq_varid(ens->ncID_GEO, "FAC", &varID);
+    nc_get_var_int(ens->ncID_GEO, varID, ens->data_FAC);
+    Grid_Slope(ens->data_DEM, ens->data_FDR, data_Slope, ens->data_FlowDistance,
+               ncols, nrows, NODATA_value, ens->cellsize_m);
+    Grid_SlopeArea(ens->data_FAC, data_Slope, ens->data_SlopeArea,
+                   &ens->slope_area_avg, ens->GP->b, ens->GP->c,
+                   ncols, nrows, NODATA_value, ens->cellsize_m);
+    for (int s = 0; s < ens->outlet_count; s++)
+    {
+        Grid_OutletMask(*(ens->outlet_index_row + s), *(ens->outlet_index_col + s),
+                        ens->data_FDR,
+                        ens->data_Mask + s * ens->cell_counts_total,
+                        ncols, nrows, NODATA_value);
+    }
+    free(data_Slope);
+}
+
+void Ensemble_State_Load(
+    ENSEMBLE_DATA *ens
+)
+{
+    /******
+     * the initial state of FP_STATE_IN, copied to the members by Ensemble_Reset()
+     * instead of reading the file for every member (and every SCE-UA evaluation)
+     */
+    ens->state_in = 0;
+    if (strlen(ens->GP->FP_STATE_IN) == 0)
+    {
+        return;
+    }
+    Allocate_ET(&ens->state_ET, ens->cell_counts_total);
+    Allocate_SOIL(&ens->state_SOIL, ens->cell_counts_total);
+    ens->state_STREAM = (CELL_VAR_STREAM *)malloc(sizeof(CELL_VAR_STREAM) * ens->cell_counts_total);
+    if (ens->state_STREAM == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    State_Import(
+        ens->GP->FP_STATE_IN,
+        ens->ncID_GEO,
+        (long)ens->start_time,
+        &ens->state_ET,
+        &ens->state_SOIL,
+        ens->state_STREAM,
+        ens->cell_list,
+        ens->cell_counts_total,
+        ens->GEO_header.NODATA_value);
+    ens->state_in = 1;
+}
+
+static void Ensemble_UH_Build(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    UH_SPARSE *uh_sparse
+)
+{
+    /* the UH of the outlets for the velocities of a parameter set, as UH_Generation() */
+    int ncols, nrows, NODATA_value;
+    int UH_steps;
+    double *data_V;
+    double *data_FlowTime;
+    ncols = ens->GEO_header.ncols;
+    nrows = ens->GEO_header.nrows;
+    NODATA_value = ens->GEO_header.NODATA_value;
+    data_V = (double *)malloc(sizeof(double) * ens->cell_counts_total);
+    data_FlowTime = (double *)malloc(sizeof(double) * ens->cell_counts_total);
+    if (data_V == NULL || data_FlowTime == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    Grid_Velocity(ens->data_FAC, ens->data_SlopeArea, ens->slope_area_avg, data_V,
+                  para->Velocity_avg, para->Velocity_max, para->Velocity_min,
+                  ncols, nrows, NODATA_value);
+    for (int s = 0; s < ens->outlet_count; s++)
+    {
+        Grid_FlowTime(ens->data_Mask + s * ens->cell_counts_total, ens->data_FDR,
+                      data_V, ens->data_FlowDistance, data_FlowTime,
+                      *(ens->outlet_index_row + s), *(ens->outlet_index_col + s),
+                      ncols, nrows, NODATA_value);
+        Grid_UH(ens->data_Mask + s * ens->cell_counts_total, data_FlowTime,
+                uh_sparse + s, &UH_steps, UH_BETA, ens->GP->STEP_TIME,
+                ncols, nrows, NODATA_value);
+    }
+    free(data_V); free(data_FlowTime);
+}
+
+static int Ensemble_Same_Velocity(
+    ENSEMBLE_PARA *para1,
+    ENSEMBLE_PARA *para2
+)
+{
+    return FloatEqual(para1->Velocity_avg, para2->Velocity_avg) == 1 &&
+           FloatEqual(para1->Velocity_max, para2->Velocity_max) == 1 &&
+           FloatEqual(para1->Velocity_min, para2->Velocity_min) == 1;
+}
+
+void Ensemble_Allocate(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_MEMBER *member
+)
+{
+    Allocate_RADIA(&member->data_RADIA, ens->cell_counts_total);
+    Allocate_ET(&member->data_ET, ens->cell_counts_total);
+    Allocate_SOIL(&member->data_SOIL, ens->cell_counts_total);
+    member->data_STREAM = (CELL_VAR_STREAM *)malloc(sizeof(CELL_VAR_STREAM) * ens->cell_counts_total);
+    member->run_Infil = (int *)malloc(sizeof(int) * ens->cell_counts_total);
+    member->run_Satur = (int *)malloc(sizeof(int) * ens->cell_counts_total);
+    member->Qout_SF_Infil = (double *)malloc(sizeof(double) * ens->outlet_count * ens->time_steps_run);
+    member->Qout_SF_Satur = (double *)malloc(sizeof(double) * ens->outlet_count * ens->time_steps_run);
+    member->Qout_Sub = (double *)malloc(sizeof(double) * ens->outlet_count * ens->time_steps_run);
+    member->Qout_outlet = (double *)malloc(sizeof(double) * ens->outlet_count * ens->time_steps_run);
+    member->eval = NULL;
+    if (member->data_STREAM == NULL || member->run_Infil == NULL || member->run_Satur == NULL ||
+        member->Qout_SF_Infil == NULL || member->Qout_SF_Satur == NULL ||
+        member->Qout_Sub == NULL || member->Qout_outlet == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    if (ens->satu_solver == SATU_SOLVER_IMPLICIT)
+    {
+        Soil_Satu_System_Build(
+            &member->satu_system,
+            ens->cell_list->cell_index,
+            ens->cell_list->cell_count,
+            ens->data_NEIGHBOR,
+            ens->GEO_header.ncols,
+            ens->cell_counts_total,
+            ens->GP->SOIL_SATU_CG_TOL,
+            ens->GP->SOIL_SATU_CG_ITER);
+    }
+    member->uh_sparse = NULL;
+    member->uh_owner = 0;
+    member->UH_ring_Infil = NULL;
+    member->UH_ring_Satur = NULL;
+}
+
+void Ensemble_Reset(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int member_count
+)
+{
+    /******
+     * the initial state (as xHM_main.c) and the UH of the members, for their parameter sets;
+     * the members of equal velocities share one UH, those of the velocities
+     * of the global parameter file the UH of FP_UH
+     */
+    int UH_steps_total;
+    ENSEMBLE_MEMBER *m;
+    for (int k = 0; k < member_count; k++)
+    {
+        m = member + k;
+        Initialize_RADIA(&m->data_RADIA, ens->cell_counts_total);
+        Initialize_ET(&m->data_ET, ens->cell_counts_total);
+        Initialize_SOIL(&m->data_SOIL, ens->cell_counts_total);
+        Initialize_Soil_Satur(
+            &m->data_SOIL,
+            ens->data_NEIGHBOR,
+            ens->data_DEM,
+            ens->GEO_header.NODATA_value,
+            ens->GEO_header.ncols,
+            ens->GEO_header.nrows);
+        Initialize_STREAM(
+            &m->data_STREAM,
+            ens->data_STR,
+            ens->data_FDR,
+            (para + k)->ROUTE_CHANNEL_k,
+            ens->GEO_header.NODATA_value,
+            ens->GEO_header.ncols,
+            ens->GEO_header.nrows);
+        if (ens->state_in == 1)
+        {
+            State_Copy(
+                &ens->state_ET, &ens->state_SOIL, ens->state_STREAM,
+                &m->data_ET, &m->data_SOIL, m->data_STREAM,
+                ens->cell_list);
+        }
+        if (ens->satu_solver == SATU_SOLVER_IMPLICIT)
+        {
+            m->satu_system.iter_total = 0;
+            m->satu_system.picard_total = 0;
+            m->satu_system.solve_count = 0;
+            m->satu_system.fail_count = 0;
+        }
+
+        /* the UH */
+        if (m->uh_owner == 1)
+        {
+            for (int s = 0; s < ens->outlet_count; s++)
+            {
+                UH_Sparse_Free(m->uh_sparse + s);
+            }
+            free(m->uh_sparse);
+        }
+        m->uh_sparse = NULL;
+        m->uh_owner = 0;
+        ENSEMBLE_PARA para_UH;
+        Ensemble_Para_Default(ens->GP, &para_UH);
+        if (Ensemble_Same_Velocity(para + k, &para_UH) == 1)
+        {
+            m->uh_sparse = ens->uh_sparse;
+        }
+        for (int j = 0; j < k && m->uh_sparse == NULL; j++)
+        {
+            if (Ensemble_Same_Velocity(para + k, para + j) == 1)
+            {
+                m->uh_sparse = (member + j)->uh_sparse;
+            }
+        }
+        if (m->uh_sparse == NULL)
+        {
+            m->uh_sparse = (UH_SPARSE *)malloc(sizeof(UH_SPARSE) * ens->outlet_count);
+            if (m->uh_sparse == NULL)
+            {
+                printf("memory allocation failed!\n");
+                exit(-3);
+            }
+            Ensemble_UH_Build(ens, para + k, m->uh_sparse);
+            m->uh_owner = 1;
+        }
+        UH_steps_total = 0;
+        for (int s = 0; s < ens->outlet_count; s++)
+        {
+            UH_steps_total += (m->uh_sparse + s)->UH_steps;
+        }
+        free(m->UH_ring_Infil); free(m->UH_ring_Satur);
+        m->UH_ring_Infil = (double *)calloc(UH_steps_total, sizeof(double));
+        m->UH_ring_Satur = (double *)calloc(UH_steps_total, sizeof(double));
+        if (m->UH_ring_Infil == NULL || m->UH_ring_Satur == NULL)
+        {
+            printf("memory allocation failed!\n");
+            exit(-3);
+        }
+    }
+}
+
+void Ensemble_Step(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int t,
+    int month,
+    int **data_forcing,
+    RADIA_ASTRO *radia_astro
+)
+{
+    /******
+     * one step of a member: the cell processes, the saturated lateral flow,
+     * the channel routing and the outlet discharge, as the time loop of xHM_main.c
+     * without the output maps
+     */
+    GLOBAL_PARA *GP = ens->GP;
+    ST_VEG_CLASS *veg;
+    ST_SOIL_PARA_CELL *soil;
+    int index_geo;
+    int index_UH_ring;
+    int satu_substeps = 1;
+    int i_m = month - 1;
+    double Soil_Fe;
+    double cell_PRE, cell_WIN, cell_SSD, cell_RHU, cell_PRS, cell_TEM_AVG, cell_TEM_MAX, cell_TEM_MIN;
+    for (int c = 0; c < ens->cell_list->cell_count; c++)
+    {
+        index_geo = *(ens->cell_list->cell_index + c);
+        veg = ens->veg_table + (ens->cell_veg + index_geo)->CLASS * 12 + i_m;
+        soil = ens->soil_para + index_geo;
+        cell_PRE = *(data_forcing[FORCING_PRE] + index_geo) * ens->scale_forcing[FORCING_PRE] / 1000; // [m]
+        cell_PRS = *(data_forcing[FORCING_PRS] + index_geo) * ens->scale_forcing[FORCING_PRS];
+        cell_SSD = *(data_forcing[FORCING_SSD] + index_geo) * ens->scale_forcing[FORCING_SSD];
+        cell_RHU = *(data_forcing[FORCING_RHU] + index_geo) * ens->scale_forcing[FORCING_RHU];
+        cell_WIN = *(data_forcing[FORCING_WIN] + index_geo) * ens->scale_forcing[FORCING_WIN];
+        cell_TEM_AVG = *(data_forcing[FORCING_TEM_AVG] + index_geo) * ens->scale_forcing[FORCING_TEM_AVG];
+        cell_TEM_MAX = *(data_forcing[FORCING_TEM_MAX] + index_geo) * ens->scale_forcing[FORCING_TEM_MAX];
+        cell_TEM_MIN = *(data_forcing[FORCING_TEM_MIN] + index_geo) * ens->scale_forcing[FORCING_TEM_MIN];
+
+        /******************* evapotranspiration *******************/
+        Soil_Fe = Soil_Desorption(
+            *(member->data_SOIL.SM_Upper + index_geo),
+            soil->Ksat_upper,
+            soil->PoreSize_index,
+            soil->Porosity_upper,
+            soil->Bubbling,
+            GP->STEP_TIME);
+        ET_CELL(
+            radia_astro + index_geo / ens->GEO_header.ncols,
+            cell_PRE, cell_TEM_AVG, cell_TEM_MIN, cell_TEM_MAX, cell_RHU, cell_PRS, cell_WIN,
+            cell_SSD,
+            member->data_RADIA.Rs + index_geo,
+            member->data_RADIA.L_sky + index_geo,
+            member->data_RADIA.Rno + index_geo,
+            member->data_RADIA.Rno_short + index_geo,
+            member->data_RADIA.Rnu + index_geo,
+            member->data_RADIA.Rnu_short + index_geo,
+            member->data_RADIA.Rns + index_geo,
+            (ens->cell_veg + index_geo)->CAN_FRAC,
+            veg->Albedo_o, veg->Albedo_u, ALBEDO_SOIL,
+            veg->LAI_o, veg->LAI_u,
+            veg->Rpc, veg->rs_min_o, RS_MAX,
+            veg->Rpc, veg->rs_min_o, RS_MAX,
+            &veg->aero,
+            *(member->data_SOIL.SM_Upper + index_geo),
+            soil->WiltingPoint,
+            soil->FieldCapacity,
+            Soil_Fe,
+            member->data_ET.Prec_throughfall + index_geo,
+            member->data_ET.Prec_net + index_geo,
+            member->data_ET.Ep + index_geo,
+            member->data_ET.EI_o + index_geo,
+            member->data_ET.ET_o + index_geo,
+            member->data_ET.EI_u + index_geo,
+            member->data_ET.ET_u + index_geo,
+            member->data_ET.ET_s + index_geo,
+            member->data_ET.Interception_o + index_geo,
+            member->data_ET.Interception_u + index_geo,
+            veg->Understory,
+            GP->STEP_TIME);
+        /**************** unsaturated soil zone water movement *****************/
+        UnsaturatedWaterMove(
+            *(member->data_ET.Prec_net + index_geo) / GP->STEP_TIME,
+            *(member->data_ET.ET_o + index_geo),
+            *(member->data_ET.ET_u + index_geo),
+            *(member->data_ET.ET_s + index_geo),
+            member->data_SOIL.SM_Upper + index_geo,
+            member->data_SOIL.SM_Lower + index_geo,
+            member->data_SOIL.SW_Infiltration + index_geo,
+            member->data_SOIL.SW_Percolation_Upper + index_geo,
+            member->data_SOIL.SW_Percolation_Lower + index_geo,
+            *(member->data_SOIL.SW_rise_lower + index_geo),
+            *(member->data_SOIL.SW_rise_upper + index_geo),
+            member->data_SOIL.SW_SR_Infil + index_geo,
+            member->data_SOIL.SW_SR_Satur + index_geo,
+            para->SOIL_d1,
+            para->SOIL_d2,
+            soil,
+            GP->STEP_TIME);
+        *(member->run_Infil + index_geo) = (int)(*(member->data_SOIL.SW_SR_Infil + index_geo) * 10000); // 0.1 mm
+        *(member->run_Satur + index_geo) = (int)(*(member->data_SOIL.SW_SR_Satur + index_geo) * 10000);
+    }
+    /**************** water movement in saturated soil zone *****************/
+    if (ens->satu_solver == SATU_SOLVER_IMPLICIT)
+    {
+        Soil_Satu_Move_Implicit(
+            &member->satu_system,
+            ens->cell_list->cell_index,
+            ens->cell_list->cell_count,
+            ens->data_STR,
+            &member->data_STREAM,
+            &member->data_SOIL,
+            ens->data_NEIGHBOR,
+            ens->soil_para,
+            para->SOIL_D,
+            para->SOIL_d1,
+            para->STREAM_D,
+            para->STREAM_W,
+            ens->GEO_header.ncols,
+            (double) ens->cellsize_m,
+            GP->STEP_TIME);
+    }
+    else
+    {
+        if (GP->SOIL_SATU_CFL > 0.0)
+        {
+            satu_substeps = Soil_Satu_Substeps(
+                ens->cell_list->cell_index,
+                ens->cell_list->cell_count,
+                ens->data_STR,
+                &member->data_SOIL,
+                ens->soil_para,
+                para->SOIL_D,
+                para->SOIL_d1,
+                para->STREAM_W,
+                (double) ens->cellsize_m,
+                GP->STEP_TIME,
+                GP->SOIL_SATU_CFL);
+        }
+        Soil_Satu_Move(
+            ens->cell_list->cell_index,
+            ens->cell_list->cell_count,
+            ens->data_STR,
+            &member->data_STREAM,
+            &member->data_SOIL,
+            ens->data_NEIGHBOR,
+            ens->soil_para,
+            para->SOIL_D,
+            para->SOIL_d1,
+            para->SOIL_d2,
+            para->STREAM_D,
+            para->STREAM_W,
+            ens->GEO_header.NODATA_value,
+            ens->GEO_header.ncols,
+            (double) ens->cellsize_m,
+            GP->STEP_TIME,
+            ens->satu_kernel,
+            satu_substeps);
+    }
+    /********************* river channel flow routing ****************/
+    Channel_Network_Routing(
+        &member->data_STREAM,
+        ens->channel_network,
+        ens->route_order,
+        GP->STEP_TIME);
+    /********************* outlet discharge: channel and surface runoff (UH) ****************/
+    index_UH_ring = 0;
+    for (int s = 0; s < ens->outlet_count; s++)
+    {
+        *(member->Qout_Sub + s * ens->time_steps_run + t) =
+            (member->data_STREAM + *(ens->outlet_index_row + s) * ens->GEO_header.ncols + *(ens->outlet_index_col + s))->Qout;
+        UH_Routing_Step(
+            member->run_Infil,
+            member->uh_sparse + s,
+            member->UH_ring_Infil + index_UH_ring,
+            member->Qout_SF_Infil + ens->time_steps_run * s,
+            t,
+            ens->cell_list->cell_index,
+            ens->cell_list->cell_count,
+            ens->cellsize_m,
+            ens->GEO_header.NODATA_value,
+            GP->STEP_TIME);
+        UH_Routing_Step(
+            member->run_Satur,
+            member->uh_sparse + s,
+            member->UH_ring_Satur + index_UH_ring,
+            member->Qout_SF_Satur + ens->time_steps_run * s,
+            t,
+            ens->cell_list->cell_index,
+            ens->cell_list->cell_count,
+            ens->cellsize_m,
+            ens->GEO_header.NODATA_value,
+            GP->STEP_TIME);
+        index_UH_ring += (member->uh_sparse + s)->UH_steps;
+    }
+}
+
+void Ensemble_Forcing_Load(
+    ENSEMBLE_DATA *ens
+)
+{
+    /******
+     * the forcing of the whole simulation period in memory, for repeated
+     * runs of the ensemble (calibration): Ensemble_Run() no longer reads
+     * the forcing files
+     */
+    int status_nc;
+    size_t nc_start[3] = {0, 0, 0};
+    size_t nc_count[3];
+    nc_count[0] = ens->time_steps_run;
+    nc_count[1] = ens->GEO_header.nrows;
+    nc_count[2] = ens->GEO_header.ncols;
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        ens->forcing_all[v] = (int *)malloc(sizeof(int) * ens->time_steps_run * ens->cell_counts_total);
+        if (ens->forcing_all[v] == NULL)
+        {
+            printf("memory allocation failed!\n");
+            exit(-3);
+        }
+        nc_start[0] = ens->t_offset_forcing[v];
+        status_nc = nc_get_vara_int(ens->ncID_forcing[v], ens->varID_forcing[v], nc_start, nc_count, ens->forcing_all[v]);
+        handle_error(status_nc, ens->FP_forcing[v]);
+    }
+}
+
+void Ensemble_Run(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int member_count
+)
+{
+    /******
+     * the members from their initial states (Ensemble_Reset()) over the
+     * simulation period: every forcing step is read once for all the members
+     */
+    FORCING_READER forcing_reader;
+    int *data_forcing[FORCING_VARS];
+    RADIA_ASTRO *radia_astro;
+    ENSEMBLE_MEMBER *m;
+    size_t i;
+    int members_on;
+    time_t run_time;
+    struct tm *tm_run;
+    int year, month, day;
+    if (ens->forcing_all[0] == NULL)
+    {
+        Forcing_Reader_Start(
+            &forcing_reader,
+            ens->ncID_forcing,
+            ens->varID_forcing,
+            ens->t_offset_forcing,
+            ens->FP_forcing,
+            ens->GEO_header.nrows,
+            ens->GEO_header.ncols,
+            ens->time_steps_run,
+            ens->forcing_block,
+            ens->GP->FORCING_ASYNC);
+    }
+    radia_astro = (RADIA_ASTRO *)malloc(sizeof(RADIA_ASTRO) * ens->GEO_header.nrows);
+    if (radia_astro == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    run_time = ens->start_time;
+    for (int t = 0; t < ens->time_steps_run; t++)
+    {
+        tm_run = gmtime(&run_time);
+        year = tm_run->tm_year + 1900;
+        month = tm_run->tm_mon + 1;
+        day = tm_run->tm_mday;
+        Radiation_Astro_Rows(year, month, day, ens->data_lat, ens->GEO_header.nrows, radia_astro);
+        if (ens->forcing_all[0] != NULL)
+        {
+            for (size_t v = 0; v < FORCING_VARS; v++)
+            {
+                data_forcing[v] = ens->forcing_all[v] + (size_t)t * ens->cell_counts_total;
+            }
+        }
+        else
+        {
+            Forcing_Reader_Fetch(&forcing_reader, t, data_forcing);
+        }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+        for (int k = 0; k < member_count; k++)
+        {
+            ENSEMBLE_MEMBER *mk = member + k;
+            size_t ik;
+            if (mk->eval != NULL && mk->eval->status != CALIB_RUN_ON)
+            {
+                continue;
+            }
+            Ensemble_Step(ens, para + k, mk, t, month, data_forcing, radia_astro);
+            if (mk->eval != NULL)
+            {
+                // the outlet discharge of the step, [m3/s], as by Route_Outlet()
+                ik = mk->eval->outlet * ens->time_steps_run + t;
+                Calib_Eval_Step(
+                    mk->eval, t,
+                    *(mk->Qout_SF_Infil + ik) / 3600 + *(mk->Qout_SF_Satur + ik) / 3600 + *(mk->Qout_Sub + ik) / 3600);
+            }
+        }
+        run_time += 3600 * ens->GP->STEP_TIME;
+        members_on = 0;
+        for (int k = 0; k < member_count; k++)
+        {
+            members_on += ((member + k)->eval == NULL || (member + k)->eval->status == CALIB_RUN_ON) ? 1 : 0;
+        }
+        if (members_on == 0)
+        {
+            break;
+        }
+    }
+    if (ens->forcing_all[0] == NULL)
+    {
+        Forcing_Reader_Stop(&forcing_reader);
+    }
+    free(radia_astro);
+    for (int k = 0; k < member_count; k++)
+    {
+        m = member + k;
+        if (m->eval != NULL && m->eval->status != CALIB_RUN_ON)
+        {
+            // aborted: no discharge after the last step simulated
+            for (int s = 0; s < ens->outlet_count; s++)
+            {
+                for (int t = m->eval->steps; t < ens->time_steps_run; t++)
+                {
+                    i = s * ens->time_steps_run + t;
+                    *(m->Qout_SF_Infil + i) = 0.0;
+                    *(m->Qout_SF_Satur + i) = 0.0;
+                    *(m->Qout_Sub + i) = 0.0;
+                }
+            }
+        }
+        Route_Outlet(
+            (member + k)->Qout_SF_Infil,
+            (member + k)->Qout_SF_Satur,
+            (member + k)->Qout_Sub,
+            (member + k)->Qout_outlet,
+            ens->outlet_count,
+            ens->time_steps_run);
+    }
+}
+
+void Ensemble_Write_Qout(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int member_count
+)
+{
+    /***************************************
+     * the discharge at the outlets, one text file per outlet,
+     * PATH_OUT/Qout_outlet%d_ensemble.txt: one column per member
+     */
+    FILE *fp;
+    char FP[MAXCHAR];
+    for (int s = 0; s < ens->outlet_count; s++)
+    {
+        if (snprintf(FP, MAXCHAR, "%sQout_outlet%d_ensemble.txt", ens->GP->PATH_OUT, s) >= MAXCHAR)
+        {
+            printf("Error: the output file path is longer than %d characters: %s\n", MAXCHAR - 1, ens->GP->PATH_OUT);
+            exit(0);
+        }
+        if ((fp = fopen(FP, "w")) == NULL)
+        {
+            printf("File Error: cannot create or open output file: %s\n", FP);
+            exit(0);
+        }
+        fprintf(fp, "# outlet ID: %d\n# row: %d\n# col: %d\n# unit: m3/s\n# length: %d\n# members: %d\n",
+                s, *(ens->outlet_index_row + s), *(ens->outlet_index_col + s), ens->time_steps_run, member_count);
+        fprintf(fp, "# %6s", "member");
+        for (int k = 0; k < ENSEMBLE_PARA_COUNT; k++)
+        {
+            fprintf(fp, " %s", para_name[k]);
+        }
+        fprintf(fp, "\n");
+        for (int m = 0; m < member_count; m++)
+        {
+            fprintf(fp, "# %6d", m);
+            for (int k = 0; k < ENSEMBLE_PARA_COUNT; k++)
+            {
+                fprintf(fp, " %g", *Ensemble_Para_Field(para + m, k));
+            }
+            fprintf(fp, "\n");
+        }
+        for (int i = 0; i < ens->time_steps_run; i++)
+        {
+            for (int m = 0; m < member_count; m++)
+            {
+                fprintf(fp, "%.3f ", *((member + m)->Qout_outlet + s * ens->time_steps_run + i));
+            }
+            fprintf(fp, "\n");
+        }
+        fclose(fp);
+    }
+}
+
+void Ensemble_Free(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_MEMBER *member,
+    int member_count
+)
+{
+    ENSEMBLE_MEMBER *m;
+    for (int k = 0; k < member_count; k++)
+    {
+        m = member + k;
+        Free_RADIA(&m->data_RADIA); Free_ET(&m->data_ET); Free_SOIL(&m->data_SOIL);
+        free(m->data_STREAM);
+        free(m->run_Infil); free(m->run_Satur);
+        free(m->UH_ring_Infil); free(m->UH_ring_Satur);
+        free(m->Qout_SF_Infil); free(m->Qout_SF_Satur); free(m->Qout_Sub); free(m->Qout_outlet);
+        if (ens->satu_solver == SATU_SOLVER_IMPLICIT)
+        {
+            Soil_Satu_System_Free(&m->satu_system);
+        }
+        if (m->uh_owner == 1)
+        {
+            for (int s = 0; s < ens->outlet_count; s++)
+            {
+                UH_Sparse_Free(m->uh_sparse + s);
+            }
+            free(m->uh_sparse);
+        }
+    }
+    free(ens->data_FlowDistance); free(ens->data_SlopeArea); free(ens->data_FAC); free(ens->data_Mask);
+    if (ens->state_in == 1)
+    {
+        Free_ET(&ens->state_ET); Free_SOIL(&ens->state_SOIL);
+        free(ens->state_STREAM);
+    }
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        free(ens->forcing_all[v]);
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef ENSEMBLE
+#define ENSEMBLE
+
+#include <time.h>
+#include "HM_ST.h"
+#include "GEO_ST.h"
+#include "Evapotranspiration_ST.h"
+#include "Lookup_SoilLib.h"
+#include "UH_Generation.h"
+#include "Soil_SaturatedImplicit.h"
+#include "Forcing_Reader.h"
+#include "Radiation_Calc.h"
+#include "Calib_Objective.h"
+
+#define ENSEMBLE_PARA_COUNT 9  // the parameters that may vary among the members, see ENSEMBLE_PARA
+
+typedef struct
+{
+    /* the parameter set of one ensemble member; not given in FP_ENSEMBLE: the value of the global parameter file */
+    double SOIL_D;
+    double SOIL_d1;
+    double SOIL_d2;
+    double ROUTE_CHANNEL_k;
+    double STREAM_D;
+    double STREAM_W;
+    double Velocity_avg;
+    double Velocity_max;
+    double Velocity_min;
+} ENSEMBLE_PARA;
+
+typedef struct
+{
+    /******
+     * the model state and the outlet discharge of one ensemble member;
+     * the surface runoff is routed at every step (streaming UH)
+     */
+    CELL_VAR_RADIA data_RADIA;
+    CELL_VAR_ET data_ET;
+    CELL_VAR_SOIL data_SOIL;
+    CELL_VAR_STREAM *data_STREAM;
+    SATU_SYSTEM satu_system;   /* IMPLICIT: the linear system, one per member as the members run in parallel */
+    UH_SPARSE *uh_sparse;      /* the UH of the outlets: ENSEMBLE_DATA.uh_sparse, or built for the velocities of the member */
+    int uh_owner;              /* 1: uh_sparse is built for (and freed with) this member */
+    int *run_Infil;            /* surface runoff of the current step, [0.1 mm] */
+    int *run_Satur;
+    double *UH_ring_Infil;     /* partial sums of the outlet discharge of the coming UH steps, see UH_Routing_Step() */
+    double *UH_ring_Satur;
+    double *Qout_SF_Infil;     /* discharge at the outlets, outlet_count * time_steps_run, [m3/h], [m3/s] after the run */
+    double *Qout_SF_Satur;
+    double *Qout_Sub;
+    double *Qout_outlet;       /* total discharge at the outlets, [m3/s] */
+    CALIB_EVAL *eval;          /* the score, accumulated during the run, which stops when aborted; NULL: none */
+} ENSEMBLE_MEMBER;
+
+typedef struct
+{
+    /******
+     * the data shared by all the members: read once by xHM_main.c
+     */
+    GLOBAL_PARA *GP;
+    int ncID_GEO;
+    ST_Header GEO_header;
+    int cellsize_m;
+    int cell_counts_total;
+    CELL_LIST *cell_list;
+    int *data_STR;
+    int *data_FDR;
+    int *data_DEM;
+    double *data_lat;
+    ST_CELL_VEG *cell_veg;
+    ST_VEG_CLASS *veg_table;   /* the vegetation parameters of the classes and months, see Lookup_VegLib_Table() */
+    ST_SOIL_PARA_CELL *soil_para;
+    CELL_NEIGHBOR *data_NEIGHBOR;
+    CHANNEL_NETWORK *channel_network;
+    int route_order;
+    int satu_solver;
+    int satu_kernel;
+    time_t start_time;
+    int time_steps_run;
+    /* weather forcing, see Forcing_Reader.h */
+    int ncID_forcing[FORCING_VARS];
+    int varID_forcing[FORCING_VARS];
+    int t_offset_forcing[FORCING_VARS];
+    char *FP_forcing[FORCING_VARS];
+    double scale_forcing[FORCING_VARS];
+    int forcing_block;
+    int *forcing_all[FORCING_VARS];   /* the forcing of all the steps, see Ensemble_Forcing_Load(); NULL: read by the forcing reader */
+    /* the outlets and their UH from FP_UH (the velocities of the global parameter file) */
+    int outlet_count;
+    int *outlet_index_row;
+    int *outlet_index_col;
+    UH_SPARSE *uh_sparse;
+    /* for the UH of other velocities: GEO-derived maps, see UH_Generation() */
+    double *data_FlowDistance;
+    double *data_SlopeArea;
+    double slope_area_avg;
+    int *data_FAC;
+    int *data_Mask;            /* outlet_count masks of the upstream cells */
+    /* the initial state of FP_STATE_IN, read once, see Ensemble_State_Load() */
+    int state_in;              /* 1: state_* hold the state of FP_STATE_IN; 0: no FP_STATE_IN */
+    CELL_VAR_ET state_ET;
+    CELL_VAR_SOIL state_SOIL;
+    CELL_VAR_STREAM *state_STREAM;
+} ENSEMBLE_DATA;
+
+double *Ensemble_Para_Field(
+    ENSEMBLE_PARA *para,
+    int k);
+
+int Ensemble_Para_Index(
+    char *name);
+
+char *Ensemble_Para_Name(
+    int k);
+
+void Ensemble_Para_Default(
+    GLOBAL_PARA *GP,
+    ENSEMBLE_PARA *para);
+
+int Ensemble_Import(
+    char FP[],
+    GLOBAL_PARA *GP,
+    ENSEMBLE_PARA **para);
+
+void Ensemble_UH_Base(
+    ENSEMBLE_DATA *ens);
+
+void Ensemble_State_Load(
+    ENSEMBLE_DATA *ens);
+
+void Ensemble_Allocate(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_MEMBER *member);
+
+void Ensemble_Reset(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int member_count);
+
+void Ensemble_Step(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int t,
+    int month,
+    int **data_forcing,
+    RADIA_ASTRO *radia_astro);
+
+void Ensemble_Forcing_Load(
+    ENSEMBLE_DATA *ens);
+
+void Ensemble_Run(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int member_count);
+
+void Ensemble_Write_Qout(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    int member_count);
+
+void Ensemble_Free(
+    ENSEMBLE_DATA *ens,
+    ENSEMBLE_MEMBER *member,
+    int member_count);
+
+#endif
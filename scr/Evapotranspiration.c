@@ -374,10 +374,7 @@ void ET_iteration(
 
 
 void ET_CELL(
-    int year,
-    int month,
-    int day,
-    double lat,         /* the latitute of the location */
+    RADIA_ASTRO *astro, /* the astronomical terms of the date and latitude, see Radiation_Astro() */
 
     double Prec,        /* precipitation (total) within the time step, m */
     double Air_tem_avg, /* air temperature (in degrees Celsius) */
@@ -386,7 +383,6 @@ void ET_CELL(
     double Air_rhu,     /* relative humidity, unit: % */
     double Air_pres,    /* air pressure, kPa */
     double Air_ws_obs,  /* wind speed at the measurement height, m/s */
-    double ws_obs_z,    /* the measurement height, m */
     double Air_ssd,     /* sunshine duration in a day, hours */
 
     double *Rs,         /* received shortwave radiation for the overstory canopy, [kJ/m2/h] */
@@ -409,12 +405,7 @@ void ET_CELL(
     double Rpc_u,       /* the light level where rs is twice the rs_min */
     double rs_min_u,    /* minimum stomatal resistance, [s/m] */
     double rs_max_u,    /* maximum (cuticular) resistance, [s/m] */
-    double Canopy_zr,   /* reference height of canopy, m */
-    double Canopy_h,    /* height of canopy, m */
-    double d_o,         /* displacement height of canopy, m */
-    double z0_o,        /* the roughness of canopy, m */
-    double d_u,         /* displacement height of understory, m */
-    double z0_u,        /* roughness length of understory, m */
+    ST_AERO_PRE *aero,  /* the logarithms of the aerodynamic resistances of the vegetation class and month, see Resist_aero_Pre() */
     
     double SM,          /* average soil moisture content */
     double SM_wp,       /* the plant wilting point */
@@ -452,9 +443,9 @@ void ET_CELL(
      * [MJ/m2/d] = 1000 000 / (3600*24) W/m2, as J/s = W 
      * 1000 000 / (3600*24) = 11.574
     */
-    *Rs = Radiation_downward_short(year, month, day, lat, Air_ssd);
-    *L_sky = Radiation_downward_long(
-        year, month, day, lat,
+    *Rs = Radiation_downward_short_astro(astro, Air_ssd);
+    *L_sky = Radiation_downward_long_astro(
+        astro,
         Air_tem_avg, Air_rhu, Air_ssd, 0.0);
 
     /*****
@@ -516,9 +507,7 @@ void ET_CELL(
             Air_tem_avg, Air_tem_min, Air_tem_max, Air_rhu,
             Rp_o, Rpc_o, rs_min_o, rs_max_o,
             SM, SM_wp, SM_free) / LAI_o;
-        Res_aero_o = Resist_aero_o(
-            Air_ws_obs, ws_obs_z, Canopy_zr,
-            Canopy_h, d_o, z0_o, d_u, z0_u);
+        Res_aero_o = Resist_aero_o_Pre(Air_ws_obs, aero);
     }
     else
     {
@@ -532,9 +521,7 @@ void ET_CELL(
             Air_tem_avg, Air_tem_min, Air_tem_max, Air_rhu,
             Rp_u, Rpc_u, rs_min_u, rs_max_u,
             SM, SM_wp, SM_free) / LAI_u;
-        Res_aero_u = Resist_aero_u(
-            Air_ws_obs, ws_obs_z,
-            d_u, z0_u);
+        Res_aero_u = Resist_aero_u_Pre(Air_ws_obs, aero);
     } 
     else
     {
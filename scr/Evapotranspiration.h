@@ -2,6 +2,9 @@
 #ifndef ET_header
 #define ET_header
 
+#include "Radiation_Calc.h"
+#include "Evapotranspiration_ST.h"
+
 double PotentialEvaporation(
     double Air_tem_avg, /* scalar: average air tempeature (℃) */
     double Air_tem_min, /* scalar: minimum air temperature (℃)*/
@@ -92,10 +95,7 @@ void ET_iteration(
  );
 
 void ET_CELL(
-    int year,
-    int month,
-    int day,
-    double lat, /* the latitute of the location */
+    RADIA_ASTRO *astro, /* the astronomical terms of the date and latitude, see Radiation_Astro() */
 
     double Prec,        /* precipitation (total) within the time step, m */
     double Air_tem_avg, /* air temperature (in degrees Celsius) */
@@ -104,7 +104,6 @@ void ET_CELL(
     double Air_rhu,     /* relative humidity, unit: % */
     double Air_pres,    /* air pressure, kPa */
     double Air_ws_obs,  /* wind speed at the measurement height, m/s */
-    double ws_obs_z,    /* the measurement height, m */
     double Air_ssd,     /* sunshine duration in a day, hours */
     double *Rs,         /* received shortwave radiation for the overstory canopy */
     double *L_sky,      /* received longwave radiation for the overstory canopy */
@@ -125,12 +124,7 @@ void ET_CELL(
     double Rpc_u,       /* the light level where rs is twice the rs_min */
     double rs_min_u,    /* minimum stomatal resistance */
     double rs_max_u,    /* maximum (cuticular) resistance */
-    double Canopy_zr,   /* reference height of canopy, m */
-    double Canopy_h,    /* height of canopy, m */
-    double d_o,         /* displacement height of canopy, m */
-    double z0_o,        /* the roughness of canopy, m */
-    double d_u,         /* displacement height of understory, m */
-    double z0_u,        /* roughness length of understory, m */
+    ST_AERO_PRE *aero,  /* the logarithms of the aerodynamic resistances of the vegetation class and month, see Resist_aero_Pre() */
 
     double SM,          /* average soil moisture content */
     double SM_wp,       /* the plant wilting point */
@@ -28,24 +28,49 @@ typedef struct
     double TEM_MIN;
 } ST_Weather;
 
+#define VEG_CLASS_COUNT 12   // vegetation classes: 0 (open water, as bare soil) to 11, see Lookup_VegLib_Table()
+
 typedef struct
 {
+    /* the per-cell vegetation: the parameters are looked up in the class table */
     int CLASS;
     double CAN_FRAC;
+} ST_CELL_VEG;
+
+typedef struct
+{
+    /******
+     * the terms of the aerodynamic resistances that only depend on the
+     * vegetation class and month (and the wind measurement height),
+     * see Resist_aero_Pre()
+     */
+    double log2_o;      // log((zr - d_o) / z0_o)^2, overstory
+    double log_zr;      // log((zr - d_u) / z0_u), wind profile to the canopy reference height
+    double log_obs;     // log((ws_obs_z - d_u) / z0_u), wind profile from the measurement height
+    double log_za;      // log((za - d_u) / z0_u), za = 2 + d_u + z0_u, understory
+    double log2_za;     // log((za - d_u) / z0_u)^2
+} ST_AERO_PRE;
+
+typedef struct
+{
+    /* the vegetation parameters of one class and month: veg_table[CLASS * 12 + month - 1] */
     int Understory;
-    double Albedo_o[12];
-    double Albedo_u[12];
-    double LAI_o[12];
-    double LAI_u[12];
+    double Albedo_o;
+    double Albedo_u;
+    double LAI_o;
+    double LAI_u;
     double rs_min_o;
     double rs_min_u;    // Minimum stomatal resistance of vegetation
     double Rpc;
     double CAN_H;       // canopy height
     double CAN_RZ;      // canopy reference height
-    double d_o[12];     // displacement height
-    double d_u[12];
-    double z0_o[12];    // roughness height
-    double z0_u[12];
-} ST_CELL_VEG;
+    double d_o;         // displacement height
+    double d_u;
+    double z0_o;        // roughness height
+    double z0_u;
+    double Tau_o;       // exp(- LAI_o), shortwave transmitted by the overstory, see Radiation_net()
+    double Tau_u;       // exp(- LAI_u), by the understory
+    ST_AERO_PRE aero;
+} ST_VEG_CLASS;
 
 #endif
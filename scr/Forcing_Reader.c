@@ -0,0 +1,257 @@
+/*
+ * SUMMARY:      Forcing_Reader.c
+ * USAGE:        read the gridded weather forcing block by block
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  overlap the reading of the weather forcing (8 NetCDF variables)
+ *               with the model simulation: the forcing is read in blocks of K
+ *               consecutive steps, and a background thread reads block b+1 into
+ *               a second buffer set while the steps of block b are simulated
+ * DESCRIP-END.
+ * FUNCTIONS:    Forcing_Reader_Start(); Forcing_Reader_Fetch(); Forcing_Reader_Stop();
+ *               Forcing_Reader_Lock_NC(); Forcing_Reader_Unlock_NC();
+ *               Forcing_Block_Size(); Forcing_Read_Block(); Forcing_Reader_Thread()
+ *
+ * COMMENTS:
+ * The NetCDF library is not thread-safe: the reader thread holds nc_mutex
+ * while it reads, and any other NetCDF call made while the reader is running
+ * (e.g. writing the output variables) has to be wrapped with
+ * Forcing_Reader_Lock_NC() and Forcing_Reader_Unlock_NC().
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * FORCING_READER *reader           - the forcing reader, see "Forcing_Reader.h"
+ * int *ncID                        - ID of the opened forcing nc files, FORCING_VARS
+ * int *varID                       - ID of the forcing variables, FORCING_VARS
+ * int *t_offset                    - index of the simulation starting step in each forcing series
+ * char **FP                        - file path of each forcing file
+ * int steps                        - number of simulation steps
+ * int block                        - number of steps read per variable and NetCDF call (K)
+ * double memory_MB                 - memory budget of the two forcing buffer sets, [MB]
+ * int async                        - 1: prefetch in a background thread; 0: read on demand
+ * int t                            - the simulation step to be fetched
+ * int **data                       - FORCING_VARS pointers to the maps of step t
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <netcdf.h>
+#include "NC_copy_global_att.h"
+#include "Forcing_Reader.h"
+
+int Forcing_Block_Size(
+    double memory_MB,
+    int nrows,
+    int ncols,
+    int steps
+)
+{
+    /**********
+     * the largest block (steps per read) for which the two buffer sets
+     * of the 8 variables fit into the memory budget; at least 1 step,
+     * at most the whole simulation period
+     */
+    double bytes_step;
+    int block;
+    bytes_step = 2.0 * FORCING_VARS * sizeof(int) * nrows * ncols;
+    block = (int)(memory_MB * 1024 * 1024 / bytes_step);
+    if (block < 1)
+    {
+        block = 1;
+    }
+    if (block > steps)
+    {
+        block = steps;
+    }
+    return block;
+}
+
+static void Forcing_Read_Block(
+    FORCING_READER *reader,
+    int b
+)
+{
+    /* read the maps of block b (steps b*block, ..., at most (b+1)*block-1) of all the variables into buffer set b % 2 */
+    int status_nc;
+    size_t nc_start[3] = {0, 0, 0};
+    size_t nc_count[3];
+    nc_count[0] = reader->block;
+    if ((b + 1) * reader->block > reader->steps)
+    {
+        nc_count[0] = reader->steps - b * reader->block;
+    }
+    nc_count[1] = reader->nrows;
+    nc_count[2] = reader->ncols;
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        nc_start[0] = reader->t_offset[v] + b * reader->block;
+        status_nc = nc_get_vara_int(reader->ncID[v], reader->varID[v], nc_start, nc_count, reader->buffer[b % 2][v]);
+        handle_error(status_nc, reader->FP[v]);
+    }
+}
+
+static void *Forcing_Reader_Thread(
+    void *arg
+)
+{
+    FORCING_READER *reader = (FORCING_READER *)arg;
+    int blocks;
+    blocks = (reader->steps + reader->block - 1) / reader->block;
+    for (int b = 0; b < blocks; b++)
+    {
+        /* wait until the model has released all the steps of block b-2, which used the same buffer set */
+        pthread_mutex_lock(&reader->mutex);
+        while (reader->step_done < (b - 1) * reader->block - 1 && reader->stop == 0)
+        {
+            pthread_cond_wait(&reader->cond, &reader->mutex);
+        }
+        if (reader->stop == 1)
+        {
+            pthread_mutex_unlock(&reader->mutex);
+            break;
+        }
+        pthread_mutex_unlock(&reader->mutex);
+
+        pthread_mutex_lock(&reader->nc_mutex);
+        Forcing_Read_Block(reader, b);
+        pthread_mutex_unlock(&reader->nc_mutex);
+
+        pthread_mutex_lock(&reader->mutex);
+        reader->block_ready = b;
+        pthread_cond_broadcast(&reader->cond);
+        pthread_mutex_unlock(&reader->mutex);
+    }
+    return NULL;
+}
+
+void Forcing_Reader_Start(
+    FORCING_READER *reader,
+    int *ncID,
+    int *varID,
+    int *t_offset,
+    char **FP,
+    int nrows,
+    int ncols,
+    int steps,
+    int block,
+    int async
+)
+{
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        reader->ncID[v] = *(ncID + v);
+        reader->varID[v] = *(varID + v);
+        reader->t_offset[v] = *(t_offset + v);
+        reader->FP[v] = *(FP + v);
+        for (size_t b = 0; b < 2; b++)
+        {
+            reader->buffer[b][v] = (int *)malloc(sizeof(int) * block * nrows * ncols);
+            if (reader->buffer[b][v] == NULL)
+            {
+                printf("memory allocation failed!\n");
+                exit(-3);
+            }
+        }
+    }
+    reader->nrows = nrows;
+    reader->ncols = ncols;
+    reader->steps = steps;
+    reader->block = block;
+    reader->async = async;
+    reader->block_ready = -1;
+    reader->step_done = -1;
+    reader->stop = 0;
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->cond, NULL);
+    pthread_mutex_init(&reader->nc_mutex, NULL);
+    if (reader->async == 1)
+    {
+        if (pthread_create(&reader->thread, NULL, Forcing_Reader_Thread, reader) != 0)
+        {
+            printf("failed in starting the forcing reader thread!\n");
+            exit(-2);
+        }
+    }
+}
+
+void Forcing_Reader_Fetch(
+    FORCING_READER *reader,
+    int t,
+    int **data
+)
+{
+    /**********
+     * fetching step t releases step t-1 to the reader:
+     * the maps returned by the previous call must not be used any more;
+     * steps are fetched in order, t = 0, 1, 2, ...
+     */
+    int b;
+    b = t / reader->block;
+    if (reader->async == 1)
+    {
+        pthread_mutex_lock(&reader->mutex);
+        reader->step_done = t - 1;
+        pthread_cond_broadcast(&reader->cond);
+        while (reader->block_ready < b)
+        {
+            pthread_cond_wait(&reader->cond, &reader->mutex);
+        }
+        pthread_mutex_unlock(&reader->mutex);
+    }
+    else if (t % reader->block == 0)
+    {
+        Forcing_Read_Block(reader, b);
+    }
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        *(data + v) = reader->buffer[b % 2][v] + (size_t)(t % reader->block) * reader->nrows * reader->ncols;
+    }
+}
+
+void Forcing_Reader_Stop(
+    FORCING_READER *reader
+)
+{
+    if (reader->async == 1)
+    {
+        pthread_mutex_lock(&reader->mutex);
+        reader->stop = 1;
+        pthread_cond_broadcast(&reader->cond);
+        pthread_mutex_unlock(&reader->mutex);
+        pthread_join(reader->thread, NULL);
+    }
+    pthread_mutex_destroy(&reader->mutex);
+    pthread_cond_destroy(&reader->cond);
+    pthread_mutex_destroy(&reader->nc_mutex);
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        free(reader->buffer[0][v]);
+        free(reader->buffer[1][v]);
+    }
+}
+
+void Forcing_Reader_Lock_NC(
+    FORCING_READER *reader
+)
+{
+    if (reader->async == 1)
+    {
+        pthread_mutex_lock(&reader->nc_mutex);
+    }
+}
+
+void Forcing_Reader_Unlock_NC(
+    FORCING_READER *reader
+)
+{
+    if (reader->async == 1)
+    {
+        pthread_mutex_unlock(&reader->nc_mutex);
+    }
+}
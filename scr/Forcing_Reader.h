@@ -0,0 +1,83 @@
+#ifndef FORCING_READ
+#define FORCING_READ
+
+#include <pthread.h>
+
+/* the weather forcing variables, in the order they are read */
+#define FORCING_VARS 8
+#define FORCING_PRE 0
+#define FORCING_PRS 1
+#define FORCING_SSD 2
+#define FORCING_RHU 3
+#define FORCING_WIN 4
+#define FORCING_TEM_AVG 5
+#define FORCING_TEM_MAX 6
+#define FORCING_TEM_MIN 7
+
+typedef struct
+{
+    /******
+     * double-buffered reader of the gridded weather forcing:
+     * the forcing is read in blocks of `block` consecutive steps per variable
+     * (one nc_get_vara_* call each); while the model simulates the steps of
+     * block b from one buffer set, a background thread reads block b+1
+     * into the other one
+     */
+    int ncID[FORCING_VARS];              /* ID of the opened forcing nc files */
+    int varID[FORCING_VARS];             /* ID of the forcing variables */
+    int t_offset[FORCING_VARS];          /* index of the first simulation step in each forcing series */
+    char *FP[FORCING_VARS];              /* file path of the forcing, for error messages */
+    size_t nrows;
+    size_t ncols;
+    int steps;                           /* number of simulation steps to be read */
+    int block;                           /* number of steps per block (per read of a variable) */
+    int async;                           /* 1: read in the background thread; 0: read in Forcing_Reader_Fetch() */
+    int *buffer[2][FORCING_VARS];        /* two buffer sets of `block` 2D maps per variable; block b lives in buffer[b % 2] */
+    int block_ready;                     /* the last block read into its buffer set */
+    int step_done;                       /* the last step released by the model; its buffer set may be reused */
+    int stop;                            /* 1: the reader thread is asked to quit */
+    pthread_t thread;
+    pthread_mutex_t mutex;               /* guards block_ready, step_done and stop */
+    pthread_cond_t cond;
+    pthread_mutex_t nc_mutex;            /* serializes the NetCDF library calls, which is not thread-safe */
+} FORCING_READER;
+
+void Forcing_Reader_Start(
+    FORCING_READER *reader,
+    int *ncID,
+    int *varID,
+    int *t_offset,
+    char **FP,
+    int nrows,
+    int ncols,
+    int steps,
+    int block,
+    int async
+);
+
+int Forcing_Block_Size(
+    double memory_MB,
+    int nrows,
+    int ncols,
+    int steps
+);
+
+void Forcing_Reader_Fetch(
+    FORCING_READER *reader,
+    int t,
+    int **data
+);
+
+void Forcing_Reader_Stop(
+    FORCING_READER *reader
+);
+
+void Forcing_Reader_Lock_NC(
+    FORCING_READER *reader
+);
+
+void Forcing_Reader_Unlock_NC(
+    FORCING_READER *reader
+);
+
+#endif
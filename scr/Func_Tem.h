@@ -15,7 +15,17 @@ double e0(
     double Air_tem      /* scalar: air temperature (celsius degree) */
 );
 
+double e0_ice(
+    double Air_tem      /* scalar: air (or snow surface) temperature (celsius degree) */
+);
+
 double Kelvin_tem(
     double tem);
 
+void Func_Tem_Init(void);
+
+#ifdef FUNC_TEM_TABLE
+void Func_Tem_Report(void);
+#endif
+
 #endif
\ No newline at end of file
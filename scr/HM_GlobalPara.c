@@ -147,6 +147,14 @@ void Import_GlobalPara(
                 {
                     strcpy(global_para->SURFACE_RUNOFF, S2);
                 }
+                else if (strcmp(S1, "UH_MODE") == 0)
+                {
+                    strcpy(global_para->UH_MODE, S2);
+                }
+                else if (strcmp(S1, "UH_CLASS_WIDTH") == 0)
+                {
+                    global_para->UH_CLASS_WIDTH = atof(S2);
+                }
                 else if (strcmp(S1, "FP_UH") == 0)
                 {
                     strcpy(global_para->FP_UH, S2);
@@ -175,6 +183,10 @@ void Import_GlobalPara(
                 {
                     global_para->ROUTE_CHANNEL_k = atof(S2);
                 }
+                else if (strcmp(S1, "ROUTE_CHANNEL_ORDER") == 0)
+                {
+                    strcpy(global_para->ROUTE_CHANNEL_ORDER, S2);
+                }
                 else if (strcmp(S1, "WIN_H") == 0)
                 {
                     global_para->WIN_H = atof(S2);
@@ -199,6 +211,130 @@ void Import_GlobalPara(
                 {
                     global_para->c = atof(S2);
                 }
+                else if (strcmp(S1, "NUM_THREADS") == 0)
+                {
+                    global_para->NUM_THREADS = atoi(S2);
+                }
+                else if (strcmp(S1, "ET_KERNEL") == 0)
+                {
+                    strcpy(global_para->ET_KERNEL, S2);
+                }
+                else if (strcmp(S1, "SOIL_SATU_KERNEL") == 0)
+                {
+                    strcpy(global_para->SOIL_SATU_KERNEL, S2);
+                }
+                else if (strcmp(S1, "SOIL_SATU_SOLVER") == 0)
+                {
+                    strcpy(global_para->SOIL_SATU_SOLVER, S2);
+                }
+                else if (strcmp(S1, "SOIL_SATU_CG_TOL") == 0)
+                {
+                    global_para->SOIL_SATU_CG_TOL = atof(S2);
+                }
+                else if (strcmp(S1, "SOIL_SATU_CG_ITER") == 0)
+                {
+                    global_para->SOIL_SATU_CG_ITER = atoi(S2);
+                }
+                else if (strcmp(S1, "SOIL_SATU_CFL") == 0)
+                {
+                    global_para->SOIL_SATU_CFL = atof(S2);
+                }
+                else if (strcmp(S1, "FORCING_ASYNC") == 0)
+                {
+                    global_para->FORCING_ASYNC = atoi(S2);
+                }
+                else if (strcmp(S1, "FORCING_BLOCK") == 0)
+                {
+                    global_para->FORCING_BLOCK = atoi(S2);
+                }
+                else if (strcmp(S1, "FORCING_MEMORY") == 0)
+                {
+                    global_para->FORCING_MEMORY = atof(S2);
+                }
+                else if (strcmp(S1, "CHECKPOINT_STEPS") == 0)
+                {
+                    global_para->CHECKPOINT_STEPS = atoi(S2);
+                }
+                else if (strcmp(S1, "FP_CHECKPOINT") == 0)
+                {
+                    strcpy(global_para->FP_CHECKPOINT, S2);
+                }
+                else if (strcmp(S1, "FP_STATE_IN") == 0)
+                {
+                    strcpy(global_para->FP_STATE_IN, S2);
+                }
+                else if (strcmp(S1, "FP_STATE_OUT") == 0)
+                {
+                    strcpy(global_para->FP_STATE_OUT, S2);
+                }
+                else if (strcmp(S1, "SPINUP_STEPS") == 0)
+                {
+                    global_para->SPINUP_STEPS = atoi(S2);
+                }
+                else if (strcmp(S1, "SPINUP_CYCLES_MAX") == 0)
+                {
+                    global_para->SPINUP_CYCLES_MAX = atoi(S2);
+                }
+                else if (strcmp(S1, "SPINUP_TOL") == 0)
+                {
+                    global_para->SPINUP_TOL = atof(S2);
+                }
+                else if (strcmp(S1, "FP_ENSEMBLE") == 0)
+                {
+                    strcpy(global_para->FP_ENSEMBLE, S2);
+                }
+                else if (strcmp(S1, "FP_CALIB") == 0)
+                {
+                    strcpy(global_para->FP_CALIB, S2);
+                }
+                else if (strcmp(S1, "FP_QOBS") == 0)
+                {
+                    strcpy(global_para->FP_QOBS, S2);
+                }
+                else if (strcmp(S1, "CALIB_OUTLET") == 0)
+                {
+                    global_para->CALIB_OUTLET = atoi(S2);
+                }
+                else if (strcmp(S1, "CALIB_OBJECTIVE") == 0)
+                {
+                    strcpy(global_para->CALIB_OBJECTIVE, S2);
+                }
+                else if (strcmp(S1, "CALIB_WARMUP") == 0)
+                {
+                    global_para->CALIB_WARMUP = atoi(S2);
+                }
+                else if (strcmp(S1, "CALIB_EARLY_STOP") == 0)
+                {
+                    global_para->CALIB_EARLY_STOP = atoi(S2);
+                }
+                else if (strcmp(S1, "CALIB_SCORE_MIN") == 0)
+                {
+                    global_para->CALIB_SCORE_MIN = atof(S2);
+                }
+                else if (strcmp(S1, "SCEUA_COMPLEXES") == 0)
+                {
+                    global_para->SCEUA_COMPLEXES = atoi(S2);
+                }
+                else if (strcmp(S1, "SCEUA_EVALS_MAX") == 0)
+                {
+                    global_para->SCEUA_EVALS_MAX = atoi(S2);
+                }
+                else if (strcmp(S1, "SCEUA_LOOPS_STOP") == 0)
+                {
+                    global_para->SCEUA_LOOPS_STOP = atoi(S2);
+                }
+                else if (strcmp(S1, "SCEUA_PCENTO") == 0)
+                {
+                    global_para->SCEUA_PCENTO = atof(S2);
+                }
+                else if (strcmp(S1, "SCEUA_PEPS") == 0)
+                {
+                    global_para->SCEUA_PEPS = atof(S2);
+                }
+                else if (strcmp(S1, "SCEUA_SEED") == 0)
+                {
+                    global_para->SCEUA_SEED = atoi(S2);
+                }
                 else
                 {
                     printf("Unrecognized field in row %d: %s\n", j, row);
@@ -241,6 +377,7 @@ void Initialize_GlobalPara(
     
     /* hydrological modeling parameters */
     global_para->ROUTE_CHANNEL_k = 0.3;
+    strcpy(global_para->ROUTE_CHANNEL_ORDER, "TOPO");
     global_para->WIN_H = 10.0;
     global_para->SOIL_d1 = 0.1;
     global_para->SOIL_d2 = 0.2;
@@ -250,6 +387,8 @@ void Initialize_GlobalPara(
 
     /* UH parameters */
     strcpy(global_para->SURFACE_RUNOFF, "UH");
+    strcpy(global_para->UH_MODE, "BATCH");
+    global_para->UH_CLASS_WIDTH = 1.0;
     strcpy(global_para->FP_UH, "\0");
     global_para->Velocity_avg = 480.0;
     global_para->Velocity_max = 13200.0;
@@ -259,6 +398,39 @@ void Initialize_GlobalPara(
     /* output parameters */
     strcpy(global_para->FP_OUTNAMELIST, "\0");
     strcpy(global_para->PATH_OUT, "\0");
+    global_para->CHECKPOINT_STEPS = 0;
+    strcpy(global_para->FP_CHECKPOINT, "\0");
+    strcpy(global_para->FP_STATE_IN, "\0");
+    strcpy(global_para->FP_STATE_OUT, "\0");
+    global_para->SPINUP_STEPS = 0;
+    global_para->SPINUP_CYCLES_MAX = 20;
+    global_para->SPINUP_TOL = 0.001;
+    strcpy(global_para->FP_ENSEMBLE, "\0");
+    strcpy(global_para->FP_CALIB, "\0");
+    strcpy(global_para->FP_QOBS, "\0");
+    global_para->CALIB_OUTLET = 0;
+    strcpy(global_para->CALIB_OBJECTIVE, "NSE");
+    global_para->CALIB_WARMUP = 0;
+    global_para->CALIB_EARLY_STOP = 1;
+    global_para->CALIB_SCORE_MIN = -9999.0;
+    global_para->SCEUA_COMPLEXES = 4;
+    global_para->SCEUA_EVALS_MAX = 1000;
+    global_para->SCEUA_LOOPS_STOP = 5;
+    global_para->SCEUA_PCENTO = 0.001;
+    global_para->SCEUA_PEPS = 0.001;
+    global_para->SCEUA_SEED = 1;
+
+    /* parallel computing parameters */
+    global_para->NUM_THREADS = 0;
+    global_para->FORCING_ASYNC = 1;
+    global_para->FORCING_BLOCK = 0;
+    global_para->FORCING_MEMORY = 256.0;
+    strcpy(global_para->ET_KERNEL, "BATCH");
+    strcpy(global_para->SOIL_SATU_KERNEL, "SIMD");
+    strcpy(global_para->SOIL_SATU_SOLVER, "EXPLICIT");
+    global_para->SOIL_SATU_CG_TOL = 1e-10;
+    global_para->SOIL_SATU_CG_ITER = 1000;
+    global_para->SOIL_SATU_CFL = 0.0;
 }
 
 void Print_GlobalPara(
@@ -297,8 +469,11 @@ void Print_GlobalPara(
     printf("%18s: %f\n", "STREAM_D", gp->STREAM_D);
     printf("%18s: %f\n", "STREAM_W", gp->STREAM_W);
     printf("%18s: %f\n", "ROUTE_CHANNEL_k", gp->ROUTE_CHANNEL_k);
+    printf("%18s: %s\n", "ROUTE_CHANNEL_ORDER", gp->ROUTE_CHANNEL_ORDER);
 
     printf("%18s: %s\n", "SURFACE_RUNOFF", gp->SURFACE_RUNOFF);
+    printf("%18s: %s\n", "UH_MODE", gp->UH_MODE);
+    printf("%18s: %f\n", "UH_CLASS_WIDTH", gp->UH_CLASS_WIDTH);
     printf("%18s: %s\n", "FP_UH", gp->FP_UH);
     printf("%18s: %f\n", "Velocity_avg", gp->Velocity_avg);
     printf("%18s: %f\n", "Velocity_max", gp->Velocity_max);
@@ -308,6 +483,37 @@ void Print_GlobalPara(
 
     printf("%18s: %s\n", "PATH_OUT", gp->PATH_OUT);
     printf("%18s: %s\n", "FP_OUTNAMELIST", gp->FP_OUTNAMELIST);
+    printf("%18s: %d\n", "CHECKPOINT_STEPS", gp->CHECKPOINT_STEPS);
+    printf("%18s: %s\n", "FP_CHECKPOINT", gp->FP_CHECKPOINT);
+    printf("%18s: %s\n", "FP_STATE_IN", gp->FP_STATE_IN);
+    printf("%18s: %s\n", "FP_STATE_OUT", gp->FP_STATE_OUT);
+    printf("%18s: %d\n", "SPINUP_STEPS", gp->SPINUP_STEPS);
+    printf("%18s: %d\n", "SPINUP_CYCLES_MAX", gp->SPINUP_CYCLES_MAX);
+    printf("%18s: %f\n", "SPINUP_TOL", gp->SPINUP_TOL);
+    printf("%18s: %s\n", "FP_ENSEMBLE", gp->FP_ENSEMBLE);
+    printf("%18s: %s\n", "FP_CALIB", gp->FP_CALIB);
+    printf("%18s: %s\n", "FP_QOBS", gp->FP_QOBS);
+    printf("%18s: %d\n", "CALIB_OUTLET", gp->CALIB_OUTLET);
+    printf("%18s: %s\n", "CALIB_OBJECTIVE", gp->CALIB_OBJECTIVE);
+    printf("%18s: %d\n", "CALIB_WARMUP", gp->CALIB_WARMUP);
+    printf("%18s: %d\n", "CALIB_EARLY_STOP", gp->CALIB_EARLY_STOP);
+    printf("%18s: %f\n", "CALIB_SCORE_MIN", gp->CALIB_SCORE_MIN);
+    printf("%18s: %d\n", "SCEUA_COMPLEXES", gp->SCEUA_COMPLEXES);
+    printf("%18s: %d\n", "SCEUA_EVALS_MAX", gp->SCEUA_EVALS_MAX);
+    printf("%18s: %d\n", "SCEUA_LOOPS_STOP", gp->SCEUA_LOOPS_STOP);
+    printf("%18s: %f\n", "SCEUA_PCENTO", gp->SCEUA_PCENTO);
+    printf("%18s: %f\n", "SCEUA_PEPS", gp->SCEUA_PEPS);
+    printf("%18s: %d\n", "SCEUA_SEED", gp->SCEUA_SEED);
+    printf("%18s: %d\n", "NUM_THREADS", gp->NUM_THREADS);
+    printf("%18s: %d\n", "FORCING_ASYNC", gp->FORCING_ASYNC);
+    printf("%18s: %d\n", "FORCING_BLOCK", gp->FORCING_BLOCK);
+    printf("%18s: %.1f\n", "FORCING_MEMORY", gp->FORCING_MEMORY);
+    printf("%18s: %s\n", "ET_KERNEL", gp->ET_KERNEL);
+    printf("%18s: %s\n", "SOIL_SATU_KERNEL", gp->SOIL_SATU_KERNEL);
+    printf("%18s: %s\n", "SOIL_SATU_SOLVER", gp->SOIL_SATU_SOLVER);
+    printf("%18s: %g\n", "SOIL_SATU_CG_TOL", gp->SOIL_SATU_CG_TOL);
+    printf("%18s: %d\n", "SOIL_SATU_CG_ITER", gp->SOIL_SATU_CG_ITER);
+    printf("%18s: %.2f\n", "SOIL_SATU_CFL", gp->SOIL_SATU_CFL);
 
     printf("%19s %s\n", "***************", "***************");
 }
@@ -17,57 +17,69 @@
 #define HM_ST
 #include "Constants.h"
 
+/******
+ * the cell state variables are stored as structure of arrays:
+ * each member points to a contiguous array over all the raster cells
+ * (cell_counts_total, indexed by index_geo), so that the cell and stencil
+ * kernels only touch the variables they need;
+ * allocated with Allocate_RADIA(), Allocate_ET(), Allocate_SOIL() in Initial_VAR.c
+ */
 typedef struct
 {
     /* variables related to radiation */
-    double Rs;        /* received shortwave radiation, [kJ/m2/h] */
-    double L_sky;     /* received longwave radiation, [kJ/m2/h] */
-    double Rno;       /* net radiation for the overstory, [kJ/m2/h] */
-    double Rno_short; /* net shortwave radiation for the overstory, [kJ/m2/h] */
-    double Rnu;       /* net radiation for the understory, [kJ/m2/h] */
-    double Rnu_short; /* net shortwave radiation for the understory, [kJ/m2/h] */
-    double Rns;       /* net radiation for ground/soil, [kJ/m2/h] */
+    double *Rs;        /* received shortwave radiation, [kJ/m2/h] */
+    double *L_sky;     /* received longwave radiation, [kJ/m2/h] */
+    double *Rno;       /* net radiation for the overstory, [kJ/m2/h] */
+    double *Rno_short; /* net shortwave radiation for the overstory, [kJ/m2/h] */
+    double *Rnu;       /* net radiation for the understory, [kJ/m2/h] */
+    double *Rnu_short; /* net shortwave radiation for the understory, [kJ/m2/h] */
+    double *Rns;       /* net radiation for ground/soil, [kJ/m2/h] */
 } CELL_VAR_RADIA;
 
 typedef struct
 {
     /* variables in evapotranspiration processes */
-    double Prec_throughfall; /* precipitation throughfall from overstory, [m] */
-    double Prec_net;         /* net precipitation from understory into soil process, [m] */
-    double Ep;               /* potential evapotranspiration, [m] */
-    double EI_o;             /* actual evaporation, [m] */
-    double ET_o;             /* actual transpiration, [m] */
-    double EI_u;             /* actual evaporation, [m] */
-    double ET_u;             /* actual transpiration, [m] */
-    double ET_s;             /* soil evaporation, [m] */
-    double Interception_o;   /* overstory interception water, [m] */
-    double Interception_u;   /* understory interception water, [m] */
+    double *Prec_throughfall; /* precipitation throughfall from overstory, [m] */
+    double *Prec_net;         /* net precipitation from understory into soil process, [m] */
+    double *Ep;               /* potential evapotranspiration, [m] */
+    double *EI_o;             /* actual evaporation, [m] */
+    double *ET_o;             /* actual transpiration, [m] */
+    double *EI_u;             /* actual evaporation, [m] */
+    double *ET_u;             /* actual transpiration, [m] */
+    double *ET_s;             /* soil evaporation, [m] */
+    double *Interception_o;   /* overstory interception water, [m] */
+    double *Interception_u;   /* understory interception water, [m] */
 } CELL_VAR_ET;
 
 typedef struct
 {
     /* variables in soil water movement */
-    double SM_Upper;             /* soil moisture: upper soil layer, FRAC */
-    double SM_Lower;             /* soil moisture: lower soil layer, FRAC */
-    double SW_Infiltration;      /* water infiltration from ground surface, [m] */
-    double SW_Percolation_Upper; /* water percolation from upper soil layer, [m] */
-    double SW_Percolation_Lower; /* water percolation from lower soil layer, [m] */
-    double SW_SR_Infil;          /* surface runoff from excess-infiltration, [m] */
-    double SW_SR_Satur;          /* surface runoff from saturation, [m] */
-
-    double z;                    /* the water table of the grid cell, positive downward, [m] */
-    int z_offset;                /* the water table from the reference height, 
-                                    considering DEM difference with neighboring cells, positive downward, [m] */
-    int z_offset_neighbor[8];    /* reference water table of 8 neighboring cells, [m] */
-    double q[8];                 /* outflow from the cell to 8 directions, [m3/h] */
-    int neighbor[8];             /* the status of the 8 neighbors, 1: valid, 0: nodata */
-    double Qout;                 /* total outflow from this cell, [m3/h] */
-    double Qin;                  /* total inflow to this cell, [m3/h] */
-    double SW_rise_lower;        /* water volume suppied by a rising water table to the lower soil layer, [m] */
-    double SW_rise_upper;        /* water volume suppied by a rising water table to the upper soil layer, [m] */
-    double SW_rf;                /* water volume of return flow (generated when a rising water table reaches the ground surface), [m] */
+    double *SM_Upper;             /* soil moisture: upper soil layer, FRAC */
+    double *SM_Lower;             /* soil moisture: lower soil layer, FRAC */
+    double *SW_Infiltration;      /* water infiltration from ground surface, [m] */
+    double *SW_Percolation_Upper; /* water percolation from upper soil layer, [m] */
+    double *SW_Percolation_Lower; /* water percolation from lower soil layer, [m] */
+    double *SW_SR_Infil;          /* surface runoff from excess-infiltration, [m] */
+    double *SW_SR_Satur;          /* surface runoff from saturation, [m] */
+
+    double *z;                    /* the water table of the grid cell, positive downward, [m] */
+    double *q[8];                 /* outflow from the cell to 8 directions, one array per direction, [m3/h] */
+    double *Qout;                 /* total outflow from this cell, [m3/h] */
+    double *Qin;                  /* total inflow to this cell, [m3/h] */
+    double *SW_rise_lower;        /* water volume suppied by a rising water table to the lower soil layer, [m] */
+    double *SW_rise_upper;        /* water volume suppied by a rising water table to the upper soil layer, [m] */
+    double *SW_rf;                /* water volume of return flow (generated when a rising water table reaches the ground surface), [m] */
 } CELL_VAR_SOIL;
 
+typedef struct
+{
+    /* static neighbour metadata for the saturated lateral flow, set by Initialize_Soil_Satur() */
+    int *z_offset;                /* the water table from the reference height, 
+                                     considering DEM difference with neighboring cells, positive downward, [m] */
+    int *z_offset_neighbor[8];    /* reference water table of 8 neighboring cells, one array per direction, [m] */
+    int *neighbor[8];             /* the status of the 8 neighbors, one array per direction, 1: valid, 0: nodata */
+} CELL_NEIGHBOR;
+
 typedef struct
 {
     double k;     /* channel storage parameter, [1/h] */
@@ -79,6 +91,35 @@ typedef struct
     int next_col; /* the col index of downstream cell */
 } CELL_VAR_STREAM;
 
+typedef struct
+{
+    /******
+     * the channel cells (reaches) in topological order of the flow directions
+     * (next_row, next_col): upstream reaches first, grouped by level
+     * (level 0: no upstream reach; level l: longest upstream path of l reaches);
+     * built once by Initialize_Channel_Network()
+     */
+    int reach_count;   /* number of channel cells */
+    int *reach_index;  /* 1D raster index of the channel cells, sorted by level, row-major order within a level */
+    int *up_start;     /* the upstream reaches of reach r: up_index[up_start[r]], ..., up_index[up_start[r + 1] - 1] */
+    int *up_index;     /* 1D raster index of the upstream reaches, row-major order */
+    int level_count;   /* number of levels */
+    int *level_start;  /* the reaches of level l: reach_index[level_start[l]], ..., reach_index[level_start[l + 1] - 1] */
+} CHANNEL_NETWORK;
+
+typedef struct
+{
+    /******
+     * compacted index lists of the cells to be simulated,
+     * built once at start-up so that the per-step kernels
+     * iterate over the catchment rather than the bounding box
+     */
+    int cell_count;    /* number of active cells: valid DEM and SOILTYPE */
+    int *cell_index;   /* 1D raster index (row * ncols + col) of the active cells, row-major order */
+    int stream_count;  /* number of channel cells: STR == 1 */
+    int *stream_index; /* 1D raster index of the channel cells, row-major order */
+} CELL_LIST;
+
 typedef struct
 {
     /******
@@ -148,6 +189,8 @@ typedef struct
     double STREAM_W;
     double WIN_H;
     double ROUTE_CHANNEL_k;
+    char ROUTE_CHANNEL_ORDER[30]; /* LAGGED: upstream outflow of the previous step; TOPO: of the same step, one upstream-to-downstream pass;
+                                     LEVEL: as TOPO, the reaches of a level routed in parallel */
     /* model setup parameters */
     int START_YEAR;
     int START_MONTH;
@@ -161,6 +204,9 @@ typedef struct
     /* UH parameters */
     char FP_UH[MAXCHAR];
     char SURFACE_RUNOFF[30];
+    char UH_MODE[30];   /* BATCH: route the stored runoff series after the simulation; STREAM: route at every step;
+                           CLASS: route at every step, with one UH per flow-time class */
+    double UH_CLASS_WIDTH; /* width of the flow-time classes in CLASS mode, [h] */
     double Velocity_avg;
     double Velocity_max;
     double Velocity_min;
@@ -169,6 +215,39 @@ typedef struct
     /* output parameters */
     char PATH_OUT[MAXCHAR];
     char FP_OUTNAMELIST[MAXCHAR];
+    int CHECKPOINT_STEPS;         /* write the model state to FP_CHECKPOINT every CHECKPOINT_STEPS steps; 0: no checkpoints */
+    char FP_CHECKPOINT[MAXCHAR];  /* checkpoint file, read by "xHM <Global_Para.txt> --restart"; default: PATH_OUT/xHM_checkpoint.bin */
+    char FP_STATE_IN[MAXCHAR];    /* NetCDF state file the run starts from (warm start); empty: uniform initial values */
+    char FP_STATE_OUT[MAXCHAR];   /* NetCDF state file written at the end of the run; empty: not written */
+    int SPINUP_STEPS;             /* spin-up: the first SPINUP_STEPS steps are repeated, without output, before the run; 0: no spin-up */
+    int SPINUP_CYCLES_MAX;        /* maximum number of spin-up cycles */
+    double SPINUP_TOL;            /* spin-up converged: change of the domain mean z [m], SM_Upper and SM_Lower [FRAC] between cycles below SPINUP_TOL */
+    char FP_ENSEMBLE[MAXCHAR];    /* table of parameter sets simulated as an ensemble, see Ensemble.c; empty: a single run */
+    char FP_CALIB[MAXCHAR];       /* calibration (xHM_CALIB): the calibrated parameters and their ranges, see SCEUA.c */
+    char FP_QOBS[MAXCHAR];        /* calibration: observed daily discharge at the outlet CALIB_OUTLET */
+    int CALIB_OUTLET;             /* calibration: the outlet (from 0, order of FP_OUTLET) compared with FP_QOBS */
+    char CALIB_OBJECTIVE[MAXCHAR]; /* calibration: NSE or KGE, of the daily discharge */
+    int CALIB_WARMUP;             /* calibration: the first CALIB_WARMUP steps are not compared */
+    int CALIB_EARLY_STOP;         /* calibration: 1: abort a reflection or contraction run of SCE-UA once its final score cannot win (nor exceed CALIB_SCORE_MIN) */
+    double CALIB_SCORE_MIN;       /* calibration: score floor, a reflection or contraction point not above it is rejected (and its run aborted); -9999: none */
+    int SCEUA_COMPLEXES;          /* SCE-UA: number of complexes, simulated in parallel */
+    int SCEUA_EVALS_MAX;          /* SCE-UA: maximum number of simulations */
+    int SCEUA_LOOPS_STOP;         /* SCE-UA: converged if the best score improved by less than SCEUA_PCENTO in SCEUA_LOOPS_STOP shuffling loops */
+    double SCEUA_PCENTO;
+    double SCEUA_PEPS;            /* SCE-UA: converged if the population spans less than SCEUA_PEPS of the parameter ranges */
+    int SCEUA_SEED;               /* SCE-UA: seed of the random numbers */
+    /* parallel computing parameters */
+    int NUM_THREADS;  /* number of threads for the cell loops; 0: taken from OMP_NUM_THREADS */
+    int FORCING_ASYNC; /* 1: read the forcing of the next step in a background thread; 0: read in the time loop */
+    int FORCING_BLOCK; /* number of forcing steps read per variable and NetCDF call; 0: derived from FORCING_MEMORY */
+    double FORCING_MEMORY; /* memory budget of the forcing buffers, [MB] */
+    char ET_KERNEL[30];        /* evapotranspiration and unsaturated zone of the cells: SCALAR (ET_CELL and UnsaturatedWaterMove, cell by cell),
+                                  BATCH (batches of cells of one kind), or CHECK (BATCH, compared with SCALAR at every cell and step) */
+    char SOIL_SATU_KERNEL[30]; /* outflow kernel of the saturated lateral flow: SIMD (vectorized) or SCALAR */
+    char SOIL_SATU_SOLVER[30]; /* time stepping of the saturated lateral flow: EXPLICIT or IMPLICIT (linearized, solved by PCG) */
+    double SOIL_SATU_CG_TOL;   /* IMPLICIT: PCG tolerance of the residual, relative to the right-hand side */
+    int SOIL_SATU_CG_ITER;     /* IMPLICIT: maximum PCG iterations per step */
+    double SOIL_SATU_CFL;      /* EXPLICIT: safety factor of the stable sub-step, (0, 1]; 0: no sub-stepping */
 } GLOBAL_PARA;
 
 #endif
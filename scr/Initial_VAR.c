@@ -9,58 +9,213 @@
  *               for the members
  * 
  * DESCRIP-END.
- * FUNCTIONS:    Initialize_RADIA();Initialize_ET();
- *               Initialize_SOIL();
+ * FUNCTIONS:    Allocate_RADIA();Allocate_ET();Allocate_SOIL();
+ *               Allocate_NEIGHBOR();Free_RADIA();Free_ET();
+ *               Free_SOIL();Free_NEIGHBOR();
+ *               Initialize_RADIA();Initialize_ET();
+ *               Initialize_SOIL();Initialize_Soil_Satur();
+ *               Initialize_CELL_LIST();
  * 
  * COMMENTS:
- * see the details and member explanation in "HM_ST.h"
+ * see the details and member explanation in "HM_ST.h";
+ * the state structures hold one array per member (structure of arrays),
+ * each of the length cell_counts_total
  * 
  * References:
  * 
  * 
 */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include "HM_ST.h"
 #include "Initial_VAR.h"
 
-void Initialize_RADIA(
+double *Allocate_double(
+    int cell_counts_total)
+{
+    double *data;
+    data = (double *)malloc(sizeof(double) * cell_counts_total);
+    if (data == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    return data;
+}
+
+int *Allocate_int(
+    int cell_counts_total)
+{
+    int *data;
+    data = (int *)malloc(sizeof(int) * cell_counts_total);
+    if (data == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    return data;
+}
+
+void Allocate_RADIA(
+    CELL_VAR_RADIA *st,
+    int cell_counts_total)
+{
+    st->Rs = Allocate_double(cell_counts_total);
+    st->L_sky = Allocate_double(cell_counts_total);
+    st->Rno = Allocate_double(cell_counts_total);
+    st->Rno_short = Allocate_double(cell_counts_total);
+    st->Rnu = Allocate_double(cell_counts_total);
+    st->Rnu_short = Allocate_double(cell_counts_total);
+    st->Rns = Allocate_double(cell_counts_total);
+}
+
+void Allocate_ET(
+    CELL_VAR_ET *st,
+    int cell_counts_total)
+{
+    st->Prec_throughfall = Allocate_double(cell_counts_total);
+    st->Prec_net = Allocate_double(cell_counts_total);
+    st->Ep = Allocate_double(cell_counts_total);
+    st->EI_o = Allocate_double(cell_counts_total);
+    st->ET_o = Allocate_double(cell_counts_total);
+    st->EI_u = Allocate_double(cell_counts_total);
+    st->ET_u = Allocate_double(cell_counts_total);
+    st->ET_s = Allocate_double(cell_counts_total);
+    st->Interception_o = Allocate_double(cell_counts_total);
+    st->Interception_u = Allocate_double(cell_counts_total);
+}
+
+void Allocate_SOIL(
+    CELL_VAR_SOIL *st,
+    int cell_counts_total)
+{
+    st->SM_Upper = Allocate_double(cell_counts_total);
+    st->SM_Lower = Allocate_double(cell_counts_total);
+    st->SW_Infiltration = Allocate_double(cell_counts_total);
+    st->SW_Percolation_Upper = Allocate_double(cell_counts_total);
+    st->SW_Percolation_Lower = Allocate_double(cell_counts_total);
+    st->SW_SR_Infil = Allocate_double(cell_counts_total);
+    st->SW_SR_Satur = Allocate_double(cell_counts_total);
+    st->z = Allocate_double(cell_counts_total);
+    for (size_t k = 0; k < 8; k++)
+    {
+        st->q[k] = Allocate_double(cell_counts_total);
+    }
+    st->Qout = Allocate_double(cell_counts_total);
+    st->Qin = Allocate_double(cell_counts_total);
+    st->SW_rise_lower = Allocate_double(cell_counts_total);
+    st->SW_rise_upper = Allocate_double(cell_counts_total);
+    st->SW_rf = Allocate_double(cell_counts_total);
+}
+
+void Allocate_NEIGHBOR(
+    CELL_NEIGHBOR *st,
+    int cell_counts_total)
+{
+    st->z_offset = Allocate_int(cell_counts_total);
+    for (size_t k = 0; k < 8; k++)
+    {
+        st->z_offset_neighbor[k] = Allocate_int(cell_counts_total);
+        st->neighbor[k] = Allocate_int(cell_counts_total);
+    }
+}
+
+void Free_RADIA(
     CELL_VAR_RADIA *st)
 {
-    for (size_t i = 0; i < sizeof(st) / sizeof(double); i++)
+    free(st->Rs); free(st->L_sky); free(st->Rno); free(st->Rno_short);
+    free(st->Rnu); free(st->Rnu_short); free(st->Rns);
+}
+
+void Free_ET(
+    CELL_VAR_ET *st)
+{
+    free(st->Prec_throughfall); free(st->Prec_net); free(st->Ep);
+    free(st->EI_o); free(st->ET_o); free(st->EI_u); free(st->ET_u); free(st->ET_s);
+    free(st->Interception_o); free(st->Interception_u);
+}
+
+void Free_SOIL(
+    CELL_VAR_SOIL *st)
+{
+    free(st->SM_Upper); free(st->SM_Lower); free(st->SW_Infiltration);
+    free(st->SW_Percolation_Upper); free(st->SW_Percolation_Lower);
+    free(st->SW_SR_Infil); free(st->SW_SR_Satur); free(st->z);
+    for (size_t k = 0; k < 8; k++)
+    {
+        free(st->q[k]);
+    }
+    free(st->Qout); free(st->Qin);
+    free(st->SW_rise_lower); free(st->SW_rise_upper); free(st->SW_rf);
+}
+
+void Free_NEIGHBOR(
+    CELL_NEIGHBOR *st)
+{
+    free(st->z_offset);
+    for (size_t k = 0; k < 8; k++)
+    {
+        free(st->z_offset_neighbor[k]);
+        free(st->neighbor[k]);
+    }
+}
+
+void Initialize_RADIA(
+    CELL_VAR_RADIA *st,
+    int cell_counts_total)
+{
+    for (size_t i = 0; i < cell_counts_total; i++)
     {
-        double *currentMember = ((double *)st) + i;
-        *currentMember = 0.0;
+        *(st->Rs + i) = 0.0;
+        *(st->L_sky + i) = 0.0;
+        *(st->Rno + i) = 0.0;
+        *(st->Rno_short + i) = 0.0;
+        *(st->Rnu + i) = 0.0;
+        *(st->Rnu_short + i) = 0.0;
+        *(st->Rns + i) = 0.0;
     }
 }
 
 void Initialize_ET(
-    CELL_VAR_ET *st)
+    CELL_VAR_ET *st,
+    int cell_counts_total)
 {
-    for (size_t i = 0; i < sizeof(st) / sizeof(double); i++)
+    for (size_t i = 0; i < cell_counts_total; i++)
     {
-        double *currentMember = ((double *)st) + i;
-        *currentMember = 0.0;
+        *(st->Prec_throughfall + i) = 0.0;
+        *(st->Prec_net + i) = 0.0;
+        *(st->Ep + i) = 0.0;
+        *(st->EI_o + i) = 0.0;
+        *(st->ET_o + i) = 0.0;
+        *(st->EI_u + i) = 0.0;
+        *(st->ET_u + i) = 0.0;
+        *(st->ET_s + i) = 0.0;
+        *(st->Interception_o + i) = 0.0;
+        *(st->Interception_u + i) = 0.0;
     }
-    st->Interception_o = 0.0;
-    st->Interception_u = 0.0;
 }
 
 void Initialize_SOIL(
-    CELL_VAR_SOIL *st)
+    CELL_VAR_SOIL *st,
+    int cell_counts_total)
 {
-    st->SW_Infiltration = 0.0;
-    st->SW_Percolation_Lower = 0.0;
-    st->SW_Percolation_Upper = 0.0;
-    st->SW_SR_Infil = 0.0;
-    st->SW_SR_Satur = 0.0;
-    st->SM_Lower = 0.4;
-    st->SM_Upper = 0.4;
+    for (size_t i = 0; i < cell_counts_total; i++)
+    {
+        *(st->SW_Infiltration + i) = 0.0;
+        *(st->SW_Percolation_Lower + i) = 0.0;
+        *(st->SW_Percolation_Upper + i) = 0.0;
+        *(st->SW_SR_Infil + i) = 0.0;
+        *(st->SW_SR_Satur + i) = 0.0;
+        *(st->SM_Lower + i) = 0.4;
+        *(st->SM_Upper + i) = 0.4;
+    }
 }
 
 
 void Initialize_Soil_Satur(
     CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
     int *data_DEM,
     int NODATA_value,
     int ncols,
@@ -80,12 +235,12 @@ void Initialize_Soil_Satur(
 
             if (*(data_DEM + index_geo) != NODATA_value)
             {
-                (data_SOIL + index_geo)->z = 0.05;
-                (data_SOIL + index_geo)->Qin = 0.0;
-                (data_SOIL + index_geo)->Qout = 0.0;
-                (data_SOIL + index_geo)->SW_rf = 0.0;
-                (data_SOIL + index_geo)->SW_rise_lower = 0.0;
-                (data_SOIL + index_geo)->SW_rise_upper = 0.0;
+                *(data_SOIL->z + index_geo) = 0.05;
+                *(data_SOIL->Qin + index_geo) = 0.0;
+                *(data_SOIL->Qout + index_geo) = 0.0;
+                *(data_SOIL->SW_rf + index_geo) = 0.0;
+                *(data_SOIL->SW_rise_lower + index_geo) = 0.0;
+                *(data_SOIL->SW_rise_upper + index_geo) = 0.0;
                 // the 8 neighbos of the central cell
                 index_geo_neighbor[0] = (i - 1) * ncols + j - 1;
                 index_geo_neighbor[1] = (i - 1) * ncols + j;
@@ -99,42 +254,42 @@ void Initialize_Soil_Satur(
                 for (size_t k = 0; k < 8; k++)
                 {
                     // initialize the neighbor: all 1
-                    (data_SOIL + index_geo)->neighbor[k] = 1;
+                    *(data_NEIGHBOR->neighbor[k] + index_geo) = 1;
                 }
                 // identify the boundary cells
                 if (i == 0)
                 {
-                    (data_SOIL + index_geo)->neighbor[0] = 0;
-                    (data_SOIL + index_geo)->neighbor[1] = 0;
-                    (data_SOIL + index_geo)->neighbor[2] = 0;
+                    *(data_NEIGHBOR->neighbor[0] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[1] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[2] + index_geo) = 0;
                 }
                 else if (i == (nrows - 1))
                 {
-                    (data_SOIL + index_geo)->neighbor[4] = 0;
-                    (data_SOIL + index_geo)->neighbor[5] = 0;
-                    (data_SOIL + index_geo)->neighbor[6] = 0;
+                    *(data_NEIGHBOR->neighbor[4] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[5] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[6] + index_geo) = 0;
                 }
                 if (j == 0)
                 {
-                    (data_SOIL + index_geo)->neighbor[0] = 0;
-                    (data_SOIL + index_geo)->neighbor[6] = 0;
-                    (data_SOIL + index_geo)->neighbor[7] = 0;
+                    *(data_NEIGHBOR->neighbor[0] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[6] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[7] + index_geo) = 0;
                 }
                 else if (j == (ncols - 1))
                 {
-                    (data_SOIL + index_geo)->neighbor[2] = 0;
-                    (data_SOIL + index_geo)->neighbor[3] = 0;
-                    (data_SOIL + index_geo)->neighbor[4] = 0;
+                    *(data_NEIGHBOR->neighbor[2] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[3] + index_geo) = 0;
+                    *(data_NEIGHBOR->neighbor[4] + index_geo) = 0;
                 }
                 
                 for (size_t k = 0; k < 8; k++)
                 {
                     // cell with NODATA_value neighbors
-                    if ((data_SOIL + index_geo)->neighbor[k] == 1)
+                    if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
                     {
                         if (*(data_DEM + index_geo_neighbor[k]) == NODATA_value)
                         {
-                            (data_SOIL + index_geo)->neighbor[k] = 0;
+                            *(data_NEIGHBOR->neighbor[k] + index_geo) = 0;
                         }
                     }
                 }
@@ -146,7 +301,7 @@ void Initialize_Soil_Satur(
                 DEM8_max = *(data_DEM + index_geo);
                 for (size_t k = 0; k < 8; k++)
                 {
-                    if ((data_SOIL + index_geo)->neighbor[k] == 1)
+                    if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
                     {
                         if (DEM8_max < *(data_DEM + index_geo_neighbor[k]))
                         {
@@ -155,37 +310,102 @@ void Initialize_Soil_Satur(
                     }
                 }
                 // calculate the offset of height (DEM)
-                (data_SOIL + index_geo)->z_offset = DEM8_max - *(data_DEM + index_geo);
+                *(data_NEIGHBOR->z_offset + index_geo) = DEM8_max - *(data_DEM + index_geo);
                 for (size_t k = 0; k < 8; k++) 
                 {
-                    if ((data_SOIL + index_geo)->neighbor[k] == 1)
+                    if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
                     {
-                        (data_SOIL + index_geo)->z_offset_neighbor[k] = DEM8_max - *(data_DEM + index_geo_neighbor[k]);
-                        (data_SOIL + index_geo)->q[k] = 0.0;
+                        *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) = DEM8_max - *(data_DEM + index_geo_neighbor[k]);
+                        *(data_SOIL->q[k] + index_geo) = 0.0;
                     } else
                     {
-                        (data_SOIL + index_geo)->z_offset_neighbor[k] = NODATA_value;
-                        (data_SOIL + index_geo)->q[k] = (double)NODATA_value;
+                        *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) = NODATA_value;
+                        *(data_SOIL->q[k] + index_geo) = (double)NODATA_value;
                     }
                 }
             }
             else
             {
                 // NODATA_value: outside the mask
-                (data_SOIL + index_geo)->z = (double)NODATA_value;
-                (data_SOIL + index_geo)->Qin = (double)NODATA_value;
-                (data_SOIL + index_geo)->Qout = (double)NODATA_value;
-                (data_SOIL + index_geo)->z_offset = NODATA_value;
-                (data_SOIL + index_geo)->SW_rf = (double)NODATA_value;
-                (data_SOIL + index_geo)->SW_rise_lower = (double)NODATA_value;
-                (data_SOIL + index_geo)->SW_rise_upper = (double)NODATA_value;
+                *(data_SOIL->z + index_geo) = (double)NODATA_value;
+                *(data_SOIL->Qin + index_geo) = (double)NODATA_value;
+                *(data_SOIL->Qout + index_geo) = (double)NODATA_value;
+                *(data_NEIGHBOR->z_offset + index_geo) = NODATA_value;
+                *(data_SOIL->SW_rf + index_geo) = (double)NODATA_value;
+                *(data_SOIL->SW_rise_lower + index_geo) = (double)NODATA_value;
+                *(data_SOIL->SW_rise_upper + index_geo) = (double)NODATA_value;
                 for (size_t k = 0; k < 8; k++)
                 {
-                    (data_SOIL + index_geo)->neighbor[k] = 0;
-                    (data_SOIL + index_geo)->z_offset_neighbor[k] = NODATA_value;
-                    (data_SOIL + index_geo)->q[k] = (double)NODATA_value;
+                    *(data_NEIGHBOR->neighbor[k] + index_geo) = 0;
+                    *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) = NODATA_value;
+                    *(data_SOIL->q[k] + index_geo) = (double)NODATA_value;
                 }
             }
         }
     }
 }
+
+void Initialize_CELL_LIST(
+    CELL_LIST *cell_list,
+    int *data_DEM,
+    int *data_SOILTYPE,
+    int *data_STR,
+    int NODATA_value,
+    int ncols,
+    int nrows)
+{
+    /**********
+     * collect the active cells (valid DEM and SOILTYPE) 
+     * and the channel cells (STR == 1) into compacted index lists,
+     * keeping the row-major order of the raster;
+     * every cell of valid DEM needs a SOILTYPE: the saturated lateral
+     * flow covers all of them (and looks up their soil parameters),
+     * so the active cells are exactly the cells of valid DEM
+     */
+    int cell_counts_total;
+    cell_counts_total = ncols * nrows;
+    int index_geo;
+
+    cell_list->cell_count = 0;
+    cell_list->stream_count = 0;
+    for (index_geo = 0; index_geo < cell_counts_total; index_geo++)
+    {
+        if (*(data_DEM + index_geo) != NODATA_value && *(data_SOILTYPE + index_geo) == NODATA_value)
+        {
+            printf("Error: no SOILTYPE at the cell %d (row %d, col %d) of valid DEM\n",
+                   index_geo, index_geo / ncols, index_geo % ncols);
+            exit(0);
+        }
+        if (*(data_DEM + index_geo) != NODATA_value && *(data_SOILTYPE + index_geo) != NODATA_value)
+        {
+            cell_list->cell_count += 1;
+        }
+        if (*(data_STR + index_geo) == 1)
+        {
+            cell_list->stream_count += 1;
+        }
+    }
+    cell_list->cell_index = (int *)malloc(sizeof(int) * (cell_list->cell_count + 1));
+    cell_list->stream_index = (int *)malloc(sizeof(int) * (cell_list->stream_count + 1));
+    if (cell_list->cell_index == NULL || cell_list->stream_index == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+
+    cell_list->cell_count = 0;
+    cell_list->stream_count = 0;
+    for (index_geo = 0; index_geo < cell_counts_total; index_geo++)
+    {
+        if (*(data_DEM + index_geo) != NODATA_value && *(data_SOILTYPE + index_geo) != NODATA_value)
+        {
+            *(cell_list->cell_index + cell_list->cell_count) = index_geo;
+            cell_list->cell_count += 1;
+        }
+        if (*(data_STR + index_geo) == 1)
+        {
+            *(cell_list->stream_index + cell_list->stream_count) = index_geo;
+            cell_list->stream_count += 1;
+        }
+    }
+}
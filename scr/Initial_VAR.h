@@ -4,18 +4,65 @@
 
 #include "HM_ST.h"
 
-void Initialize_RADIA(
+double *Allocate_double(
+    int cell_counts_total);
+
+int *Allocate_int(
+    int cell_counts_total);
+
+void Allocate_RADIA(
+    CELL_VAR_RADIA *st,
+    int cell_counts_total);
+
+void Allocate_ET(
+    CELL_VAR_ET *st,
+    int cell_counts_total);
+
+void Allocate_SOIL(
+    CELL_VAR_SOIL *st,
+    int cell_counts_total);
+
+void Allocate_NEIGHBOR(
+    CELL_NEIGHBOR *st,
+    int cell_counts_total);
+
+void Free_RADIA(
     CELL_VAR_RADIA *st);
 
-void Initialize_ET(
+void Free_ET(
     CELL_VAR_ET *st);
 
-void Initialize_SOIL(
+void Free_SOIL(
     CELL_VAR_SOIL *st);
 
+void Free_NEIGHBOR(
+    CELL_NEIGHBOR *st);
+
+void Initialize_RADIA(
+    CELL_VAR_RADIA *st,
+    int cell_counts_total);
+
+void Initialize_ET(
+    CELL_VAR_ET *st,
+    int cell_counts_total);
+
+void Initialize_SOIL(
+    CELL_VAR_SOIL *st,
+    int cell_counts_total);
+
 void Initialize_Soil_Satur(
     CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    int *data_DEM,
+    int NODATA_value,
+    int ncols,
+    int nrows);
+
+void Initialize_CELL_LIST(
+    CELL_LIST *cell_list,
     int *data_DEM,
+    int *data_SOILTYPE,
+    int *data_STR,
     int NODATA_value,
     int ncols,
     int nrows);
@@ -9,7 +9,7 @@
  *               derive the full set parameters for the grid cell, 
  * DESCRIP-END.
  * FUNCTIONS:    Import_soillib(); Import_soil_HWSD_ID(); Lookup_Soil_ID(); 
- *               Lookup_Soil_CELL()
+ *               Lookup_Soil_CELL(); Derive_Soil_Para_CELL()
  * 
  * COMMENTS:
  * 
@@ -174,6 +174,46 @@ void Lookup_Soil_CELL(
     soil_cell_para->Subsoil = &(soillib[S_USDA_TEX_CLASS - 1]);
 }
 
+void Derive_Soil_Para_CELL(
+    ST_SOIL_LIB_CELL *soil_cell_lib,
+    ST_SOIL_PARA_CELL *soil_cell_para
+)
+{
+    /**************
+     * convert the library parameters of a grid cell (%Vol, b, air-entry pressure)
+     * into the fractions, exponents and effective tension that the
+     * infiltration, percolation, desorption and saturated flow kernels use;
+     * called once per cell at start-up
+    */
+    ST_SoilLib *Topsoil = soil_cell_lib->Topsoil;
+    ST_SoilLib *Subsoil = soil_cell_lib->Subsoil;
+    double Air_Entry_Pres;
+
+    soil_cell_para->Porosity_upper = Topsoil->Porosity / 100;
+    soil_cell_para->Porosity_lower = Subsoil->Porosity / 100;
+    soil_cell_para->Residual_upper = Topsoil->Residual / 100;
+    soil_cell_para->Residual_lower = Subsoil->Residual / 100;
+    soil_cell_para->WiltingPoint = Topsoil->WiltingPoint / 100;
+    soil_cell_para->FieldCapacity = Topsoil->FieldCapacity / 100;
+
+    soil_cell_para->Ksat_upper = Topsoil->SatHydrauCond;
+    soil_cell_para->Ksat_lower = Subsoil->SatHydrauCond;
+    soil_cell_para->BC_exp_upper = 2 * Topsoil->PoreSizeDisP + 3;
+    soil_cell_para->BC_exp_lower = 2 * Subsoil->PoreSizeDisP + 3;
+    soil_cell_para->PoreSize_index = 1.0 / Topsoil->PoreSizeDisP;
+    soil_cell_para->Bubbling = Topsoil->Bubbling;
+
+    // effective tension at the wetting front, from the topsoil air-entry pressure
+    Air_Entry_Pres = Topsoil->AirEntryPresHead;
+    if (Air_Entry_Pres < 0.0) {
+        Air_Entry_Pres = - Air_Entry_Pres;
+    }
+    soil_cell_para->Tension_effective = (2 * Topsoil->PoreSizeDisP + 3) / (2 * Topsoil->PoreSizeDisP + 6) * Air_Entry_Pres;
+
+    soil_cell_para->Ksat_lateral = Topsoil->SatHydrauCond_Lateral;
+    soil_cell_para->DecayCoeff = Topsoil->DecayCoeff;
+}
+
 
 // void main()
 // {
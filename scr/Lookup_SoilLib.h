@@ -46,6 +46,30 @@ typedef struct
     ST_SoilLib *Subsoil;
 } ST_SOIL_LIB_CELL;
 
+typedef struct 
+{
+    /******
+     * the soil parameters of a grid cell in the units the soil kernels use,
+     * derived once at start-up from ST_SOIL_LIB_CELL by Derive_Soil_Para_CELL(),
+     * so that the time loop does not look up or convert the soil library
+     */
+    double Porosity_upper;        /* topsoil porosity, [fraction] */
+    double Porosity_lower;        /* subsoil porosity, [fraction] */
+    double Residual_upper;        /* topsoil residual content, [fraction] */
+    double Residual_lower;        /* subsoil residual content, [fraction] */
+    double WiltingPoint;          /* topsoil wilting point, [fraction] */
+    double FieldCapacity;         /* topsoil field capacity, [fraction] */
+    double Ksat_upper;            /* topsoil vertical saturated hydraulic conductivity, [m/h] */
+    double Ksat_lower;            /* subsoil vertical saturated hydraulic conductivity, [m/h] */
+    double BC_exp_upper;          /* topsoil Brooks-Corey conductivity exponent, 2b+3 */
+    double BC_exp_lower;          /* subsoil Brooks-Corey conductivity exponent, 2b+3 */
+    double PoreSize_index;        /* topsoil pore-size distribution index, 1/b */
+    double Bubbling;              /* topsoil bubbling pressure, [cm] */
+    double Tension_effective;     /* topsoil effective tension at the wetting front, [cm] */
+    double Ksat_lateral;          /* lateral saturated hydraulic conductivity at the soil surface, [m/h] */
+    double DecayCoeff;            /* decaying coefficient of lateral saturated hydraulic conductivity */
+} ST_SOIL_PARA_CELL;
+
 
 void Import_soillib(
     char FP[],
@@ -71,4 +95,9 @@ void Lookup_Soil_CELL(
     ST_SoilID soilID[]
 );
 
+void Derive_Soil_Para_CELL(
+    ST_SOIL_LIB_CELL *soil_cell_lib,
+    ST_SOIL_PARA_CELL *soil_cell_para
+);
+
 #endif
\ No newline at end of file
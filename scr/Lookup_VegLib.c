@@ -7,7 +7,8 @@
  * ORIG-DATE:    Dec-2023
  * DESCRIPTION:  Calculate evapotranspiration
  * DESCRIP-END.
- * FUNCTIONS:    Import_veglib(), LookUp_veglib()
+ * FUNCTIONS:    Import_veglib(), LookUp_veglib(), Lookup_VegLib_TYPE(),
+ *               Lookup_VegLib_CLASS(), Lookup_VegLib_Table()
  *                  
  * 
  * COMMENTS:
@@ -29,9 +30,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include "Constants.h"
 #include "Evapotranspiration_ST.h"
 #include "Lookup_VegLib.h"
+#include "Resistance.h"
 
 void Import_veglib(
     char FP[],
@@ -159,17 +162,17 @@ void Lookup_VegLib_TYPE(
     *WIND_H = cell->WIND_H;
 }
 
-void Lookup_VegLib_CELL(
+void Lookup_VegLib_CLASS(
     ST_VegLib veglib[],
     int CLASS,
-    ST_CELL_VEG *cell_veg
+    ST_VEG_CLASS veg_mon[]
 )
 {
     /************************
-     * retrieve veg parameters to a certain cell:
-     * the veg parameter lib for a given cell is represented  
-     *      as a structure (ST_CELL_VEG *cell_veg), 
-     *      see "Evapotranspiration_ET.h". 
+     * retrieve veg parameters of a vegetation class:
+     * the 12 months of the class are represented  
+     *      as a structure array (ST_VEG_CLASS veg_mon[12]), 
+     *      see "Evapotranspiration_ST.h". 
      * 
      * Pparameters obtained: 
      * - Rpc
@@ -180,22 +183,24 @@ void Lookup_VegLib_CELL(
      * attention: the parameters are constant through seasons
     */
     double BUF1, BUF2;
-    cell_veg->Rpc = 30.0; // same for veg types, [W/m2];
+    ST_VEG_CLASS veg;   // the seasonally constant parameters
+    memset(&veg, 0, sizeof(ST_VEG_CLASS));
+    veg.Rpc = 30.0; // same for veg types, [W/m2];
     if (CLASS >=1 && CLASS <= 6)
     {
         // canopy (overstory == 1), both overstory and understory
-        cell_veg->Understory = 1; 
+        veg.Understory = 1; 
         Lookup_VegLib_TYPE(
             veglib, CLASS, 
-            &(cell_veg->rs_min_o),
-            &(cell_veg->CAN_H),
-            &(cell_veg->CAN_RZ)
+            &(veg.rs_min_o),
+            &(veg.CAN_H),
+            &(veg.CAN_RZ)
         );
         
         // just assume the understory as grassland (CLASS == 10)
         Lookup_VegLib_TYPE(
             veglib, 10, 
-            &(cell_veg->rs_min_u),
+            &(veg.rs_min_u),
             &BUF1,
             &BUF2
             /* the understory height or wind speed observation height not involved
@@ -205,30 +210,32 @@ void Lookup_VegLib_CELL(
     else if (CLASS > 6 && CLASS <= 11)
     {
         // no overstory, only understory
-        cell_veg->Understory = 1; 
-        cell_veg->rs_min_o = 0.0;
-        cell_veg->CAN_H = 0.0;
-        cell_veg->CAN_RZ = 0.0;
+        veg.Understory = 1; 
+        veg.rs_min_o = 0.0;
+        veg.CAN_H = 0.0;
+        veg.CAN_RZ = 0.0;
         Lookup_VegLib_TYPE(
             veglib, 10, 
-            &(cell_veg->rs_min_u),
-            &(cell_veg->CAN_H),
-            &(cell_veg->CAN_RZ)
+            &(veg.rs_min_u),
+            &(veg.CAN_H),
+            &(veg.CAN_RZ)
         );
     } 
     else if (CLASS == 0)
     {
         // actually this cell is open water
         // the model assumes it as bare soil, at present
-        cell_veg->Understory = 0; 
-        // cell_veg->z0_u = 0.0012;
-        // cell_veg->d_u = 0.0;
+        veg.Understory = 0; 
     }
     else
     {
         printf("Unrecognized vegetation type: %d. Program failled\n", CLASS);
         exit(0);
     }
+    for (size_t i = 0; i < 12; i++)
+    {
+        veg_mon[i] = veg;
+    }
 
     ST_VegLib *cell;
     ST_VegLib *cell_u;
@@ -238,16 +245,16 @@ void Lookup_VegLib_CELL(
         for (size_t i = 0; i < 12; i++)
         {
             // overstory
-            cell_veg->LAI_o[i] = cell->LAI[i];
-            cell_veg->z0_o[i] = cell->Roughness[i];
-            cell_veg->Albedo_o[i] = cell->Albedo[i];
-            cell_veg->d_o[i] = cell->Displacement[i];
+            veg_mon[i].LAI_o = cell->LAI[i];
+            veg_mon[i].z0_o = cell->Roughness[i];
+            veg_mon[i].Albedo_o = cell->Albedo[i];
+            veg_mon[i].d_o = cell->Displacement[i];
             // understory
             cell_u = veglib + 10 - 1;
-            cell_veg->LAI_u[i] = cell_u->LAI[i];
-            cell_veg->z0_u[i] = cell_u->Roughness[i];
-            cell_veg->Albedo_u[i] = cell_u->Albedo[i];
-            cell_veg->d_u[i] = cell_u->Displacement[i];
+            veg_mon[i].LAI_u = cell_u->LAI[i];
+            veg_mon[i].z0_u = cell_u->Roughness[i];
+            veg_mon[i].Albedo_u = cell_u->Albedo[i];
+            veg_mon[i].d_u = cell_u->Displacement[i];
         }
     }
     else if (CLASS > 6 && CLASS <= 11)
@@ -256,26 +263,52 @@ void Lookup_VegLib_CELL(
         for (size_t i = 0; i < 12; i++)
         {
             // only understory
-            cell_veg->LAI_u[i] = cell->LAI[i];
-            cell_veg->z0_u[i] = cell->Roughness[i];
-            cell_veg->Albedo_u[i] = cell->Albedo[i];
-            cell_veg->d_u[i] = cell->Displacement[i];
+            veg_mon[i].LAI_u = cell->LAI[i];
+            veg_mon[i].z0_u = cell->Roughness[i];
+            veg_mon[i].Albedo_u = cell->Albedo[i];
+            veg_mon[i].d_u = cell->Displacement[i];
         }
     }
-    else if (CLASS == 0)
+    else
     {
-        // treated as bare soil/ground
+        // CLASS == 0: treated as bare soil/ground
         for (size_t i = 0; i < 12; i++)
         {
-            cell_veg->z0_u[i] = 0.05;
-            cell_veg->Albedo_u[i] = 0.159;
-            cell_veg->d_u[i] = 0.2;
+            veg_mon[i].z0_u = 0.05;
+            veg_mon[i].Albedo_u = 0.159;
+            veg_mon[i].d_u = 0.2;
         }
     }
-    else
+}
+
+void Lookup_VegLib_Table(
+    ST_VegLib veglib[],
+    double ws_obs_z,
+    ST_VEG_CLASS *veg_table
+)
+{
+    /************************
+     * the vegetation parameters of all the classes and months,
+     * veg_table[CLASS * 12 + month - 1], VEG_CLASS_COUNT * 12 entries;
+     * the cells only keep their class (and canopy fraction), 
+     * and the logarithms of the aerodynamic resistances and the shortwave
+     * transmission of the stories are computed here
+     * once per class and month rather than per cell and step
+    */
+    ST_VEG_CLASS *veg;
+    for (int CLASS = 0; CLASS < VEG_CLASS_COUNT; CLASS++)
     {
-        printf("Unrecognized vegetation type: %d. Program failled\n", CLASS);
-        exit(0);
+        Lookup_VegLib_CLASS(veglib, CLASS, veg_table + CLASS * 12);
+        for (size_t i = 0; i < 12; i++)
+        {
+            veg = veg_table + CLASS * 12 + i;
+            Resist_aero_Pre(
+                ws_obs_z, veg->CAN_RZ,
+                veg->d_o, veg->z0_o, veg->d_u, veg->z0_u,
+                &veg->aero);
+            veg->Tau_o = exp( - veg->LAI_o);
+            veg->Tau_u = exp( - veg->LAI_u);
+        }
     }
 }
 
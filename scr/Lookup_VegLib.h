@@ -52,10 +52,16 @@ void Lookup_VegLib_TYPE(
     double *WIND_H
 );
 
-void Lookup_VegLib_CELL(
+void Lookup_VegLib_CLASS(
     ST_VegLib veglib[],
     int CLASS,
-    ST_CELL_VEG *cell_veg
+    ST_VEG_CLASS veg_mon[]
+);
+
+void Lookup_VegLib_Table(
+    ST_VegLib veglib[],
+    double ws_obs_z,
+    ST_VEG_CLASS *veg_table
 );
 
 // void Lookup_VegLib_CELL_MON(
@@ -11,7 +11,9 @@
  *               to NetCDF files
  * DESCRIP-END.
  * FUNCTIONS:    Import_Outnamelist(); Initialize_Outnamelist(); 
- *               malloc_Outnamelist(); Write2NC_Outnamelist()
+ *               malloc_Outnamelist(); Write2NC_Outnamelist();
+ *               malloc_Outnamelist_Runoff(); Write_Outnamelist_Runoff(); OUTVAR_nc_close_Runoff()
+ *               OUTVAR_nc_sync()
  * 
  * COMMENTS:
  * - read the outnamelist.txt file
@@ -249,9 +251,11 @@ void malloc_Outnamelist(
     int **out_SW_SUB_rise_lower, 
     int **out_SW_SUB_rf,
     int **out_SW_SUB_Qc,
-    int **out_Q_Channel
+    int **out_Q_Channel,
+    int restart
 )
 {
+    /* restart = 1: resume a run from a checkpoint, reopen the nc files written so far */
     long size;
     size = 1 * cell_counts_total; // size = time_steps_run * cell_counts_total;
     char FP_OUT_VAR[MAXCHAR];
@@ -264,7 +268,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Rs.nc");
         outnl_ncid->Rs = OUTVAR_nc_create("Rs", "kJ/m2/h", "canopy received shortwave radiation", 0.1,
-                                         FP_OUT_VAR, time_steps_run, GP);
+                                         FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.L_sky == 1)
     {
@@ -274,7 +278,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "L_sky.nc");
         outnl_ncid->L_sky = OUTVAR_nc_create("L_sky", "kJ/m2/h", "canopy received longwave radiation", 0.1,
-                                            FP_OUT_VAR, time_steps_run, GP);
+                                            FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.Rno == 1)
     {
@@ -284,7 +288,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Rno.nc");
         outnl_ncid->Rno = OUTVAR_nc_create("Rno", "kJ/m2/h", "canopy received net radiation", 0.1,
-                                          FP_OUT_VAR, time_steps_run, GP);
+                                          FP_OUT_VAR, time_steps_run, GP, restart);
     }
 
     if (outnl.Rnu == 1)
@@ -295,7 +299,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Rnu.nc");
         outnl_ncid->Rnu = OUTVAR_nc_create("Rnu", "kJ/m2/h", "understory received net radiation", 0.1,
-                                          FP_OUT_VAR, time_steps_run, GP);
+                                          FP_OUT_VAR, time_steps_run, GP, restart);
     }
     // ET variables
     if (outnl.Ep == 1)
@@ -306,7 +310,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Ep.nc");
         outnl_ncid->Ep = OUTVAR_nc_create("Ep", "mm", "potential evapotranspiration", 0.1,
-                                         FP_OUT_VAR, time_steps_run, GP);
+                                         FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.EI_o == 1)
     {
@@ -316,7 +320,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "EI_o.nc");
         outnl_ncid->EI_o = OUTVAR_nc_create("EI_o", "mm", "overstory evaporation", 0.1,
-                                           FP_OUT_VAR, time_steps_run, GP);
+                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.EI_u == 1)
     {
@@ -326,7 +330,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "EI_u.nc");
         outnl_ncid->EI_u = OUTVAR_nc_create("EI_u", "mm", "understory evaporation", 0.1,
-                                           FP_OUT_VAR, time_steps_run, GP);
+                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.ET_o == 1)
     {
@@ -336,7 +340,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "ET_o.nc");
         outnl_ncid->ET_o = OUTVAR_nc_create("ET_o", "mm", "overstory transpiration", 0.1,
-                                           FP_OUT_VAR, time_steps_run, GP);
+                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.ET_u == 1)
     {
@@ -346,7 +350,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "ET_u.nc");
         outnl_ncid->ET_u = OUTVAR_nc_create("ET_u", "mm", "understory transpiration", 0.1,
-                                           FP_OUT_VAR, time_steps_run, GP);
+                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.ET_s == 1)
     {
@@ -356,7 +360,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "ET_s.nc");
         outnl_ncid->ET_s = OUTVAR_nc_create("ET_s", "mm", "soil evaporation", 0.1,
-                                           FP_OUT_VAR, time_steps_run, GP);
+                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.Interception_o == 1)
     {
@@ -366,7 +370,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Interception_o.nc");
         outnl_ncid->Interception_o = OUTVAR_nc_create("Interception_o", "mm", "intercepted water by overstory", 0.1,
-                                                     FP_OUT_VAR, time_steps_run, GP);
+                                                     FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.Interception_u == 1)
     {
@@ -376,7 +380,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Interception_u.nc");
         outnl_ncid->Interception_u = OUTVAR_nc_create("Interception_u", "mm", "intercepted water by understory", 0.1,
-                                                     FP_OUT_VAR, time_steps_run, GP);
+                                                     FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.Prec_net == 1)
     {
@@ -386,7 +390,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Prec_net.nc");
         outnl_ncid->Prec_net = OUTVAR_nc_create("Prec_net", "mm", "net precipitation", 0.1,
-                                               FP_OUT_VAR, time_steps_run, GP);
+                                               FP_OUT_VAR, time_steps_run, GP, restart);
     }
     // soil variables
     if (outnl.SM_Lower == 1)
@@ -397,7 +401,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SM_Lower.nc");
         outnl_ncid->SM_Lower = OUTVAR_nc_create("SM_Lower", "FRAC", "soil moisture of lower soil layer", 0.01,
-                                               FP_OUT_VAR, time_steps_run, GP);
+                                               FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SM_Upper == 1)
     {
@@ -407,7 +411,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SM_Upper.nc");
         outnl_ncid->SM_Upper = OUTVAR_nc_create("SM_Upper", "FRAC", "soil moisture of upper soil layer", 0.01,
-                                               FP_OUT_VAR, time_steps_run, GP);
+                                               FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_Infiltration == 1)
     {
@@ -417,7 +421,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_Infiltration.nc");
         outnl_ncid->SW_Infiltration = OUTVAR_nc_create("SW_Infiltration", "mm", "infiltration water", 0.1,
-                                                      FP_OUT_VAR, time_steps_run, GP);
+                                                      FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_Percolation_Upper == 1)
     {
@@ -427,7 +431,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_Percolation_Upper.nc");
         outnl_ncid->SW_Percolation_Upper = OUTVAR_nc_create("SW_Percolation_Upper", "mm", "upper soil layer water percolation", 0.1,
-                                                           FP_OUT_VAR, time_steps_run, GP);
+                                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_Percolation_Lower == 1)
     {
@@ -437,7 +441,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_Percolation_Lower.nc");
         outnl_ncid->SW_Percolation_Lower = OUTVAR_nc_create("SW_Percolation_Lower", "mm", "lower soil layer water percolation", 0.1,
-                                                           FP_OUT_VAR, time_steps_run, GP);
+                                                           FP_OUT_VAR, time_steps_run, GP, restart);
     }
 
     if (outnl.SW_SUB_Qin == 1)
@@ -448,7 +452,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_Qin.nc");
         outnl_ncid->SW_SUB_Qin = OUTVAR_nc_create("SW_SUB_Qin", "mm", "subsurface inflow from the grid cell", 0.1,
-                                                 FP_OUT_VAR, time_steps_run, GP);
+                                                 FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_SUB_Qout == 1)
     {
@@ -458,7 +462,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_Qout.nc");
         outnl_ncid->SW_SUB_Qout = OUTVAR_nc_create("SW_SUB_Qout", "mm", "subsurface outflow from the grid cell", 0.1,
-                                                  FP_OUT_VAR, time_steps_run, GP);
+                                                  FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_SUB_z == 1)
     {
@@ -468,7 +472,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_z.nc");
         outnl_ncid->SW_SUB_z = OUTVAR_nc_create("SW_SUB_z", "mm", "subsurface water table", 0.01,
-                                               FP_OUT_VAR, time_steps_run, GP);
+                                               FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_SUB_rise_lower == 1)
     {
@@ -478,7 +482,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_rise_lower.nc");
         outnl_ncid->SW_SUB_rise_lower = OUTVAR_nc_create("SW_SUB_rise_lower", "mm", "water supplied by rising water table to lower soil layer", 0.1,
-                                                        FP_OUT_VAR, time_steps_run, GP);
+                                                        FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_SUB_rise_upper == 1)
     {
@@ -488,7 +492,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_rise_upper.nc");
         outnl_ncid->SW_SUB_rise_upper = OUTVAR_nc_create("SW_SUB_rise_upper", "mm", "water supplied by rising water table to upper soil layer", 0.1,
-                                                        FP_OUT_VAR, time_steps_run, GP);
+                                                        FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_SUB_rf == 1)
     {
@@ -498,7 +502,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_rf.nc");
         outnl_ncid->SW_SUB_rf = OUTVAR_nc_create("SW_SUB_rf", "mm", "water volume of returnflow", 0.1,
-                                                FP_OUT_VAR, time_steps_run, GP);
+                                                FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.SW_SUB_Qc == 1)
     {
@@ -508,7 +512,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_SUB_Qc.nc");
         outnl_ncid->SW_SUB_Qc = OUTVAR_nc_create("SW_SUB_Qc", "mm", "lateral water into river channel", 0.1,
-                                                FP_OUT_VAR, time_steps_run, GP);
+                                                FP_OUT_VAR, time_steps_run, GP, restart);
     }
     if (outnl.Q_Channel == 1)
     {
@@ -518,7 +522,7 @@ void malloc_Outnamelist(
         FP_OUT_VAR[0] = '\0';
         strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "Q_Channel.nc");
         outnl_ncid->Q_Channel = OUTVAR_nc_create("Q_Channel", "m3/s", "subsurface-induced discharge in river channels", 0.001,
-                                                FP_OUT_VAR, time_steps_run, GP);
+                                                FP_OUT_VAR, time_steps_run, GP, restart);
     }
 }
 
@@ -528,20 +532,23 @@ void OUTVAR_nc_initial(
     ST_Header HD
 )
 {
-    if (*(*data_DEM + 0) == HD.NODATA_value && *(*out_data + 0) != HD.NODATA_value)
-    {
-        /*****
-         * **out_data: the raster array of the output variable,
-         * initialize the raster array by specifying the NODATA value
-         */
-        for (size_t i = 0; i < HD.nrows; i++)
+    /*****
+     * **out_data: the raster array of the output variable,
+     * initialize the raster array by specifying the NODATA value,
+     * and 0 for the cells not written at every step (e.g. outside the channels),
+     * so that the exported maps do not depend on the content of fresh memory
+     */
+    for (size_t i = 0; i < HD.nrows; i++)
+    {
+        for (size_t j = 0; j < HD.ncols; j++)
         {
-            for (size_t j = 0; j < HD.ncols; j++)
+            if (*(*data_DEM + i * HD.ncols + j) == HD.NODATA_value)
             {
-                if (*(*data_DEM + i * HD.ncols + j) == HD.NODATA_value)
-                {
-                    *(*out_data + i * HD.ncols + j) = HD.NODATA_value;
-                }
+                *(*out_data + i * HD.ncols + j) = HD.NODATA_value;
+            }
+            else
+            {
+                *(*out_data + i * HD.ncols + j) = 0;
             }
         }
     }
@@ -554,11 +561,24 @@ int OUTVAR_nc_create(
     double scale_factor,
     char FP_output[],
     int ts_length,
-    GLOBAL_PARA GP
+    GLOBAL_PARA GP,
+    int restart
     )
 {
     int status_nc;
     int ncID_GEO;
+    if (restart == 1)
+    {
+        /* resume from a checkpoint: keep the steps written before, the later ones are overwritten */
+        int ncID_out;
+        status_nc = nc_open(FP_output, NC_WRITE, &ncID_out);
+        if (status_nc != NC_NOERR)
+        {
+            printf("error in opening file%s for restart: %s\n", FP_output, nc_strerror(status_nc));
+            exit(-1);
+        }
+        return ncID_out;
+    }
     status_nc = nc_open(GP.FP_GEO, NC_NOWRITE, &ncID_GEO);
     if (status_nc != NC_NOERR)
     {
@@ -963,6 +983,148 @@ void Write2NC_Outnamelist(
 }
 
 
+void malloc_Outnamelist_Runoff(
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST *outnl_ncid,
+    int cell_counts_total,
+    int time_steps_run,
+    int **data_DEM,
+    ST_Header HD,
+    GLOBAL_PARA GP,
+    int UH_stream,
+    int **out_SW_Run_Infil,
+    int **out_SW_Run_Satur,
+    int restart
+)
+{
+    /*********
+     * the generated surface runoff (0.1 mm) feeds the UH routing:
+     * - UH_stream = 0: the whole series (time_steps_run maps) is kept for
+     *   the routing after the simulation, and exported by Write2NC_Outnamelist()
+     * - UH_stream = 1: only the map of the current step is kept, routed
+     *   at every step, and exported by Write_Outnamelist_Runoff()
+     */
+    long size;
+    char FP_OUT_VAR[MAXCHAR];
+    if (UH_stream == 1)
+    {
+        size = 1 * cell_counts_total;
+    }
+    else
+    {
+        size = (long)time_steps_run * cell_counts_total;
+    }
+    *out_SW_Run_Infil = (int *)malloc(sizeof(int) * size);
+    malloc_memory_error(*out_SW_Run_Infil, "SW_Run_Infil");
+    *out_SW_Run_Satur = (int *)malloc(sizeof(int) * size);
+    malloc_memory_error(*out_SW_Run_Satur, "SW_Run_Satur");
+    if (UH_stream == 1)
+    {
+        OUTVAR_nc_initial(data_DEM, out_SW_Run_Infil, HD);
+        OUTVAR_nc_initial(data_DEM, out_SW_Run_Satur, HD);
+        if (outnl.SW_Run_Infil == 1)
+        {
+            FP_OUT_VAR[0] = '\0';
+            strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_Run_Infil.nc");
+            outnl_ncid->SW_Run_Infil = OUTVAR_nc_create("SW_Run_Infil", "mm", "surface runoff from infiltration-excess", 0.1,
+                                                        FP_OUT_VAR, time_steps_run, GP, restart);
+        }
+        if (outnl.SW_Run_Satur == 1)
+        {
+            FP_OUT_VAR[0] = '\0';
+            strcat(strcat(FP_OUT_VAR, GP.PATH_OUT), "SW_Run_Satur.nc");
+            outnl_ncid->SW_Run_Satur = OUTVAR_nc_create("SW_Run_Satur", "mm", "surface runoff from saturation-excess", 0.1,
+                                                        FP_OUT_VAR, time_steps_run, GP, restart);
+        }
+    }
+}
+
+void Write_Outnamelist_Runoff(
+    int t_run,
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST outnl_ncid,
+    ST_Header HD,
+    int **out_SW_Run_Infil,
+    int **out_SW_Run_Satur
+)
+{
+    /* streaming UH routing: export the surface runoff of step t_run */
+    int index_start[3] = {0, 0, 0};
+    int index_count[3] = {1, 0, 0};
+    index_count[1] = HD.nrows;
+    index_count[2] = HD.ncols;
+    index_start[0] = t_run;
+    if (outnl.SW_Run_Infil == 1)
+    {
+        OUTVAR_nc_write(outnl_ncid.SW_Run_Infil, "SW_Run_Infil", out_SW_Run_Infil, index_start, index_count);
+    }
+    if (outnl.SW_Run_Satur == 1)
+    {
+        OUTVAR_nc_write(outnl_ncid.SW_Run_Satur, "SW_Run_Satur", out_SW_Run_Satur, index_start, index_count);
+    }
+}
+
+void OUTVAR_nc_close_Runoff(
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST outnl_ncid)
+{
+    /* streaming UH routing: close the surface runoff files */
+    if (outnl.SW_Run_Infil == 1)
+    {
+        nc_close(outnl_ncid.SW_Run_Infil);
+    }
+    if (outnl.SW_Run_Satur == 1)
+    {
+        nc_close(outnl_ncid.SW_Run_Satur);
+    }
+}
+
+void OUTVAR_nc_sync(
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST outnl_ncid,
+    int UH_stream
+)
+{
+    /******
+     * write the steps exported so far to disk (before a checkpoint):
+     * the files written at every step, SW_Run_Infil and SW_Run_Satur
+     * only when UH_stream = 1
+     */
+#define OUTVAR_SYNC(var) if (outnl.var == 1) {nc_sync(outnl_ncid.var);}
+    OUTVAR_SYNC(Rs)
+    OUTVAR_SYNC(L_sky)
+    OUTVAR_SYNC(Rno)
+    OUTVAR_SYNC(Rnu)
+    OUTVAR_SYNC(Ep)
+    OUTVAR_SYNC(EI_o)
+    OUTVAR_SYNC(EI_u)
+    OUTVAR_SYNC(ET_o)
+    OUTVAR_SYNC(ET_u)
+    OUTVAR_SYNC(ET_s)
+    OUTVAR_SYNC(Interception_o)
+    OUTVAR_SYNC(Interception_u)
+    OUTVAR_SYNC(Prec_net)
+    OUTVAR_SYNC(SM_Upper)
+    OUTVAR_SYNC(SM_Lower)
+    OUTVAR_SYNC(SW_Infiltration)
+    OUTVAR_SYNC(SW_Percolation_Upper)
+    OUTVAR_SYNC(SW_Percolation_Lower)
+    OUTVAR_SYNC(SW_SUB_Qin)
+    OUTVAR_SYNC(SW_SUB_Qout)
+    OUTVAR_SYNC(SW_SUB_z)
+    OUTVAR_SYNC(SW_SUB_rise_upper)
+    OUTVAR_SYNC(SW_SUB_rise_lower)
+    OUTVAR_SYNC(SW_SUB_rf)
+    OUTVAR_SYNC(SW_SUB_Qc)
+    OUTVAR_SYNC(Q_Channel)
+    if (UH_stream == 1)
+    {
+        OUTVAR_SYNC(SW_Run_Infil)
+        OUTVAR_SYNC(SW_Run_Satur)
+    }
+#undef OUTVAR_SYNC
+}
+
 void malloc_memory_error(
     int *data,
     char var[]
@@ -44,7 +44,8 @@ void malloc_Outnamelist(
     int **out_SW_SUB_rise_lower, 
     int **out_SW_SUB_rf,
     int **out_SW_SUB_Qc,
-    int **out_Q_Channel
+    int **out_Q_Channel,
+    int restart
 );
 
 void OUTVAR_nc_initial(
@@ -59,7 +60,8 @@ int OUTVAR_nc_create(
     double scale_factor,
     char FP_output[],
     int ts_length,
-    GLOBAL_PARA GP);
+    GLOBAL_PARA GP,
+    int restart);
 
 void Write_Outnamelist(
     int t_run,
@@ -114,6 +116,38 @@ void Write2NC_Outnamelist(
     GLOBAL_PARA GP
 );
 
+void malloc_Outnamelist_Runoff(
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST *outnl_ncid,
+    int cell_counts_total,
+    int time_steps_run,
+    int **data_DEM,
+    ST_Header HD,
+    GLOBAL_PARA GP,
+    int UH_stream,
+    int **out_SW_Run_Infil,
+    int **out_SW_Run_Satur,
+    int restart
+);
+
+void Write_Outnamelist_Runoff(
+    int t_run,
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST outnl_ncid,
+    ST_Header HD,
+    int **out_SW_Run_Infil,
+    int **out_SW_Run_Satur
+);
+
+void OUTVAR_nc_close_Runoff(
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST outnl_ncid);
+
+void OUTVAR_nc_sync(
+    OUT_NAME_LIST outnl,
+    OUT_NAME_LIST outnl_ncid,
+    int UH_stream);
+
 void malloc_memory_error(
     int *data,
     char var[]
@@ -7,7 +7,9 @@
  * ORIG-DATE:    Aug-2023
  * DESCRIPTION:  Calculate radiations
  * DESCRIP-END.
- * FUNCTIONS:    
+ * FUNCTIONS:    NOD(); Radiation_Astro(); Radiation_Astro_Rows(); Radiation_downward_short();
+ *               Radiation_downward_short_astro(); Radiation_short_surface(); Radiation_long_surface();
+ *               Radiation_downward_long(); Radiation_downward_long_astro()
  * 
  * COMMENTS:
  * In order to simulate the snow accumulation and melting process in a physical-based manner,
@@ -23,6 +25,11 @@
  *      Geographical Research Letters 39(5), 
  *      doi: https://doi.org/10.1029/2011GL050726
  * 
+ * The terms that only depend on the date and the latitude (day number, earth-sun
+ * distance, declination, sunset hour angle, extraterrestrial radiation) are
+ * computed by Radiation_Astro(); the *_astro() functions take them precomputed,
+ * so that a grid needs them once per row and step rather than once per cell.
+ * 
 */
 
 
@@ -51,6 +58,7 @@
 #include <math.h>
 #include "Constants.h"
 #include "Radiation_Calc.h"
+#include "Func_Tem.h"
 
 int NOD(
     int year,
@@ -73,28 +81,26 @@ int NOD(
     return NOD;
 }
 
-/************ shortwave radiation *************/
+/************ astronomical terms *************/
 
-double Radiation_downward_short(
+void Radiation_Astro(
     int year,
     int month,
     int day,
     double lat,         /* the latitute of the location */ 
-    double Air_SSD      /* sunshine duration in a day, hours */ 
+    RADIA_ASTRO *astro
 ){
     /*****
-     *  calculate the received shortwave radiation [(MJ⋅m-2⋅d-1)], 
-     *  considering the effect of cloudiness, at a daily step
-     * 
+     * the terms of the sky radiation that only depend on the date and the latitude:
+     * the clear-sky radiation and the maximum possible sunshine duration;
+     * computed once per latitude (row) and step, see Radiation_Astro_Rows()
     */
-    double tau_cloud;  // effect of cloud cover on insolation
     double R_et;       // extraterrestrial radiation
-    double R_cs;       // clear-sky radiation
     int J; // number of the day
     J = NOD(year, month, day);
 
     // estimate the extraterrestrial radiation (MJ⋅m-2 d-1)
-    double dr, del, w_s, Ra; // intermediate variable
+    double dr, del, w_s; // intermediate variable
 
     //the inverse relative distance between earth and sun
     dr = 1 + 0.033 * cos(2 * PI / 365 * J);  
@@ -109,11 +115,51 @@ double Radiation_downward_short(
     R_et = 37.59 * dr * (w_s * sin(lat * PI / 180) * sin(del) + cos(lat * PI / 180) * cos(del) * sin(w_s));
     // 37.59: 24(60)/PI*Gsc; Gsc is the solar constant and equals to 0.082MJ⋅m(-2)⋅min(-1)
 
-    R_cs = (as + bs) * R_et;  // clear-sky radiation, non-cloudy
-    
-    tau_cloud = as + bs * Air_SSD / (24/PI * w_s);  // diminishing effect from cloudiness
+    astro->R_cs = (as + bs) * R_et;  // clear-sky radiation, non-cloudy
+    astro->N = 24/PI * w_s;          // the maximum possible duration of sunshine (hours)
+}
+
+void Radiation_Astro_Rows(
+    int year,
+    int month,
+    int day,
+    double *data_lat,   /* the latitude of the rows */
+    int nrows,
+    RADIA_ASTRO *astro  /* nrows entries */
+){
+    for (int i = 0; i < nrows; i++)
+    {
+        Radiation_Astro(year, month, day, *(data_lat + i), astro + i);
+    }
+}
+
+/************ shortwave radiation *************/
+
+double Radiation_downward_short(
+    int year,
+    int month,
+    int day,
+    double lat,         /* the latitute of the location */ 
+    double Air_SSD      /* sunshine duration in a day, hours */ 
+){
+    /*****
+     *  calculate the received shortwave radiation [(MJ⋅m-2⋅d-1)], 
+     *  considering the effect of cloudiness, at a daily step
+     * 
+    */
+    RADIA_ASTRO astro;
+    Radiation_Astro(year, month, day, lat, &astro);
+    return Radiation_downward_short_astro(&astro, Air_SSD);
+}
+
+double Radiation_downward_short_astro(
+    RADIA_ASTRO *astro, /* the astronomical terms of the date and location */
+    double Air_SSD      /* sunshine duration in a day, hours */ 
+){
+    double tau_cloud;  // effect of cloud cover on insolation
+    tau_cloud = as + bs * Air_SSD / astro->N;  // diminishing effect from cloudiness
     
-    return R_cs * tau_cloud; 
+    return astro->R_cs * tau_cloud; 
 
 }
 
@@ -164,7 +210,7 @@ double Radiation_long_surface(
 
     double es;  // saturated vapor pressure, kPa;
     double ea;  // actual vapor pressure, kPa;
-    es = 0.6108 * exp(17.277 * Tem_air / (Tem_air + 273.3));
+    es = e0(Tem_air);
     ea = RHU * es / 100;
     
     double delta = 4.90 * pow(10, -9);  // Stefan-Boltzmann constant, MJ/m2/k4/d
@@ -192,6 +238,18 @@ double Radiation_downward_long(
     double RHU,      /* relative humidity, unit: % */ 
     double Air_SSD,  /* sunshine duration in a day, hours */ 
     double FF        /* the fractional forest cover, between 0.0 and 1.0 */ 
+){
+    RADIA_ASTRO astro;
+    Radiation_Astro(year, month, day, lat, &astro);
+    return Radiation_downward_long_astro(&astro, Tem_air, RHU, Air_SSD, FF);
+}
+
+double Radiation_downward_long_astro(
+    RADIA_ASTRO *astro, /* the astronomical terms of the date and location */
+    double Tem_air,  /* air temperature, [Celsius degree] */ 
+    double RHU,      /* relative humidity, unit: % */ 
+    double Air_SSD,  /* sunshine duration in a day, hours */ 
+    double FF        /* the fractional forest cover, between 0.0 and 1.0 */ 
 ){
     /****
      * calculate the received downward longwave radiation,
@@ -213,25 +271,13 @@ double Radiation_downward_long(
     */
     double es;  // saturated vapor pressure, kPa;
     double ea;  // actual vapor pressure, kPa;
-    es = 0.6108 * exp(17.277 * Tem_air / (Tem_air + 273.3));
+    es = e0(Tem_air);
     ea = RHU * es / 100;
 
     emissivity_clr = 0.83 - 0.18 * exp(-1.54 * ea);
 
-    /* calculate the maximum possible duration of sunshine (hours) */
-    double dr, del, w_s, N;  
-    int J; // number of day
-    J = NOD(year, month, day);
-
-    //the inverse relative distance between earth and sun
-    dr = 1 + 0.033 * cos(2 * PI / 365 * J);  
-
-    //the solar decimation (rad)
-    del = 0.408 * sin(2 * PI / 365 * J - 1.39); 
-
-    // the sunset hour angle (rad)
-    w_s = acos( - tan(lat * PI / 180) * tan(del));
-    N = 24/PI * w_s;
+    /* the maximum possible duration of sunshine (hours): astro->N */
+    double N = astro->N;
 
     emissivity_sky = (1 - Air_SSD / N) + Air_SSD / N * emissivity_clr;
     emissivity_at = (1 - FF) * emissivity_sky + FF;
@@ -239,8 +285,3 @@ double Radiation_downward_long(
     Lin = emissivity_at * delta * pow(Tem_air + 273.15, 4);
     return Lin;
 }
-
-
-
-
-
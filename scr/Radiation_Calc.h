@@ -2,6 +2,13 @@
 #ifndef RADIATION
 #define RADIATION
 /* declare functions from "Radiation_Calc.c" */
+typedef struct
+{
+    /* the sky radiation terms of a date and latitude, see Radiation_Astro() */
+    double R_cs;   /* clear-sky radiation, [MJ/m2/d] */
+    double N;      /* maximum possible duration of sunshine, [h] */
+} RADIA_ASTRO;
+
 int NOD(
     int year,
     int month,
@@ -9,6 +16,25 @@ int NOD(
 );
 
 
+void Radiation_Astro(
+    int year,
+    int month,
+    int day,
+    double lat,         /* the latitute of the location */ 
+    RADIA_ASTRO *astro
+);
+
+
+void Radiation_Astro_Rows(
+    int year,
+    int month,
+    int day,
+    double *data_lat,   /* the latitude of the rows */
+    int nrows,
+    RADIA_ASTRO *astro  /* nrows entries */
+);
+
+
 double Radiation_downward_short(
     int year,
     int month,
@@ -18,6 +44,12 @@ double Radiation_downward_short(
 );
 
 
+double Radiation_downward_short_astro(
+    RADIA_ASTRO *astro, /* the astronomical terms of the date and location */
+    double Air_SSD      /* sunshine duration in a day, hours */ 
+);
+
+
 double Radiation_short_surface(
     double R_sky,  /*the received solar radiation, considering the effect of cloudiness, output from 
      from function Radiation_downward_short() */ 
@@ -46,4 +78,13 @@ double Radiation_downward_long(
 );
 
 
+double Radiation_downward_long_astro(
+    RADIA_ASTRO *astro, /* the astronomical terms of the date and location */
+    double Tem_air,  /* air temperature, Celsius degree */ 
+    double RHU,      /* relative humidity, unit: % */ 
+    double Air_SSD,  /* sunshine duration in a day, hours */ 
+    double FF        /* the fractional forest cover, between 0.0 and 1.0 */ 
+);
+
+
 #endif
@@ -9,7 +9,8 @@
  * DESCRIPTION:  Calculate aerodynamic and canopy resistance
  * DESCRIP-END.
  * FUNCTIONS:
- *               Resist_aero_o(); Resist_aero_u()
+ *               Resist_aero_o(); Resist_aero_u(); Resist_aero_Pre();
+ *               Resist_aero_o_Pre(); Resist_aero_u_Pre()
  * COMMENTS:
  * REFERENCEs:
  *
@@ -131,6 +132,65 @@ double Resist_aero_u(
     return Rau / 3600;                                      // unit: h/m
 }
 
+void Resist_aero_Pre(
+    double ws_obs_z,   /* the measurement height, m */
+    double zr,         /* (above canopy) reference height, [m] */
+    double d,          /* displacement height of canopy, m */
+    double z0,         /* the roughness height of canopy, m */
+    double dg,         /* displacement height of ground/surface (understory), m */
+    double z0_g,       /* the roughness height of ground/surface (understory), m */
+    ST_AERO_PRE *aero
+)
+{
+    /*********
+     * the logarithms of Resist_aero_o() and Resist_aero_u(), which only depend
+     * on the heights: computed once per vegetation class and month
+     */
+    double za;
+    za = 2 + dg + z0_g;
+    aero->log2_o = pow(log((zr - d) / z0), 2);
+    aero->log_zr = log((zr - dg) / z0_g);
+    aero->log_obs = log((ws_obs_z - dg) / z0_g);
+    aero->log_za = log((za - dg) / z0_g);
+    aero->log2_za = pow(log((za - dg) / z0_g), 2);
+}
+
+double Resist_aero_o_Pre(
+    double Air_ws_obs, /* wind speed at the measurement height, [m/s] */
+    ST_AERO_PRE *aero
+)
+{
+    /* Resist_aero_o() with the precomputed logarithms, [h/m] */
+    double Rao;
+    double k = 0.4;
+    double Air_ws_zr;
+    Air_ws_zr = Air_ws_obs * aero->log_zr / aero->log_obs;
+    if (Air_ws_zr < 0.0001)
+    {
+        Air_ws_zr = 0.0001;
+    }
+    Rao = aero->log2_o / (Air_ws_zr * k * k);
+    return Rao / 3600;
+}
+
+double Resist_aero_u_Pre(
+    double Air_ws_obs, /* wind speed at the measurement height, [m/s] */
+    ST_AERO_PRE *aero
+)
+{
+    /* Resist_aero_u() with the precomputed logarithms, [h/m] */
+    double Rau;
+    double k = 0.4;
+    double Air_ws_za;
+    Air_ws_za = Air_ws_obs * aero->log_za / aero->log_obs;
+    if (Air_ws_za < 0.0001)
+    {
+        Air_ws_za = 0.0001;
+    }
+    Rau = aero->log2_za / (Air_ws_za * k * k);
+    return Rau / 3600;
+}
+
 double WindSpeed_Profile(
     double z1,  /* height 1, m */
     double z2,  /* height 2, m */
@@ -2,6 +2,8 @@
 #ifndef RESISTANCE
 #define RESISTANCE
 
+#include "Evapotranspiration_ST.h"
+
 /*********** aerodynamic resistance ************/
 double Resist_aero_o(
     double Air_ws_obs, /* wind speed at the measurement height, [m/s] */
@@ -21,6 +23,26 @@ double Resist_aero_u(
     double z0           /* roughness length, m */
 );
 
+void Resist_aero_Pre(
+    double ws_obs_z,   /* the measurement height, m */
+    double zr,         /* (above canopy) reference height, [m] */
+    double d,          /* displacement height of canopy, m */
+    double z0,         /* the roughness height of canopy, m */
+    double dg,         /* displacement height of ground/surface (understory), m */
+    double z0_g,       /* the roughness height of ground/surface (understory), m */
+    ST_AERO_PRE *aero
+);
+
+double Resist_aero_o_Pre(
+    double Air_ws_obs, /* wind speed at the measurement height, [m/s] */
+    ST_AERO_PRE *aero
+);
+
+double Resist_aero_u_Pre(
+    double Air_ws_obs, /* wind speed at the measurement height, [m/s] */
+    ST_AERO_PRE *aero
+);
+
 double WindSpeed_Profile(
     double z1, /* height 1, m */
     double z2, /* height 2, m */
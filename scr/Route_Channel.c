@@ -10,9 +10,11 @@
  *               linear reservoir method
  * DESCRIP-END.
  * FUNCTIONS:    Channel_Routing(); Initialize_STREAM(); Channel_Network_Routing();
+ *               Initialize_Channel_Network(); Free_Channel_Network();
  * 
  * COMMENTS:
- * 
+ * - Initialize_Channel_Network(): sort the channel cells upstream-to-downstream
+ * - Channel_Network_Routing():    route the flow through the channel network, one pass over the sorted reaches
  * 
  * REFERENCES:
  *  
@@ -28,6 +30,10 @@
  * double k                - storage parameter: equal to the inverse of the average residence time, [1/h]
  * int step_time           - time step, interval, [h]
  * int *data_STR           - pointing to the 2D stream (STR) array
+ * int *stream_index       - 1D raster index of the channel cells (STR == 1)
+ * int stream_count        - number of channel cells
+ * CHANNEL_NETWORK *network - the channel cells in topological order, see "HM_ST.h"
+ * int route_order         - CHANNEL_LAGGED, CHANNEL_TOPO or CHANNEL_LEVEL
  * 
 ******************************************************************/
 #include <stdio.h>
@@ -156,56 +162,236 @@ void Initialize_STREAM(
     }
 }
 
-void Channel_Network_Routing(
-    CELL_VAR_STREAM **data_STREAM,
-    int *data_STR,
+void Initialize_Channel_Network(
+    CHANNEL_NETWORK *network,
+    CELL_VAR_STREAM *data_STREAM,
+    int *stream_index,
+    int stream_count,
     int ncols,
-    int nrows,
-    int step_time)
+    int nrows)
 {
-    int index_geo;
+    /**********
+     * sort the channel cells upstream-to-downstream (Kahn's algorithm on
+     * the next_row/next_col links between channel cells), and collect the
+     * upstream reaches of each channel cell; a reach whose downstream
+     * cell is no channel cell (e.g. the outlet) ends the network
+     */
+    int cell_counts_total;
+    int *position;   // raster -> position in stream_index, -1: no channel cell
+    int *down;       // downstream channel cell (position), -1: none
+    int *up_count;
+    int *level;
+    int *queue;
+    int *order;
+    int next_row, next_col;
+    int head, tail;
+    int c, d, r;
 
-    /* initialize Qin for each running step */
-    for (size_t i = 0; i < nrows; i++)
+    cell_counts_total = ncols * nrows;
+    position = (int *)malloc(sizeof(int) * cell_counts_total);
+    down = (int *)malloc(sizeof(int) * (stream_count + 1));
+    up_count = (int *)calloc(stream_count + 1, sizeof(int));
+    level = (int *)calloc(stream_count + 1, sizeof(int));
+    queue = (int *)malloc(sizeof(int) * (stream_count + 1));
+    order = (int *)malloc(sizeof(int) * (stream_count + 1));
+    network->reach_index = (int *)malloc(sizeof(int) * (stream_count + 1));
+    network->up_start = (int *)malloc(sizeof(int) * (stream_count + 1));
+    network->up_index = (int *)malloc(sizeof(int) * (stream_count + 1));
+    if (position == NULL || down == NULL || up_count == NULL || level == NULL || queue == NULL || order == NULL ||
+        network->reach_index == NULL || network->up_start == NULL || network->up_index == NULL)
     {
-        for (size_t j = 0; j < ncols; j++)
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (size_t i = 0; i < cell_counts_total; i++)
+    {
+        *(position + i) = -1;
+    }
+    for (c = 0; c < stream_count; c++)
+    {
+        *(position + *(stream_index + c)) = c;
+    }
+    for (c = 0; c < stream_count; c++)
+    {
+        next_row = (data_STREAM + *(stream_index + c))->next_row;
+        next_col = (data_STREAM + *(stream_index + c))->next_col;
+        *(down + c) = -1;
+        if (next_row >= 0 && next_row < nrows && next_col >= 0 && next_col < ncols)
         {
-            index_geo = i * ncols + j;
-            if (*(data_STR + index_geo) == 1)
-            {
-                (*data_STREAM + index_geo)->Qin = 0.0;
-            }
+            *(down + c) = *(position + next_row * ncols + next_col);
+        }
+        if (*(down + c) >= 0)
+        {
+            *(up_count + *(down + c)) += 1;
         }
     }
-    /* update Qin */
-    int index_geo_next;
-    for (size_t i = 0; i < nrows; i++)
+
+    /* level of a reach: 1 + the largest level of its upstream reaches */
+    head = 0; tail = 0;
+    for (c = 0; c < stream_count; c++)
     {
-        for (size_t j = 0; j < ncols; j++)
+        *(queue + c) = *(up_count + c);  // upstream reaches not yet leveled
+    }
+    for (c = 0; c < stream_count; c++)
+    {
+        if (*(up_count + c) == 0)
         {
-            index_geo = i * ncols + j;
-            if (*(data_STR + index_geo) == 1)
+            *(order + tail) = c; tail += 1;
+        }
+    }
+    while (head < tail)
+    {
+        c = *(order + head); head += 1;
+        d = *(down + c);
+        if (d >= 0)
+        {
+            if (*(level + d) < *(level + c) + 1)
             {
-                index_geo_next = (*data_STREAM + index_geo)->next_row * ncols + (*data_STREAM + index_geo)->next_col;
-                (*data_STREAM + index_geo_next)->Qin += (*data_STREAM + index_geo)->Qout;
+                *(level + d) = *(level + c) + 1;
+            }
+            *(queue + d) -= 1;
+            if (*(queue + d) == 0)
+            {
+                *(order + tail) = d; tail += 1;
             }
         }
     }
-    /* route Qout */
-    for (size_t i = 0; i < nrows; i++)
+    if (tail < stream_count)
     {
-        for (size_t j = 0; j < ncols; j++)
+        printf("The flow directions of the channel cells contain a loop!\n");
+        exit(0);
+    }
+
+    /* counting sort by level, keeping the row-major order within a level */
+    network->reach_count = stream_count;
+    network->level_count = 0;
+    for (c = 0; c < stream_count; c++)
+    {
+        if (*(level + c) + 1 > network->level_count)
         {
-            index_geo = i * ncols + j;
-            if (*(data_STR + index_geo) == 1)
+            network->level_count = *(level + c) + 1;
+        }
+    }
+    network->level_start = (int *)calloc(network->level_count + 1, sizeof(int));
+    if (network->level_start == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (c = 0; c < stream_count; c++)
+    {
+        *(network->level_start + *(level + c) + 1) += 1;
+    }
+    for (int l = 0; l < network->level_count; l++)
+    {
+        *(network->level_start + l + 1) += *(network->level_start + l);
+    }
+    for (int l = 0; l <= network->level_count; l++)
+    {
+        *(queue + l) = *(network->level_start + l);  // next free slot of each level
+    }
+    for (c = 0; c < stream_count; c++)
+    {
+        r = *(queue + *(level + c));
+        *(queue + *(level + c)) += 1;
+        *(order + c) = r;  // topological position of channel cell c
+        *(network->reach_index + r) = *(stream_index + c);
+    }
+
+    /* upstream reaches, in the row-major order of the channel cells */
+    *(network->up_start + 0) = 0;
+    for (r = 0; r < stream_count; r++)
+    {
+        *(network->up_start + r + 1) = *(network->up_start + r) + *(up_count + *(position + *(network->reach_index + r)));
+    }
+    for (r = 0; r < stream_count; r++)
+    {
+        *(queue + r) = *(network->up_start + r);
+    }
+    for (c = 0; c < stream_count; c++)
+    {
+        d = *(down + c);
+        if (d >= 0)
+        {
+            r = *(order + d);
+            *(network->up_index + *(queue + r)) = *(stream_index + c);
+            *(queue + r) += 1;
+        }
+    }
+    free(position); free(down); free(up_count); free(level); free(queue); free(order);
+}
+
+void Free_Channel_Network(
+    CHANNEL_NETWORK *network)
+{
+    free(network->reach_index);
+    free(network->up_start);
+    free(network->up_index);
+    free(network->level_start);
+}
+
+static void Channel_Reach_Routing(
+    CELL_VAR_STREAM *data_STREAM,
+    CHANNEL_NETWORK *network,
+    int r,
+    int step_time)
+{
+    /* gather the inflow of reach r from its upstream reaches, and route it */
+    int index_geo;
+    index_geo = *(network->reach_index + r);
+    (data_STREAM + index_geo)->Qin = 0.0;
+    for (int u = *(network->up_start + r); u < *(network->up_start + r + 1); u++)
+    {
+        (data_STREAM + index_geo)->Qin += (data_STREAM + *(network->up_index + u))->Qout;
+    }
+    Channel_Routing(
+        &((data_STREAM + index_geo)->Qin),
+        &((data_STREAM + index_geo)->Qout),
+        &((data_STREAM + index_geo)->V),
+        (data_STREAM + index_geo)->Qc,
+        (data_STREAM + index_geo)->k,
+        step_time);
+}
+
+void Channel_Network_Routing(
+    CELL_VAR_STREAM **data_STREAM,
+    CHANNEL_NETWORK *network,
+    int route_order,
+    int step_time)
+{
+    /**********
+     * one pass over the reaches:
+     * - CHANNEL_LAGGED: downstream-to-upstream, so that the inflow of a reach
+     *   is the outflow of its upstream reaches at the previous step
+     * - CHANNEL_TOPO: upstream-to-downstream, the flow traverses the network within one step
+     * - CHANNEL_LEVEL: as CHANNEL_TOPO; the reaches of a level are independent
+     *   and routed in parallel, levels one after another
+     */
+    int r;
+    if (route_order == CHANNEL_LAGGED)
+    {
+        for (r = network->reach_count - 1; r >= 0; r--)
+        {
+            Channel_Reach_Routing(*data_STREAM, network, r, step_time);
+        }
+    }
+    else if (route_order == CHANNEL_TOPO)
+    {
+        for (r = 0; r < network->reach_count; r++)
+        {
+            Channel_Reach_Routing(*data_STREAM, network, r, step_time);
+        }
+    }
+    else
+    {
+        for (int l = 0; l < network->level_count; l++)
+        {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (r = *(network->level_start + l); r < *(network->level_start + l + 1); r++)
             {
-                Channel_Routing(
-                    &((*data_STREAM + index_geo)->Qin),
-                    &((*data_STREAM + index_geo)->Qout),
-                    &((*data_STREAM + index_geo)->V),
-                    (*data_STREAM + index_geo)->Qc,
-                    (*data_STREAM + index_geo)->k,
-                    step_time);
+                Channel_Reach_Routing(*data_STREAM, network, r, step_time);
             }
         }
     }
@@ -1,6 +1,11 @@
 #ifndef ROUTE_CHANNEL
 #define ROUTE_CHANNEL
 
+/* ROUTE_CHANNEL_ORDER: the order the reaches are routed in, see Channel_Network_Routing() */
+#define CHANNEL_LAGGED 0
+#define CHANNEL_TOPO 1
+#define CHANNEL_LEVEL 2
+
 void Channel_Routing(
     double *Qin,
     double *Qout,
@@ -18,11 +23,21 @@ void Initialize_STREAM(
     int ncols,
     int nrows);
 
+void Initialize_Channel_Network(
+    CHANNEL_NETWORK *network,
+    CELL_VAR_STREAM *data_STREAM,
+    int *stream_index,
+    int stream_count,
+    int ncols,
+    int nrows);
+
+void Free_Channel_Network(
+    CHANNEL_NETWORK *network);
+
 void Channel_Network_Routing(
     CELL_VAR_STREAM **data_STREAM,
-    int *data_STR,
-    int ncols,
-    int nrows,
+    CHANNEL_NETWORK *network,
+    int route_order,
     int step_time);
 
 #endif
\ No newline at end of file
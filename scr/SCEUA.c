@@ -0,0 +1,622 @@
+/*
+ * SUMMARY:      SCEUA.c
+ * USAGE:        calibration of the xHM parameters by SCE-UA
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the shuffled complex evolution (SCE-UA) searches the parameters
+ *               listed in FP_CALIB, within their ranges, for the best score
+ *               (CALIB_OBJECTIVE) of the discharge at the outlet CALIB_OUTLET
+ *               against the observation FP_QOBS; the complexes evolve in lockstep,
+ *               so the new points of all the complexes are simulated together
+ *               as one parameter ensemble (Ensemble.c), in parallel threads and
+ *               with the forcing and static data in memory
+ * DESCRIP-END.
+ * FUNCTIONS:    SCEUA_Calibrate()
+ *
+ * COMMENTS:
+ * FP_CALIB: one parameter per line, "name,min,max", name: one of the ensemble
+ * parameters (see Ensemble.c); the other parameters are those of the global
+ * parameter file. The results are written to PATH_OUT:
+ * - SCEUA_trace.txt:    every simulated parameter set and its score
+ * - SCEUA_history.txt:  the best and worst score of the population after each shuffling loop
+ * - SCEUA_best.txt:     the best parameter set, as lines of the global parameter file
+ * The search stops after SCEUA_EVALS_MAX simulations, when the best score improved
+ * by less than SCEUA_PCENTO (relative) over SCEUA_LOOPS_STOP loops, or when
+ * the population has shrunk below SCEUA_PEPS of the parameter ranges.
+ * A reflection or contraction point is accepted only if its score exceeds
+ * both the score of the worst point of the sub-complex and CALIB_SCORE_MIN
+ * (a floor on the accepted scores; -9999: none); the points of the initial
+ * population and the random points replacing a failed contraction enter the
+ * population whatever their score.
+ * Early termination (CALIB_EARLY_STOP): the score is accumulated during the run
+ * (Calib_Eval_Step()); the run of a reflection or contraction point is aborted
+ * once its final score provably cannot exceed that threshold, and the point
+ * is rejected, as it would be after the full run; the initial and random
+ * points are always simulated in full. The search is thus the same with
+ * CALIB_EARLY_STOP 0 and 1, only the trace holds the bound of an aborted run.
+ * check_sceua_early_stop.cmake (ctest) compares the SCEUA_history.txt of the two.
+ *
+ * REFERENCES:
+ * Duan, Q., Sorooshian, S., Gupta, V. K., Effective and efficient global optimization
+ *      for conceptual rainfall-runoff models, Water Resources Research, 28 (4), 1015-1031, 1992.
+ * Duan, Q., Sorooshian, S., Gupta, V. K., Optimal use of the SCE-UA global optimization
+ *      method for calibrating watershed models, Journal of Hydrology, 158 (3-4), 265-284, 1994.
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * ENSEMBLE_DATA *ens               - the data shared by the simulations, see "Ensemble.h"
+ * int n                            - number of calibrated parameters
+ * int p                            - number of complexes, SCEUA_COMPLEXES
+ * int m                            - points per complex, 2n + 1
+ * int q                            - points per sub-complex, n + 1
+ * double *x                        - the points (parameter values), n per point
+ * double *f                        - the criterion of the points, 1 - score: minimized
+ * double *score_min                - per point: rejected unless its score exceeds score_min, the run aborted once it cannot
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Constants.h"
+#include "HM_ST.h"
+#include "Ensemble.h"
+#include "Calib_Objective.h"
+#include "SCEUA.h"
+
+typedef struct
+{
+    /* the calibration problem */
+    int n;                  /* number of calibrated parameters */
+    int para_index[ENSEMBLE_PARA_COUNT];  /* the ensemble parameter of each calibrated one, see Ensemble_Para_Field() */
+    double lower[ENSEMBLE_PARA_COUNT];
+    double upper[ENSEMBLE_PARA_COUNT];
+    ENSEMBLE_PARA para_default;           /* the parameters not calibrated */
+    CALIB_OBS obs;
+    int objective;
+    int outlet;
+    int early_stop;         /* 1: abort the hopeless runs, see Calib_Eval_Step() */
+    double score_min;       /* CALIB_SCORE_MIN */
+    CALIB_EVAL *eval;       /* the score of each ensemble member */
+    int evals;              /* simulations so far */
+    int aborted;            /* simulations aborted */
+    double steps_run;       /* simulation steps run */
+    int loop;               /* shuffling loops so far */
+    unsigned long long seed;
+    FILE *fp_trace;
+} SCEUA_PROBLEM;
+
+static double SCEUA_Random(
+    unsigned long long *seed
+)
+{
+    /* uniform in [0, 1), 64-bit linear congruential generator (Knuth MMIX) */
+    *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(*seed >> 11) / 9007199254740992.0;
+}
+
+static void SCEUA_Import(
+    char FP[],
+    SCEUA_PROBLEM *problem
+)
+{
+    FILE *fp;
+    char row[MAXCHAR];
+    char name[MAXCHAR];
+    double lower, upper;
+    int k;
+    if ((fp = fopen(FP, "r")) == NULL)
+    {
+        printf("cannot open file %s\n", FP);
+        exit(0);
+    }
+    problem->n = 0;
+    while (fgets(row, MAXCHAR, fp) != NULL)
+    {
+        if (strlen(row) <= 1 || row[0] == '#')
+        {
+            continue;
+        }
+        if (sscanf(row, "%[^,],%lf,%lf", name, &lower, &upper) != 3)
+        {
+            printf("Error: %s: name,min,max expected: %s", FP, row);
+            exit(0);
+        }
+        k = Ensemble_Para_Index(name);
+        if (k < 0 || problem->n == ENSEMBLE_PARA_COUNT)
+        {
+            printf("Unrecognized calibration parameter in %s: %s\n", FP, name);
+            exit(0);
+        }
+        if (lower >= upper)
+        {
+            printf("Error: %s: invalid range of %s: %f, %f\n", FP, name, lower, upper);
+            exit(0);
+        }
+        problem->para_index[problem->n] = k;
+        problem->lower[problem->n] = lower;
+        problem->upper[problem->n] = upper;
+        problem->n++;
+    }
+    fclose(fp);
+    if (problem->n == 0)
+    {
+        printf("Error: no calibration parameter in %s\n", FP);
+        exit(0);
+    }
+}
+
+static void SCEUA_Path(
+    char *FP,
+    char *PATH_OUT,
+    char *name
+)
+{
+    /* the output file PATH_OUT/name, into FP[MAXCHAR] */
+    if (snprintf(FP, MAXCHAR, "%s%s", PATH_OUT, name) >= MAXCHAR)
+    {
+        printf("Error: the output file path is longer than %d characters: %s%s\n", MAXCHAR - 1, PATH_OUT, name);
+        exit(0);
+    }
+}
+
+static void SCEUA_Evaluate(
+    ENSEMBLE_DATA *ens,
+    SCEUA_PROBLEM *problem,
+    ENSEMBLE_PARA *para,
+    ENSEMBLE_MEMBER *member,
+    double **point,
+    double *score_min,
+    double *f,
+    int count
+)
+{
+    /* simulate the points as one ensemble; f = 1 - score, INFINITY (rejected) if the score,
+       or the bound of the score of an aborted run, is not above the threshold score_min of the point */
+    int n = problem->n;
+    double score;
+    CALIB_EVAL *eval;
+    for (int i = 0; i < count; i++)
+    {
+        Calib_Eval_Init(
+            problem->eval + i,
+            &problem->obs,
+            problem->outlet,
+            ens->GP->CALIB_WARMUP,
+            problem->objective,
+            (problem->early_stop == 1) ? *(score_min + i) : -INFINITY);
+        (member + i)->eval = problem->eval + i;
+        *(para + i) = problem->para_default;
+        for (int j = 0; j < n; j++)
+        {
+            *Ensemble_Para_Field(para + i, problem->para_index[j]) = *(*(point + i) + j);
+        }
+    }
+    Ensemble_Reset(ens, para, member, count);
+    Ensemble_Run(ens, para, member, count);
+    for (int i = 0; i < count; i++)
+    {
+        eval = problem->eval + i;
+        score = Calib_Eval_Score(eval);
+        *(f + i) = (score <= *(score_min + i)) ? INFINITY : 1.0 - score;
+        problem->evals++;
+        problem->aborted += (eval->status == CALIB_RUN_BOUND) ? 1 : 0;
+        problem->steps_run += eval->steps;
+        // aborted: the bound, the score of the days so far, and the step of the abort
+        fprintf(problem->fp_trace, "%8d %6d %12.6f %12.6f %6d %6s",
+                problem->evals, problem->loop, score,
+                Calib_Stats_Score(&eval->stats, problem->objective), eval->steps,
+                (eval->status == CALIB_RUN_BOUND) ? "bound" : "-");
+        for (int j = 0; j < n; j++)
+        {
+            fprintf(problem->fp_trace, " %12.6g", *(*(point + i) + j));
+        }
+        fprintf(problem->fp_trace, "\n");
+    }
+    fflush(problem->fp_trace);
+}
+
+static void SCEUA_Sort(
+    double *x,
+    double *f,
+    int count,
+    int n
+)
+{
+    /* sort the points by f, ascending (insertion sort: the populations are small) */
+    double f_i;
+    double x_i[ENSEMBLE_PARA_COUNT];
+    int j;
+    for (int i = 1; i < count; i++)
+    {
+        f_i = *(f + i);
+        memcpy(x_i, x + i * n, sizeof(double) * n);
+        for (j = i - 1; j >= 0 && *(f + j) > f_i; j--)
+        {
+            *(f + j + 1) = *(f + j);
+            memcpy(x + (j + 1) * n, x + j * n, sizeof(double) * n);
+        }
+        *(f + j + 1) = f_i;
+        memcpy(x + (j + 1) * n, x_i, sizeof(double) * n);
+    }
+}
+
+static void SCEUA_Random_Point(
+    SCEUA_PROBLEM *problem,
+    double *lower,
+    double *upper,
+    double *point
+)
+{
+    for (int j = 0; j < problem->n; j++)
+    {
+        *(point + j) = lower[j] + SCEUA_Random(&problem->seed) * (upper[j] - lower[j]);
+    }
+}
+
+void SCEUA_Calibrate(
+    ENSEMBLE_DATA *ens
+)
+{
+    GLOBAL_PARA *GP = ens->GP;
+    SCEUA_PROBLEM problem;
+    int n, p, m, q, s;
+    char FP[MAXCHAR];
+    FILE *fp_history;
+
+    SCEUA_Import(GP->FP_CALIB, &problem);
+    Ensemble_Para_Default(GP, &problem.para_default);
+    Calib_Obs_Import(GP->FP_QOBS, ens->start_time, ens->time_steps_run, GP->STEP_TIME, &problem.obs);
+    Ensemble_Forcing_Load(ens);
+    if (strcmp(GP->CALIB_OBJECTIVE, "NSE") == 0)
+    {
+        problem.objective = CALIB_NSE;
+    }
+    else if (strcmp(GP->CALIB_OBJECTIVE, "KGE") == 0)
+    {
+        problem.objective = CALIB_KGE;
+    }
+    else
+    {
+        printf("Unrecognized CALIB_OBJECTIVE: %s (NSE or KGE)\n", GP->CALIB_OBJECTIVE);
+        exit(0);
+    }
+    if (GP->CALIB_OUTLET < 0 || GP->CALIB_OUTLET >= ens->outlet_count)
+    {
+        printf("CALIB_OUTLET out of the outlets 0, ..., %d: %d\n", ens->outlet_count - 1, GP->CALIB_OUTLET);
+        exit(0);
+    }
+    if (GP->SCEUA_COMPLEXES < 1)
+    {
+        printf("SCEUA_COMPLEXES should be positive: %d\n", GP->SCEUA_COMPLEXES);
+        exit(0);
+    }
+    problem.outlet = GP->CALIB_OUTLET;
+    problem.early_stop = GP->CALIB_EARLY_STOP;
+    problem.score_min = GP->CALIB_SCORE_MIN;
+    problem.evals = 0;
+    problem.aborted = 0;
+    problem.steps_run = 0.0;
+    problem.loop = 0;
+    problem.seed = (unsigned long long)GP->SCEUA_SEED;
+    n = problem.n;
+    p = GP->SCEUA_COMPLEXES;
+    m = 2 * n + 1;
+    q = n + 1;
+    s = p * m;
+    printf("* calibration: %d parameters, %d complexes of %d points, %d observed days, objective %s at outlet %d\n",
+           n, p, m, problem.obs.obs_count, GP->CALIB_OBJECTIVE, problem.outlet);
+
+    SCEUA_Path(FP, GP->PATH_OUT, "SCEUA_trace.txt");
+    if ((problem.fp_trace = fopen(FP, "w")) == NULL)
+    {
+        printf("File Error: cannot create or open output file: %s\n", FP);
+        exit(0);
+    }
+    SCEUA_Path(FP, GP->PATH_OUT, "SCEUA_history.txt");
+    if ((fp_history = fopen(FP, "w")) == NULL)
+    {
+        printf("File Error: cannot create or open output file: %s\n", FP);
+        exit(0);
+    }
+    fprintf(problem.fp_trace, "# %6s %6s %12s %12s %6s %6s", "eval", "loop", GP->CALIB_OBJECTIVE, "so_far", "steps", "stop");
+    fprintf(fp_history, "# %4s %8s %12s %12s %12s", "loop", "evals", "best", "worst", "range");
+    for (int j = 0; j < n; j++)
+    {
+        fprintf(problem.fp_trace, " %12s", Ensemble_Para_Name(problem.para_index[j]));
+        fprintf(fp_history, " %12s", Ensemble_Para_Name(problem.para_index[j]));
+    }
+    fprintf(problem.fp_trace, "\n");
+    fprintf(fp_history, "\n");
+
+    /* the ensemble members: at most s simulations at a time */
+    ENSEMBLE_PARA *para;
+    ENSEMBLE_MEMBER *member;
+    para = (ENSEMBLE_PARA *)malloc(sizeof(ENSEMBLE_PARA) * s);
+    member = (ENSEMBLE_MEMBER *)malloc(sizeof(ENSEMBLE_MEMBER) * s);
+    double *x, *f;            // the population, s points
+    double *cx, *cf;          // the complexes, p * m points
+    double *cand, *cand_f;    // the new point of each complex
+    double *batch_f;          // the criterion of the contraction or random points
+    double *score_min;        // the abort threshold of the points of a simulation batch
+    double **point;           // the points of a simulation batch
+    double *centroid;         // the centroid of a sub-complex, p * n
+    int *worst;               // position of the worst point of the sub-complex in its complex
+    int *pending;             // 1: the complex still needs a point in this evolution step
+    double *c_lower, *c_upper; // the smallest hypercube containing a complex, p * n
+    double *best_history;     // the best criterion after each loop
+    x = (double *)malloc(sizeof(double) * s * n);
+    f = (double *)malloc(sizeof(double) * s);
+    cx = (double *)malloc(sizeof(double) * s * n);
+    cf = (double *)malloc(sizeof(double) * s);
+    cand = (double *)malloc(sizeof(double) * p * n);
+    cand_f = (double *)malloc(sizeof(double) * p);
+    batch_f = (double *)malloc(sizeof(double) * p);
+    score_min = (double *)malloc(sizeof(double) * s);
+    problem.eval = (CALIB_EVAL *)malloc(sizeof(CALIB_EVAL) * s);
+    point = (double **)malloc(sizeof(double *) * s);
+    centroid = (double *)malloc(sizeof(double) * p * n);
+    worst = (int *)malloc(sizeof(int) * p);
+    pending = (int *)malloc(sizeof(int) * p);
+    c_lower = (double *)malloc(sizeof(double) * p * n);
+    c_upper = (double *)malloc(sizeof(double) * p * n);
+    best_history = (double *)malloc(sizeof(double) * (GP->SCEUA_EVALS_MAX + 2));
+    if (para == NULL || member == NULL || x == NULL || f == NULL || cx == NULL || cf == NULL ||
+        cand == NULL || cand_f == NULL || batch_f == NULL || score_min == NULL || problem.eval == NULL || point == NULL || centroid == NULL || worst == NULL ||
+        pending == NULL || c_lower == NULL || c_upper == NULL || best_history == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (int i = 0; i < s; i++)
+    {
+        Ensemble_Allocate(ens, member + i);
+    }
+
+    /* the initial population: uniform in the parameter ranges */
+    for (int i = 0; i < s; i++)
+    {
+        SCEUA_Random_Point(&problem, problem.lower, problem.upper, x + i * n);
+        *(point + i) = x + i * n;
+        *(score_min + i) = -INFINITY;   // the population is ranked by the full scores
+    }
+    SCEUA_Evaluate(ens, &problem, para, member, point, score_min, f, s);
+    SCEUA_Sort(x, f, s, n);
+
+    int stop = 0;
+    int sub[ENSEMBLE_PARA_COUNT + 1];  // positions of the sub-complex points in the complex, ascending
+    int count, L, found;
+    double u, range;
+    double *cxk;
+    while (stop == 0)
+    {
+        problem.loop++;
+        /* partition into complexes: point i of the sorted population to complex i % p */
+        for (int k = 0; k < p; k++)
+        {
+            for (int j = 0; j < m; j++)
+            {
+                memcpy(cx + (k * m + j) * n, x + (j * p + k) * n, sizeof(double) * n);
+                *(cf + k * m + j) = *(f + j * p + k);
+            }
+        }
+        /* competitive complex evolution: 2n + 1 steps, all the complexes in lockstep */
+        for (int step = 0; step < 2 * n + 1 && problem.evals < GP->SCEUA_EVALS_MAX; step++)
+        {
+            for (int k = 0; k < p; k++)
+            {
+                cxk = cx + k * m * n;
+                /* the sub-complex: q points, trapezoidal probability, favouring the better ones */
+                count = 0;
+                while (count < q)
+                {
+                    u = SCEUA_Random(&problem.seed);
+                    L = (int)floor(m + 0.5 - sqrt((m + 0.5) * (m + 0.5) - m * (m + 1) * u));
+                    L = (L > m - 1) ? m - 1 : L;
+                    found = 0;
+                    for (int i = 0; i < count; i++)
+                    {
+                        found = (sub[i] == L) ? 1 : found;
+                    }
+                    if (found == 0)
+                    {
+                        sub[count] = L;
+                        count++;
+                    }
+                }
+                for (int i = 1; i < q; i++)
+                {
+                    for (int j = i; j > 0 && sub[j - 1] > sub[j]; j--)
+                    {
+                        L = sub[j]; sub[j] = sub[j - 1]; sub[j - 1] = L;
+                    }
+                }
+                worst[k] = sub[q - 1];
+                /* the centroid of the q - 1 better points, the reflection of the worst point */
+                for (int j = 0; j < n; j++)
+                {
+                    *(centroid + k * n + j) = 0.0;
+                    for (int i = 0; i < q - 1; i++)
+                    {
+                        *(centroid + k * n + j) += *(cxk + sub[i] * n + j) / (q - 1);
+                    }
+                    *(c_lower + k * n + j) = *(cxk + j);
+                    *(c_upper + k * n + j) = *(cxk + j);
+                    for (int i = 1; i < m; i++)
+                    {
+                        *(c_lower + k * n + j) = fmin(*(c_lower + k * n + j), *(cxk + i * n + j));
+                        *(c_upper + k * n + j) = fmax(*(c_upper + k * n + j), *(cxk + i * n + j));
+                    }
+                }
+                pending[k] = 0;
+                for (int j = 0; j < n; j++)
+                {
+                    *(cand + k * n + j) = 2 * *(centroid + k * n + j) - *(cxk + worst[k] * n + j);
+                    if (*(cand + k * n + j) < problem.lower[j] || *(cand + k * n + j) > problem.upper[j])
+                    {
+                        pending[k] = 1;
+                    }
+                }
+                if (pending[k] == 1)
+                {
+                    // outside the ranges: a random point of the complex hypercube instead
+                    SCEUA_Random_Point(&problem, c_lower + k * n, c_upper + k * n, cand + k * n);
+                }
+                *(point + k) = cand + k * n;
+                *(score_min + k) = fmax(problem.score_min, 1.0 - *(cf + k * m + worst[k]));
+            }
+            SCEUA_Evaluate(ens, &problem, para, member, point, score_min, cand_f, p);
+            /* reflection not better than the worst point: contraction */
+            count = 0;
+            for (int k = 0; k < p; k++)
+            {
+                pending[k] = (*(cand_f + k) < *(cf + k * m + worst[k])) ? 0 : 1;
+                if (pending[k] == 1)
+                {
+                    for (int j = 0; j < n; j++)
+                    {
+                        *(cand + k * n + j) = (*(centroid + k * n + j) + *(cx + (k * m + worst[k]) * n + j)) / 2;
+                    }
+                    *(point + count) = cand + k * n;
+                    *(score_min + count) = fmax(problem.score_min, 1.0 - *(cf + k * m + worst[k]));
+                    count++;
+                }
+            }
+            if (count > 0)
+            {
+                SCEUA_Evaluate(ens, &problem, para, member, point, score_min, batch_f, count);
+                count = 0;
+                for (int k = 0; k < p; k++)
+                {
+                    if (pending[k] == 1)
+                    {
+                        *(cand_f + k) = *(batch_f + count);
+                        count++;
+                    }
+                }
+            }
+            /* contraction not better either: a random point of the complex hypercube */
+            count = 0;
+            for (int k = 0; k < p; k++)
+            {
+                if (pending[k] == 1 && *(cand_f + k) >= *(cf + k * m + worst[k]))
+                {
+                    pending[k] = 2;
+                    SCEUA_Random_Point(&problem, c_lower + k * n, c_upper + k * n, cand + k * n);
+                    *(point + count) = cand + k * n;
+                    *(score_min + count) = -INFINITY;   // accepted whatever its score
+                    count++;
+                }
+            }
+            if (count > 0)
+            {
+                SCEUA_Evaluate(ens, &problem, para, member, point, score_min, batch_f, count);
+                count = 0;
+                for (int k = 0; k < p; k++)
+                {
+                    if (pending[k] == 2)
+                    {
+                        *(cand_f + k) = *(batch_f + count);
+                        count++;
+                    }
+                }
+            }
+            /* the new point replaces the worst point of the sub-complex */
+            for (int k = 0; k < p; k++)
+            {
+                memcpy(cx + (k * m + worst[k]) * n, cand + k * n, sizeof(double) * n);
+                *(cf + k * m + worst[k]) = *(cand_f + k);
+                SCEUA_Sort(cx + k * m * n, cf + k * m, m, n);
+            }
+        }
+        /* shuffle: the complexes back into the population */
+        memcpy(x, cx, sizeof(double) * s * n);
+        memcpy(f, cf, sizeof(double) * s);
+        SCEUA_Sort(x, f, s, n);
+
+        /* the normalized geometric range of the population */
+        range = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            double x_min = *(x + j), x_max = *(x + j);
+            for (int i = 1; i < s; i++)
+            {
+                x_min = fmin(x_min, *(x + i * n + j));
+                x_max = fmax(x_max, *(x + i * n + j));
+            }
+            range += log(fmax(x_max - x_min, 1e-300) / (problem.upper[j] - problem.lower[j]));
+        }
+        range = exp(range / n);
+        best_history[problem.loop] = *f;
+        fprintf(fp_history, "  %4d %8d %12.6f %12.6f %12.3e", problem.loop, problem.evals, 1 - *f, 1 - *(f + s - 1), range);
+        for (int j = 0; j < n; j++)
+        {
+            fprintf(fp_history, " %12.6g", *(x + j));
+        }
+        fprintf(fp_history, "\n");
+        fflush(fp_history);
+        printf("* SCE-UA loop %3d: %6d simulations, best %s %.4f\n", problem.loop, problem.evals, GP->CALIB_OBJECTIVE, 1 - *f);
+
+        /* convergence */
+        if (problem.evals >= GP->SCEUA_EVALS_MAX)
+        {
+            printf("* SCE-UA: SCEUA_EVALS_MAX = %d simulations reached\n", GP->SCEUA_EVALS_MAX);
+            stop = 1;
+        }
+        else if (range < GP->SCEUA_PEPS)
+        {
+            printf("* SCE-UA: the population has converged within SCEUA_PEPS = %g of the parameter ranges\n", GP->SCEUA_PEPS);
+            stop = 1;
+        }
+        else if (problem.loop > GP->SCEUA_LOOPS_STOP &&
+                 fabs(best_history[problem.loop - GP->SCEUA_LOOPS_STOP] - *f) <
+                     GP->SCEUA_PCENTO * fmax(fabs(*f), 1e-10))
+        {
+            printf("* SCE-UA: the best %s improved by less than SCEUA_PCENTO = %g in %d loops\n",
+                   GP->CALIB_OBJECTIVE, GP->SCEUA_PCENTO, GP->SCEUA_LOOPS_STOP);
+            stop = 1;
+        }
+    }
+
+    /* the best parameter set */
+    ENSEMBLE_PARA best = problem.para_default;
+    for (int j = 0; j < n; j++)
+    {
+        *Ensemble_Para_Field(&best, problem.para_index[j]) = *(x + j);
+    }
+    SCEUA_Path(FP, GP->PATH_OUT, "SCEUA_best.txt");
+    FILE *fp_best;
+    if ((fp_best = fopen(FP, "w")) == NULL)
+    {
+        printf("File Error: cannot create or open output file: %s\n", FP);
+        exit(0);
+    }
+    fprintf(fp_best, "# SCE-UA: %s %.6f at outlet %d, %d simulations, %d loops\n",
+            GP->CALIB_OBJECTIVE, 1 - *f, problem.outlet, problem.evals, problem.loop);
+    printf("* best %s: %.4f\n", GP->CALIB_OBJECTIVE, 1 - *f);
+    if (problem.early_stop == 1)
+    {
+        printf("* early termination: %d of %d simulations aborted, %.1f%% of the simulation steps saved\n",
+               problem.aborted, problem.evals,
+               100.0 * (1.0 - problem.steps_run / ((double)problem.evals * ens->time_steps_run)));
+    }
+    for (int k = 0; k < ENSEMBLE_PARA_COUNT; k++)
+    {
+        fprintf(fp_best, "%s,%.15g\n", Ensemble_Para_Name(k), *Ensemble_Para_Field(&best, k));
+        printf("%18s: %.6g\n", Ensemble_Para_Name(k), *Ensemble_Para_Field(&best, k));
+    }
+    fclose(fp_best);
+    fclose(fp_history);
+    fclose(problem.fp_trace);
+
+    Ensemble_Free(ens, member, s);
+    Calib_Obs_Free(&problem.obs);
+    free(para); free(member);
+    free(x); free(f); free(cx); free(cf); free(cand); free(cand_f); free(batch_f); free(score_min); free(problem.eval); free(point);
+    free(centroid); free(worst); free(pending); free(c_lower); free(c_upper); free(best_history);
+}
@@ -0,0 +1,9 @@
+#ifndef SCEUA
+#define SCEUA
+
+#include "Ensemble.h"
+
+void SCEUA_Calibrate(
+    ENSEMBLE_DATA *ens);
+
+#endif
@@ -20,6 +20,7 @@
 #include <math.h>
 #include "Constants.h"
 #include "SnowEnergy.h"
+#include "Func_Tem.h"
 
 
 double FLUX_net_radiation(
@@ -110,16 +111,16 @@ double FLUX_latent(
     double VaporPressure_snow; // saturated vapor pressure at the snow surface, kPa
     if (Tem_air >= 0.0)
     {
-        VaporPressure_air = 0.6108 * exp(17.277 * Tem_air / (Tem_air + 273.3)) * Rhu / 100.0;
+        VaporPressure_air = e0(Tem_air) * Rhu / 100.0;
     } else {
-        VaporPressure_air = 0.6108 * exp(21.870 * Tem_air / (Tem_air + 265.5)) * Rhu / 100.0;
+        VaporPressure_air = e0_ice(Tem_air) * Rhu / 100.0;
     }
     
     if (Tem_snow >= 0.0)
     {
-        VaporPressure_snow = 0.6108 * exp(17.277 * Tem_snow / (Tem_snow + 273.3));
+        VaporPressure_snow = e0(Tem_snow);
     } else {
-        VaporPressure_snow = 0.6108 * exp(21.870 * Tem_snow / (Tem_snow + 265.5));
+        VaporPressure_snow = e0_ice(Tem_snow);
     }
     
     if (L==1)
@@ -8,6 +8,7 @@
 #include "SnowEnergy.h"
 #include "SnowAccuMelt.h"
 #include "SnowAtmosphericStability.h"
+#include "Func_Tem.h"
 
 
 #define MAXCHAR 3000
@@ -166,6 +167,11 @@ int main(int argc, char * argv[]) {
         p_gp->FILE_PATH, p_gp->FILE_OUT, p_gp->FILE_OUT
     );
 
+    Func_Tem_Init();  // tables of the saturated vapor pressure, with FUNC_TEM_TABLE
+#ifdef FUNC_TEM_TABLE
+    Func_Tem_Report();
+#endif
+
     Struct_Meteo TS_Meteo[MAXrow];
     int nrow = 0; // number of rows in the data file
     nrow = import_Meteo(p_gp, TS_Meteo);
@@ -29,11 +29,10 @@
  * double Soil_Moisture        - soil moisture (water content)
  * double Soil_Porosity        - soil porosity
  * double Soil_Conduct_Sat     - saturated soil hydraulic conductivity, [m/h]
- * double Air_Entry_Pres       - air-entry pressure head, [m]
- * double b                    - soil pore-size distribution parameter
+ * double Tension_effective    - effective tension at the wetting front, [m]
+ *                               (2b+3)/(2b+6)*|air-entry pressure head|, see Derive_Soil_Para_CELL()
  * double Infiltration         - water amount infiltrated into soil layer, [m]
  * int step_time               - time interval, [h]
- * double Tension_effective    - effective tension at the wetting front, [m]
  * 
 ****************************************************************/
 
@@ -46,8 +45,7 @@ double Soil_Infiltration(
     double Soil_Moisture,
     double Soil_Porosity,
     double Soil_Conduct_Sat,
-    double Air_Entry_Pres,
-    double b, 
+    double Tension_effective,
     int step_time
 )
 {
@@ -64,12 +62,6 @@ double Soil_Infiltration(
     }
     else
     {
-        double Tension_effective;
-        if (Air_Entry_Pres < 0.0) {
-            Air_Entry_Pres = - Air_Entry_Pres;
-        }
-        Tension_effective = (2 * b + 3) / (2 * b + 6) * Air_Entry_Pres;
-
         double Tx, Tc, Tp; 
         /****
          * time parameters:
@@ -129,6 +121,7 @@ double Soil_Infiltration(
 //     double Soil_Conduct_Sat = 0.00078;
 //     double Air_Entry_Pres = 0.405;
 //     double b = 11.4;
+//     double Tension_effective = (2 * b + 3) / (2 * b + 6) * Air_Entry_Pres;
 //     int step_time = 24;
 //     int i;
 //     double SI;
@@ -139,8 +132,7 @@ double Soil_Infiltration(
 //         Soil_Moisture,
 //         Soil_Porosity,
 //         Soil_Conduct_Sat,
-//         Air_Entry_Pres,
-//         b,
+//         Tension_effective,
 //         step_time);
 //         printf("%f %f\n", Water_input[i] * 1000, SI * 1000);
 //     }
@@ -6,8 +6,7 @@ double Soil_Infiltration(
     double Soil_Moisture,
     double Soil_Porosity,
     double Soil_Conduct_Sat,
-    double Air_Entry_Pres,
-    double b, 
+    double Tension_effective,
     int step_time
 );
 
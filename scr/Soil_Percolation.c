@@ -33,7 +33,8 @@
  * double Soil_Porosity          - soil porosity, [FRAC, 0-1.0]
  * double Soil_Residual          - residual soil moisture content, [FRAC, 0-1.0]
  * double Soil_Conduct_Sat       - soil vertical saturated hydraulic conductivity, [m/h]
- * double Soil_PoreSize_index    - the pore size distribution index, b, [dimensionless]
+ * double Soil_BC_exp            - Brooks-Corey conductivity exponent, 2b+3,
+ *                                 b: the pore size distribution index, [dimensionless]
  * int step_time                 - time step, [h] 
  * double Soil_Conduct           - soil vertical unsaturated hydraulic conductivity, [m/h]
  * 
@@ -52,7 +53,7 @@ double Percolation(
     double Soil_Porosity,
     double Soil_Residual,
     double Soil_Conduct_Sat,
-    double Soil_PoreSize_index,
+    double Soil_BC_exp,
     int step_time 
 )
 {
@@ -62,12 +63,12 @@ double Percolation(
     double Soil_Moisture_AVG;
     Soil_Conduct = Soil_Hydro_Conductivity(
         Soil_Moisture, Soil_Porosity, Soil_Residual, 
-        Soil_Conduct_Sat, Soil_PoreSize_index
+        Soil_Conduct_Sat, Soil_BC_exp
     );
     Soil_Conduct_end = Soil_Hydro_Conductivity(
         Soil_Moisture + Percolation_in / Soil_layer_thickness, 
         Soil_Porosity, Soil_Residual, 
-        Soil_Conduct_Sat, Soil_PoreSize_index
+        Soil_Conduct_Sat, Soil_BC_exp
     );
     /************************
      * Soil_Conduct_end >= Soil_Conduct; 
@@ -76,7 +77,7 @@ double Percolation(
      * SW_avail >= 0.0;
     */
     Soil_Conduct_AVG = 0.5 * (Soil_Conduct_end + Soil_Conduct);
-    Soil_Moisture_AVG = pow(Soil_Conduct_AVG / Soil_Conduct_Sat, 1 / (2 * Soil_PoreSize_index + 3)) * (Soil_Porosity - Soil_Residual) + Soil_Residual;
+    Soil_Moisture_AVG = pow(Soil_Conduct_AVG / Soil_Conduct_Sat, 1 / Soil_BC_exp) * (Soil_Porosity - Soil_Residual) + Soil_Residual;
     
     Percolation_out = Soil_Conduct_AVG * ((double)step_time);
 
@@ -97,7 +98,7 @@ double Soil_Hydro_Conductivity(
     double Soil_Porosity,
     double Soil_Residual,
     double Soil_Conduct_Sat,
-    double Soil_PoreSize_index
+    double Soil_BC_exp
 )
 {
     /*********
@@ -114,7 +115,7 @@ double Soil_Hydro_Conductivity(
     {
         Soil_Conduct = Soil_Conduct_Sat * pow(
                                               (Soil_Moisture - Soil_Residual) / (Soil_Porosity - Soil_Residual),
-                                              (2 * Soil_PoreSize_index + 3));
+                                              Soil_BC_exp);
     }
     else
     {
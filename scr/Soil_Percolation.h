@@ -9,7 +9,7 @@ double Percolation(
     double Soil_Porosity,
     double Soil_Residual,
     double Soil_Conduct_Sat,
-    double Soil_PoreSize_index,
+    double Soil_BC_exp,
     int step_time 
 );
 
@@ -18,7 +18,7 @@ double Soil_Hydro_Conductivity(
     double Soil_Porosity,
     double Soil_Residual,
     double Soil_Conduct_Sat,
-    double Soil_PoreSize_index
+    double Soil_BC_exp
 );
 
 
@@ -9,7 +9,9 @@
  * DESCRIPTION:  Calculate saturated water movement
  * DESCRIP-END.
  * FUNCTIONS:    Soil_Satu_grad();Soil_Satu_Outflow();
- *               Soil_Satu_Stream();Soil_Satu_Move();
+ *               Soil_Satu_Stream();Soil_Satu_Move();Soil_Satu_Band();
+ *               Soil_Satu_Outflow_Band();Soil_Satu_Update();
+ *               Soil_Satu_Substeps();
  * COMMENTS:
  * 
  * 
@@ -29,6 +31,12 @@
  * double *Qin                          - total inflow to the cell, [m3/h]
  * double n                             - the local power law exponent, decaying coefficient of lateral hydraulic conductivity
  * double *F                            - pointer to an array of outflow fractions to 8 directions
+ * int *cell_index                      - 1D raster index of the active cells (see CELL_LIST in HM_ST.h)
+ * int cell_count                       - number of active cells
+ * ST_SOIL_PARA_CELL *soil_para         - derived soil parameters of all the cells, see Derive_Soil_Para_CELL()
+ * int satu_kernel                      - outflow kernel: SATU_KERNEL_SCALAR or SATU_KERNEL_SIMD
+ * int substeps                         - number of sub-steps of step_time in Soil_Satu_Move()
+ * double cfl                           - safety factor of the stable sub-step, (0, 1]
  *
  *
  * REFERENCEs:
@@ -40,6 +48,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "Constants.h"
 #include "HM_ST.h"
@@ -133,6 +144,82 @@ void Soil_Satu_Outflow(
     }
 }
 
+void Soil_Satu_Outflow_Band(
+    int *cell_index,
+    int c_begin,
+    int c_end,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    int ncols
+)
+{
+    /******************************************
+     * branch-free form of Soil_Satu_Outflow() over the cells
+     * cell_index[c_begin, c_end), for SIMD vectorization (omp simd),
+     * in blocks of SATU_BLOCK cells:
+     * the invalid neighbours and gamma <= 0 are masked by selects instead
+     * of branches, an invalid neighbour reads the cell itself instead of
+     * a cell that may lie outside the raster;
+     * h = pow() is taken from the C library in a scalar loop ahead of the
+     * vector loop, so that the results equal Soil_Satu_Outflow() bit for bit
+    */
+    int offset[8];
+    double h[SATU_BLOCK];     // soil moisture deficit of the cells in the block
+    int c_block, b_count;
+    offset[0] = - ncols - 1;
+    offset[1] = - ncols;
+    offset[2] = - ncols + 1;
+    offset[3] = 1;
+    offset[4] = ncols + 1;
+    offset[5] = ncols;
+    offset[6] = ncols - 1;
+    offset[7] = -1;
+    for (c_block = c_begin; c_block < c_end; c_block += SATU_BLOCK)
+    {
+        b_count = c_end - c_block;
+        if (b_count > SATU_BLOCK)
+        {
+            b_count = SATU_BLOCK;
+        }
+        for (int b = 0; b < b_count; b++)
+        {
+            int index_geo = *(cell_index + c_block + b);
+            h[b] = pow(1 - *(data_SOIL->z + index_geo) / Soil_Thickness, (soil_para + index_geo)->DecayCoeff);
+        }
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+        for (int b = 0; b < b_count; b++)
+        {
+            int index_geo;
+            int valid;
+            double z_rf, WT_rf;
+            double Trans;   // Soil_Conduct_Sat_Lateral * Soil_Thickness / n
+            double Qout = 0.0;
+            double gamma_sum = 0.0;
+            double gamma[8];
+            index_geo = *(cell_index + c_block + b);
+            z_rf = *(data_SOIL->z + index_geo) + *(data_NEIGHBOR->z_offset + index_geo);
+            Trans = (soil_para + index_geo)->Ksat_lateral * Soil_Thickness / (soil_para + index_geo)->DecayCoeff;
+            for (int k = 0; k < 8; k++)
+            {
+                valid = (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1);
+                WT_rf = *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) +
+                        *(data_SOIL->z + index_geo + valid * offset[k]);
+                gamma[k] = (valid & (WT_rf > z_rf)) ? - (z_rf - WT_rf) * Trans : 0.0;
+                gamma_sum += gamma[k];
+                Qout += h[b] * gamma[k];
+            }
+            *(data_SOIL->Qout + index_geo) = Qout;
+            for (int k = 0; k < 8; k++)
+            {
+                *(data_SOIL->q[k] + index_geo) = (gamma_sum > 0.0) ? gamma[k] / gamma_sum * Qout : 0.0;
+            }
+        }
+    }
+}
 
 double Soil_Satu_Stream(
     double z,
@@ -167,13 +254,13 @@ double Soil_Satu_Stream(
 }
 
 void Soil_Satu_Move(
-    int *data_DEM,
+    int *cell_index,
+    int cell_count,
     int *data_STR,
-    int *data_SOILTYPE,
     CELL_VAR_STREAM **data_STREAM,
-    CELL_VAR_SOIL **data_SOIL,
-    ST_SoilLib *soillib,
-    ST_SoilID *soilID,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
     double Soil_Thickness,
     double Soil_d1,
     double Soil_d2,
@@ -181,90 +268,123 @@ void Soil_Satu_Move(
     double stream_width,
     int NODATA_value,
     int ncols,
-    int nrows,
     double step_space,
-    int step_time)
+    int step_time,
+    int satu_kernel,
+    int substeps)
 {
     /******************************************
-     * 
+     * two passes over the active cells (cell_index: every cell of valid DEM,
+     * see Initialize_CELL_LIST()), both gather-only:
+     * 1. the outflow q[8] of each cell, from the water tables z of its neighbours
+     * 2. the inflow of each cell, from the q[in_dir[k]] of its neighbours, and the update of z
+     * with OpenMP, each thread takes a band of whole rows (Soil_Satu_Band()),
+     * and the threads wait for each other between the two passes;
+     * the two passes are repeated for each of the substeps sub-steps of step_time
+     * (see Soil_Satu_Substeps()), the percolation is spread evenly over them;
+     * Qout, Qin and q[8] are left at the rates of the last sub-step
     */
     double cell_area;   // the area of the grid cell, m2
     cell_area = step_space * step_space; // total number of grid cells; size of 2D array
-    int index_geo;  
-    int index_geo_neighbor[8];
-    double Cell_WT_rf[8];
+    double step_sub;    // length of a sub-step, [h]
+    step_sub = (double) step_time / substeps;
 
     // direction where the rid cell receiving from other cells yielding outflow
     int in_dir[8] = {4, 5, 6, 7, 0, 1, 2, 3};
-    ST_SOIL_LIB_CELL cell_soil;
-    double Porosity; // depending on where is the water table, upper or lower soil layer;
-    double dZ; // water table changes
-    double dW; // water volume changes
 
-    /*********************************
-     * calculate the outflow from grid cell 
-     * into 8 directions
-     * */ 
-    for (size_t i = 0; i < nrows; i++)
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
     {
-        for (size_t j = 0; j < ncols; j++)
+        int index_geo;  
+        int i, j;  // row and col index of the cell
+        int index_geo_neighbor[8];
+        double Cell_WT_rf[8];
+        int Cell_neighbor[8];  // neighbour flags of the cell, gathered from data_NEIGHBOR
+        double Cell_q[8];      // outflow of the cell to 8 directions, scattered into data_SOIL->q
+        double z;  // water table of the cell
+        double Qc; // channel exchange of the cell in the sub-step, [m3/h]
+        double SW_rise_lower, SW_rise_upper, SW_rf;  // vertical exchange of the cell in the sub-step, [m]
+        int c_begin, c_end;  // the band of cells of this thread: cell_index[c_begin, c_end)
+
+#ifdef _OPENMP
+        Soil_Satu_Band(cell_index, cell_count, ncols, omp_get_thread_num(), omp_get_num_threads(), &c_begin, &c_end);
+#else
+        Soil_Satu_Band(cell_index, cell_count, ncols, 0, 1, &c_begin, &c_end);
+#endif
+
+        for (int sub = 0; sub < substeps; sub++)
         {
-            index_geo = i * ncols + j;
-            if (*(data_DEM + index_geo) != NODATA_value)
+            /*********************************
+             * calculate the outflow from grid cell 
+             * into 8 directions
+             * */ 
+            if (satu_kernel == SATU_KERNEL_SIMD)
             {
-                Lookup_Soil_CELL(*(data_SOILTYPE + index_geo), &cell_soil, soillib, soilID);
-                index_geo_neighbor[0] = (i - 1) * ncols + j - 1;
-                index_geo_neighbor[1] = (i - 1) * ncols + j;
-                index_geo_neighbor[2] = (i - 1) * ncols + j + 1;
-                index_geo_neighbor[3] = i * ncols + j + 1;
-                index_geo_neighbor[4] = (i + 1) * ncols + j + 1;
-                index_geo_neighbor[5] = (i + 1) * ncols + j;
-                index_geo_neighbor[6] = (i + 1) * ncols + j - 1;
-                index_geo_neighbor[7] = i * ncols + j - 1;
-                
-                for (size_t k = 0; k < 8; k++)
+                Soil_Satu_Outflow_Band(cell_index, c_begin, c_end, data_SOIL, data_NEIGHBOR, soil_para, Soil_Thickness, ncols);
+            }
+            else
+            {
+                for (int c = c_begin; c < c_end; c++)
                 {
-                    if ((*data_SOIL + index_geo)->neighbor[k] == 1)
+                    index_geo = *(cell_index + c);
+                    i = index_geo / ncols;
+                    j = index_geo % ncols;
+                    index_geo_neighbor[0] = (i - 1) * ncols + j - 1;
+                    index_geo_neighbor[1] = (i - 1) * ncols + j;
+                    index_geo_neighbor[2] = (i - 1) * ncols + j + 1;
+                    index_geo_neighbor[3] = i * ncols + j + 1;
+                    index_geo_neighbor[4] = (i + 1) * ncols + j + 1;
+                    index_geo_neighbor[5] = (i + 1) * ncols + j;
+                    index_geo_neighbor[6] = (i + 1) * ncols + j - 1;
+                    index_geo_neighbor[7] = i * ncols + j - 1;
+            
+                    for (size_t k = 0; k < 8; k++)
                     {
-                        Cell_WT_rf[k] = (*data_SOIL + index_geo)->z_offset_neighbor[k] + 
-                        (*data_SOIL + index_geo_neighbor[k])->z;
+                        Cell_neighbor[k] = *(data_NEIGHBOR->neighbor[k] + index_geo);
+                        if (Cell_neighbor[k] == 1)
+                        {
+                            Cell_WT_rf[k] = *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) + 
+                            *(data_SOIL->z + index_geo_neighbor[k]);
+                        }
+                        else
+                        {
+                            Cell_WT_rf[k] = NODATA_value;
+                        }
                     }
-                    else
+                    /******************
+                     * calculate the outflow (q[8]) from this cell
+                     * to each direction and the total outflow, [m3/h]
+                     */
+                    Soil_Satu_Outflow(
+                        *(data_SOIL->z + index_geo),
+                        *(data_NEIGHBOR->z_offset + index_geo),
+                        Cell_neighbor,
+                        Cell_WT_rf,
+                        Cell_q,
+                        data_SOIL->Qout + index_geo,
+                        (soil_para + index_geo)->Ksat_lateral,
+                        Soil_Thickness,
+                        (soil_para + index_geo)->DecayCoeff
+                        );
+                    for (size_t k = 0; k < 8; k++)
                     {
-                        Cell_WT_rf[k] = NODATA_value;
+                        *(data_SOIL->q[k] + index_geo) = Cell_q[k];
                     }
                 }
-                /******************
-                 * calculate the outflow (q[8]) from this cell
-                 * to each direction and the total outflow, [m3/h]
-                 */
-                Soil_Satu_Outflow(
-                    (*data_SOIL + index_geo)->z,
-                    (*data_SOIL + index_geo)->z_offset,
-                    (*data_SOIL + index_geo)->neighbor,
-                    Cell_WT_rf,
-                    (*data_SOIL + index_geo)->q,
-                    &((*data_SOIL + index_geo)->Qout),
-                    cell_soil.Topsoil->SatHydrauCond_Lateral,
-                    Soil_Thickness,
-                    cell_soil.Topsoil->DecayCoeff
-                    );
-                // printf("%f,", (*data_SOIL + index_geo)->Qout);
             }
-        }
-    }
-    /*****************************
-     * calculate the inflow of each grid cell
-     */
-
-    for (size_t i = 0; i < nrows; i++)
-    {
-        for (size_t j = 0; j < ncols; j++)
-        {
-            index_geo = i * ncols + j;
-            if (*(data_DEM + index_geo) != NODATA_value)
+            /*****************************
+             * calculate the inflow of each grid cell,
+             * once the outflow of all the cells is ready
+             */
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+            for (int c = c_begin; c < c_end; c++)
             {
-                Lookup_Soil_CELL(*(data_SOILTYPE + index_geo), &cell_soil, soillib, soilID);
+                index_geo = *(cell_index + c);
+                i = index_geo / ncols;
+                j = index_geo % ncols;
 
                 index_geo_neighbor[0] = (i - 1) * ncols + j - 1;
                 index_geo_neighbor[1] = (i - 1) * ncols + j;
@@ -275,98 +395,262 @@ void Soil_Satu_Move(
                 index_geo_neighbor[6] = (i + 1) * ncols + j - 1;
                 index_geo_neighbor[7] = i * ncols + j - 1;
 
-                (*data_SOIL + index_geo)->Qin = 0.0;
+                *(data_SOIL->Qin + index_geo) = 0.0;
                 for (size_t k = 0; k < 8; k++)
                 {
-                    if ((*data_SOIL + index_geo)->neighbor[k] == 1)
+                    if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
                     {
-                        (*data_SOIL + index_geo)->Qin += 
-                            (*data_SOIL + index_geo_neighbor[k])->q[in_dir[k]]; 
+                        *(data_SOIL->Qin + index_geo) += 
+                            *(data_SOIL->q[in_dir[k]] + index_geo_neighbor[k]); 
                     }
                 }
 
+                z = *(data_SOIL->z + index_geo);
                 if (*(data_STR + index_geo) == 1)
                 {
                     /* this is a cell with river channel/stream */
-                    (*data_STREAM + index_geo)->Qc = Soil_Satu_Stream(
-                        (*data_SOIL + index_geo)->z,
+                    Qc = Soil_Satu_Stream(
+                        z,
                         step_space,
                         stream_depth,
                         stream_width,
-                        cell_soil.Topsoil->SatHydrauCond_Lateral,
+                        (soil_para + index_geo)->Ksat_lateral,
                         Soil_Thickness,
-                        cell_soil.Topsoil->DecayCoeff);
-                }
-
-                /*******************
-                 * update:
-                 * - the underground (subsurface) water table, z
-                 * - the water volume transferred vertically, SW_sf, SW_rise
-                 ******/
-                if (
-                    (*data_SOIL + index_geo)->z <= Soil_d1)
-                {
-                    Porosity = cell_soil.Topsoil->Porosity / 100;
+                        (soil_para + index_geo)->DecayCoeff);
                 }
                 else
                 {
-                    Porosity = cell_soil.Subsoil->Porosity / 100;
-                }
-                /************
-                 * dW: the change of subsurface water volume:
-                 * - positive: net outflow
-                 * - negative: net inflow
-                 * the same for dZ
-                */
-                dW = ((*data_SOIL + index_geo)->Qout +
-                      (*data_STREAM + index_geo)->Qc -
-                      (*data_SOIL + index_geo)->Qin) /
-                         cell_area * step_time -
-                     (*data_SOIL + index_geo)->SW_Percolation_Lower;
-                dZ = dW / Porosity;
-                
-                // initialize
-                (*data_SOIL + index_geo)->SW_rise_lower = 0.0;
-                (*data_SOIL + index_geo)->SW_rise_upper = 0.0;
-                (*data_SOIL + index_geo)->SW_rf = 0.0;
-                if ((*data_SOIL + index_geo)->z + dZ > Soil_Thickness)
-                {
-                    // groundwater is depleted
-                    (*data_SOIL + index_geo)->z = Soil_Thickness;
+                    Qc = (*data_STREAM + index_geo)->Qc;
                 }
-                else if ((*data_SOIL + index_geo)->z + dZ < 0)
+
+                Soil_Satu_Update(
+                    index_geo,
+                    data_SOIL,
+                    soil_para,
+                    Qc,
+                    *(data_SOIL->SW_Percolation_Lower + index_geo) / substeps,
+                    Soil_Thickness,
+                    Soil_d1,
+                    cell_area,
+                    step_sub,
+                    &SW_rise_lower,
+                    &SW_rise_upper,
+                    &SW_rf);
+                /* the vertical exchange: sum over the sub-steps; the channel exchange: mean over the sub-steps */
+                if (sub == 0)
                 {
-                    /****
-                     * the rising water table reaches ground surface, net inflow
-                     * dZ < 0
-                     * dW < 0
-                     * */ 
-                    (*data_SOIL + index_geo)->SW_rf = - (dZ + (*data_SOIL + index_geo)->z) * Porosity;
-                    (*data_SOIL + index_geo)->SW_rise_upper = Porosity * (*data_SOIL + index_geo)->z;
-                    (*data_SOIL + index_geo)->z = 0.0;
+                    *(data_SOIL->SW_rise_lower + index_geo) = SW_rise_lower;
+                    *(data_SOIL->SW_rise_upper + index_geo) = SW_rise_upper;
+                    *(data_SOIL->SW_rf + index_geo) = SW_rf;
+                    (*data_STREAM + index_geo)->Qc = Qc;
                 }
                 else
                 {
-                    /********
-                     * water table fluctuates under ground
-                     */
-                    (*data_SOIL + index_geo)->z += dZ;
-                    if (dW < 0.0) // net inflow
+                    *(data_SOIL->SW_rise_lower + index_geo) += SW_rise_lower;
+                    *(data_SOIL->SW_rise_upper + index_geo) += SW_rise_upper;
+                    *(data_SOIL->SW_rf + index_geo) += SW_rf;
+                    if (*(data_STR + index_geo) == 1)
                     {
-                        if ((*data_SOIL + index_geo)->z > Soil_d1)
-                        {
-                            (*data_SOIL + index_geo)->SW_rise_lower = -dW;
-                        }
-                        else if ((*data_SOIL + index_geo)->z <= Soil_d1)
+                        (*data_STREAM + index_geo)->Qc += Qc;
+                        if (sub == substeps - 1)
                         {
-                            (*data_SOIL + index_geo)->SW_rise_upper = -dW;
+                            (*data_STREAM + index_geo)->Qc /= substeps;
                         }
                     }
                 }
             }
+            /* the water tables of this sub-step are complete before the outflow of the next one */
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
         }
     }
 }
 
+void Soil_Satu_Update(
+    int index_geo,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Qc,
+    double Percolation,
+    double Soil_Thickness,
+    double Soil_d1,
+    double cell_area,
+    double step_time,
+    double *SW_rise_lower,
+    double *SW_rise_upper,
+    double *SW_rf)
+{
+    /******************************************
+     * update the water table z of a cell over step_time from its outflow Qout,
+     * inflow Qin, channel exchange Qc and the percolation from the lower soil layer;
+     * returns the water volume exchanged vertically: SW_rise_lower, SW_rise_upper, SW_rf
+     */
+    double Porosity; // depending on where is the water table, upper or lower soil layer;
+    double dZ; // water table changes
+    double dW; // water volume changes
+    double z;  // water table of the cell
+    z = *(data_SOIL->z + index_geo);
+    /*******************
+     * update:
+     * - the underground (subsurface) water table, z
+     * - the water volume transferred vertically, SW_sf, SW_rise
+     ******/
+    if (z <= Soil_d1)
+    {
+        Porosity = (soil_para + index_geo)->Porosity_upper;
+    }
+    else
+    {
+        Porosity = (soil_para + index_geo)->Porosity_lower;
+    }
+    /************
+     * dW: the change of subsurface water volume:
+     * - positive: net outflow
+     * - negative: net inflow
+     * the same for dZ
+    */
+    dW = (*(data_SOIL->Qout + index_geo) + Qc - *(data_SOIL->Qin + index_geo)) /
+             cell_area * step_time -
+         Percolation;
+    dZ = dW / Porosity;
+
+    // initialize
+    *SW_rise_lower = 0.0;
+    *SW_rise_upper = 0.0;
+    *SW_rf = 0.0;
+    if (z + dZ > Soil_Thickness)
+    {
+        // groundwater is depleted
+        z = Soil_Thickness;
+    }
+    else if (z + dZ < 0)
+    {
+        /****
+         * the rising water table reaches ground surface, net inflow
+         * dZ < 0
+         * dW < 0
+         * */ 
+        *SW_rf = - (dZ + z) * Porosity;
+        *SW_rise_upper = Porosity * z;
+        z = 0.0;
+    }
+    else
+    {
+        /********
+         * water table fluctuates under ground
+         */
+        z += dZ;
+        if (dW < 0.0) // net inflow
+        {
+            if (z > Soil_d1)
+            {
+                *SW_rise_lower = -dW;
+            }
+            else if (z <= Soil_d1)
+            {
+                *SW_rise_upper = -dW;
+            }
+        }
+    }
+    *(data_SOIL->z + index_geo) = z;
+}
+
+int Soil_Satu_Substeps(
+    int *cell_index,
+    int cell_count,
+    int *data_STR,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    double Soil_d1,
+    double stream_width,
+    double step_space,
+    int step_time,
+    double cfl)
+{
+    /******************************************
+     * the number of sub-steps that keeps the explicit update of Soil_Satu_Move() stable:
+     * a cell with the transmissivity G = h * Ksat * D / n exchanges water with
+     * up to 8 neighbours (and the channel, 4 * L / W * G), so that
+     *      sub-step <= cfl * Porosity * A / ((8 + 4 * L / W) * G)
+     * taken at the water tables of the start of the step, the smallest over the cells;
+     * at most SATU_SUBSTEP_MAX sub-steps
+     */
+    double ratio_max = 0.0;   // the largest (8 + 4 * L / W) * G / Porosity, [m2/h]
+    double step_stable;       // the longest stable sub-step, [h]
+    int substeps;
 
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:ratio_max)
+#endif
+    for (int c = 0; c < cell_count; c++)
+    {
+        int index_geo;
+        double z, G, ratio;
+        index_geo = *(cell_index + c);
+        z = *(data_SOIL->z + index_geo);
+        G = pow(1 - z / Soil_Thickness, (soil_para + index_geo)->DecayCoeff) *
+            (soil_para + index_geo)->Ksat_lateral * Soil_Thickness / (soil_para + index_geo)->DecayCoeff;
+        ratio = 8 * G;
+        if (*(data_STR + index_geo) == 1)
+        {
+            ratio += 4 * step_space / stream_width * G;
+        }
+        if (z <= Soil_d1)
+        {
+            ratio /= (soil_para + index_geo)->Porosity_upper;
+        }
+        else
+        {
+            ratio /= (soil_para + index_geo)->Porosity_lower;
+        }
+        if (ratio > ratio_max)
+        {
+            ratio_max = ratio;
+        }
+    }
+    if (ratio_max <= 0.0)
+    {
+        return 1;
+    }
+    step_stable = cfl * step_space * step_space / ratio_max;
+    if (step_time / step_stable >= SATU_SUBSTEP_MAX)
+    {
+        return SATU_SUBSTEP_MAX;
+    }
+    substeps = (int)ceil(step_time / step_stable);
+    if (substeps < 1)
+    {
+        substeps = 1;
+    }
+    return substeps;
+}
 
+void Soil_Satu_Band(
+    int *cell_index,
+    int cell_count,
+    int ncols,
+    int band,
+    int band_count,
+    int *c_begin,
+    int *c_end)
+{
+    /******
+     * split the active cells (row-major order) into band_count bands of
+     * about the same number of cells; a band starts at the first cell of a row
+     */
+    int c;
+    c = (int)((long)cell_count * band / band_count);
+    while (c > 0 && c < cell_count && *(cell_index + c) / ncols == *(cell_index + c - 1) / ncols)
+    {
+        c++;
+    }
+    *c_begin = c;
+    c = (int)((long)cell_count * (band + 1) / band_count);
+    while (c > 0 && c < cell_count && *(cell_index + c) / ncols == *(cell_index + c - 1) / ncols)
+    {
+        c++;
+    }
+    *c_end = c;
+}
@@ -3,6 +3,13 @@
 #define SOIL_SATURATEDFLOW
 
 #include "HM_ST.h"
+#include "Lookup_SoilLib.h"
+
+/* SOIL_SATU_KERNEL: the kernel computing the outflow of the cells in Soil_Satu_Move() */
+#define SATU_KERNEL_SCALAR 0    // Soil_Satu_Outflow(), cell by cell
+#define SATU_KERNEL_SIMD 1      // Soil_Satu_Outflow_Band(), branch-free, several cells per vector
+#define SATU_BLOCK 64           // cells per block in Soil_Satu_Outflow_Band()
+#define SATU_SUBSTEP_MAX 1000   // the most sub-steps per step, see Soil_Satu_Substeps()
 
 double Soil_Satu_grad
 (
@@ -42,13 +49,13 @@ double Soil_Satu_Stream(
 
 
 void Soil_Satu_Move(
-    int *data_DEM,
+    int *cell_index,
+    int cell_count,
     int *data_STR,
-    int *data_SOILTYPE,
     CELL_VAR_STREAM **data_STREAM,
-    CELL_VAR_SOIL **data_SOIL,
-    ST_SoilLib *soillib,
-    ST_SoilID *soilID,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
     double Soil_Thickness,
     double Soil_d1,
     double Soil_d2,
@@ -56,9 +63,55 @@ void Soil_Satu_Move(
     double stream_width,
     int NODATA_value,
     int ncols,
-    int nrows,
     double step_space,
-    int step_time);
+    int step_time,
+    int satu_kernel,
+    int substeps);
+
+void Soil_Satu_Outflow_Band(
+    int *cell_index,
+    int c_begin,
+    int c_end,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    int ncols);
 
+void Soil_Satu_Update(
+    int index_geo,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Qc,
+    double Percolation,
+    double Soil_Thickness,
+    double Soil_d1,
+    double cell_area,
+    double step_time,
+    double *SW_rise_lower,
+    double *SW_rise_upper,
+    double *SW_rf);
+
+int Soil_Satu_Substeps(
+    int *cell_index,
+    int cell_count,
+    int *data_STR,
+    CELL_VAR_SOIL *data_SOIL,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    double Soil_d1,
+    double stream_width,
+    double step_space,
+    int step_time,
+    double cfl);
+
+void Soil_Satu_Band(
+    int *cell_index,
+    int cell_count,
+    int ncols,
+    int band,
+    int band_count,
+    int *c_begin,
+    int *c_end);
 
 #endif
\ No newline at end of file
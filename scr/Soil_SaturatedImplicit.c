@@ -0,0 +1,557 @@
+/*
+ * SUMMARY:      Soil_SaturatedImplicit.c
+ * USAGE:        Calculate the water movement in saturated soil zone, implicit in time
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  a semi-implicit alternative to Soil_Satu_Move(): the water tables
+ *               at the end of the step are solved from the 8-neighbour
+ *               transmissivity system (backward Euler), by the conjugate
+ *               gradient method with a Jacobi preconditioner (PCG)
+ * DESCRIP-END.
+ * FUNCTIONS:    Soil_Satu_System_Build();Soil_Satu_System_Free();
+ *               Soil_Satu_PCG();Soil_Satu_Move_Implicit();
+ *               Soil_Satu_Conduct();Soil_Satu_Assemble();
+ * COMMENTS:
+ * the flow from cell i to its neighbour k is, as in Soil_Satu_Outflow(),
+ *      q = c * [(z_k + z_offset_neighbor[k]) - (z_i + z_offset)], if positive,
+ * with the conductance c = h * Ksat * D / n of the upstream cell (the cell with
+ * the higher water table), where h = (1 - z / D)^n;
+ * the system is linearized by taking c, the flow direction and the exchange with
+ * the channel at the water table z_lin, the porosity at the start of the step:
+ *      (Porosity * A / dt) * (z_i' - z_i) = sum_k c_ik * d_ik' + Qc_i' - Percolation * A / dt
+ * c_ik = c_ki makes the matrix symmetric and (with the storage term)
+ * strictly diagonally dominant, i.e. positive definite;
+ * z_lin starts from the water table at the start of the step and is moved
+ * towards the solution by a few (relaxed) Picard iterations, so that a cell
+ * draining towards the bottom of the soil profile loses its conductance within
+ * the step; unlike the explicit update, the water table does not oscillate
+ * when step_time is long compared to the lateral drainage time of a cell
+ *
+ */
+
+/****************************************************************************
+ * VARIABLEs:
+ * SATU_SYSTEM *system                  - the linear system and the PCG work arrays, see "Soil_SaturatedImplicit.h"
+ * int *cell_index                      - 1D raster index of the active cells (see CELL_LIST in HM_ST.h)
+ * int cell_count                       - number of active cells
+ * int cell_counts_total                - number of raster cells, nrows * ncols
+ * double tol                           - PCG convergence tolerance, relative residual ||b - Ax|| / ||b||
+ * int iter_max                         - maximum PCG iterations per step
+ * double Soil_Thickness                - soil thickness, [m]
+ * double Soil_d1                       - thickness of the upper soil layer, [m]
+ * double stream_depth                  - depth of the channel bed, [m]
+ * double stream_width                  - width of the channel, [m]
+ * double step_space                    - grid cell size, [m]
+ * int step_time                        - time step, [h]
+ * double d                             - water table difference to a neighbour, positive: outflow, [m]
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Constants.h"
+#include "HM_ST.h"
+#include "Initial_VAR.h"
+#include "Lookup_SoilLib.h"
+#include "Soil_SaturatedFlow.h"
+#include "Soil_SaturatedImplicit.h"
+
+static double Soil_Satu_Conduct(
+    double d,
+    double G_cell,
+    double G_neighbor,
+    int active
+)
+{
+    /******
+     * the conductance between a cell and a neighbour: the transmissivity of
+     * the upstream one (the mean at equal water tables), so that both cells
+     * of a pair get the same value;
+     * a neighbour outside the active cells only receives water, as in Soil_Satu_Move()
+     */
+    if (d > 0.0)
+    {
+        return G_cell;
+    }
+    else if (active == 0)
+    {
+        return 0.0;
+    }
+    else if (d < 0.0)
+    {
+        return G_neighbor;
+    }
+    return 0.5 * (G_cell + G_neighbor);
+}
+
+void Soil_Satu_System_Build(
+    SATU_SYSTEM *system,
+    int *cell_index,
+    int cell_count,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    int ncols,
+    int cell_counts_total,
+    double tol,
+    int iter_max
+)
+{
+    int offset[8] = {- ncols - 1, - ncols, - ncols + 1, 1, ncols + 1, ncols, ncols - 1, -1};
+    int index_geo;
+    int e;
+    system->row_count = cell_count;
+    system->row = Allocate_int(cell_counts_total);
+    for (int i = 0; i < cell_counts_total; i++)
+    {
+        *(system->row + i) = -1;
+    }
+    for (int r = 0; r < cell_count; r++)
+    {
+        *(system->row + *(cell_index + r)) = r;
+    }
+    /* the number of entries of each row: the diagonal and the active neighbours */
+    system->row_start = Allocate_int(cell_count + 1);
+    *(system->row_start) = 0;
+    for (int r = 0; r < cell_count; r++)
+    {
+        index_geo = *(cell_index + r);
+        e = 1;
+        for (int k = 0; k < 8; k++)
+        {
+            if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1 &&
+                *(system->row + index_geo + offset[k]) >= 0)
+            {
+                e++;
+            }
+        }
+        *(system->row_start + r + 1) = *(system->row_start + r) + e;
+    }
+    system->col = Allocate_int(*(system->row_start + cell_count));
+    system->val = Allocate_double(*(system->row_start + cell_count));
+    for (int r = 0; r < cell_count; r++)
+    {
+        index_geo = *(cell_index + r);
+        e = *(system->row_start + r);
+        *(system->col + e) = r;
+        e++;
+        for (int k = 0; k < 8; k++)
+        {
+            if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1 &&
+                *(system->row + index_geo + offset[k]) >= 0)
+            {
+                *(system->col + e) = *(system->row + index_geo + offset[k]);
+                e++;
+            }
+        }
+    }
+    system->z_lin = Allocate_double(cell_count);
+    system->G = Allocate_double(cell_count);
+    system->b = Allocate_double(cell_count);
+    system->x = Allocate_double(cell_count);
+    system->r = Allocate_double(cell_count);
+    system->s = Allocate_double(cell_count);
+    system->p = Allocate_double(cell_count);
+    system->Ap = Allocate_double(cell_count);
+    system->M_inv = Allocate_double(cell_count);
+    system->tol = tol;
+    system->iter_max = iter_max;
+    system->iter_total = 0;
+    system->picard_total = 0;
+    system->solve_count = 0;
+    system->fail_count = 0;
+}
+
+void Soil_Satu_System_Free(
+    SATU_SYSTEM *system)
+{
+    free(system->row); free(system->row_start); free(system->col); free(system->val);
+    free(system->z_lin); free(system->G); free(system->b); free(system->x);
+    free(system->r); free(system->s); free(system->p); free(system->Ap); free(system->M_inv);
+}
+
+int Soil_Satu_PCG(
+    SATU_SYSTEM *system)
+{
+    /******************************************
+     * solve A x = b by the preconditioned conjugate gradient method,
+     * starting from the values in x; the preconditioner is the diagonal of A;
+     * returns the number of iterations, or -1 if not converged within iter_max
+    */
+    int n = system->row_count;
+    int *row_start = system->row_start;
+    int *col = system->col;
+    double *val = system->val;
+    double *x = system->x, *b = system->b, *r = system->r, *s = system->s;
+    double *p = system->p, *Ap = system->Ap, *M_inv = system->M_inv;
+    double b_norm = 0.0, r_norm = 0.0;
+    double rs = 0.0, rs_new, pAp;
+    double alpha, beta;
+    int iter;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+:b_norm, r_norm, rs)
+#endif
+    for (int i = 0; i < n; i++)
+    {
+        double Ax = 0.0;
+        for (int e = row_start[i]; e < row_start[i + 1]; e++)
+        {
+            Ax += val[e] * x[col[e]];
+        }
+        r[i] = b[i] - Ax;
+        s[i] = M_inv[i] * r[i];
+        p[i] = s[i];
+        b_norm += b[i] * b[i];
+        r_norm += r[i] * r[i];
+        rs += r[i] * s[i];
+    }
+    b_norm = sqrt(b_norm);
+    for (iter = 0; iter < system->iter_max; iter++)
+    {
+        if (sqrt(r_norm) <= system->tol * b_norm)
+        {
+            return iter;
+        }
+        pAp = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+:pAp)
+#endif
+        for (int i = 0; i < n; i++)
+        {
+            double sum = 0.0;
+            for (int e = row_start[i]; e < row_start[i + 1]; e++)
+            {
+                sum += val[e] * p[col[e]];
+            }
+            Ap[i] = sum;
+            pAp += p[i] * sum;
+        }
+        alpha = rs / pAp;
+        r_norm = 0.0;
+        rs_new = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+:r_norm, rs_new)
+#endif
+        for (int i = 0; i < n; i++)
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+            s[i] = M_inv[i] * r[i];
+            r_norm += r[i] * r[i];
+            rs_new += r[i] * s[i];
+        }
+        beta = rs_new / rs;
+        rs = rs_new;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i = 0; i < n; i++)
+        {
+            p[i] = s[i] + beta * p[i];
+        }
+    }
+    if (sqrt(r_norm) <= system->tol * b_norm)
+    {
+        return iter;
+    }
+    return -1;
+}
+
+static void Soil_Satu_Assemble(
+    SATU_SYSTEM *system,
+    int *cell_index,
+    int cell_count,
+    int *data_STR,
+    CELL_VAR_STREAM **data_STREAM,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    double Soil_d1,
+    double stream_depth,
+    double stream_width,
+    int ncols,
+    double step_space,
+    int step_time
+)
+{
+    /******************************************
+     * the transmissivity G of each cell at the linearization water table z_lin,
+     * then the rows: storage (at the water table of the start of the step),
+     * lateral conductances and channel exchange
+    */
+    double cell_area;   // the area of the grid cell, m2
+    cell_area = step_space * step_space;
+    int offset[8] = {- ncols - 1, - ncols, - ncols + 1, 1, ncols + 1, ncols, ncols - 1, -1};
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int c = 0; c < cell_count; c++)
+    {
+        int index_geo = *(cell_index + c);
+        *(system->G + c) = pow(1 - *(system->z_lin + c) / Soil_Thickness, (soil_para + index_geo)->DecayCoeff) *
+                           (soil_para + index_geo)->Ksat_lateral * Soil_Thickness / (soil_para + index_geo)->DecayCoeff;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int c = 0; c < cell_count; c++)
+    {
+        int index_geo, index_nb, r_nb;
+        int e;
+        double z, z_nb;
+        double d, d_ref;  // water table difference to the neighbour, and its part from the DEM, [m]
+        double Cond;      // conductance to the neighbour, [m2/h]
+        double Storage;   // Porosity * A / dt, [m2/h]
+        double diag, rhs;
+        index_geo = *(cell_index + c);
+        z = *(data_SOIL->z + index_geo);
+        if (z <= Soil_d1)
+        {
+            Storage = (soil_para + index_geo)->Porosity_upper * cell_area / step_time;
+        }
+        else
+        {
+            Storage = (soil_para + index_geo)->Porosity_lower * cell_area / step_time;
+        }
+        diag = Storage;
+        rhs = Storage * z - *(data_SOIL->SW_Percolation_Lower + index_geo) * cell_area / step_time;
+        e = *(system->row_start + c) + 1;
+        for (int k = 0; k < 8; k++)
+        {
+            if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
+            {
+                index_nb = index_geo + offset[k];
+                r_nb = *(system->row + index_nb);
+                d_ref = *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) - *(data_NEIGHBOR->z_offset + index_geo);
+                if (r_nb >= 0)
+                {
+                    d = (*(system->z_lin + r_nb) - *(system->z_lin + c)) + d_ref;
+                    Cond = Soil_Satu_Conduct(d, *(system->G + c), *(system->G + r_nb), 1);
+                    *(system->val + e) = - Cond;
+                    e++;
+                }
+                else
+                {
+                    /* the water table of a neighbour outside the active cells stays as it is */
+                    z_nb = *(data_SOIL->z + index_nb);
+                    d = (z_nb - *(system->z_lin + c)) + d_ref;
+                    Cond = Soil_Satu_Conduct(d, *(system->G + c), 0.0, 0);
+                    rhs += Cond * z_nb;
+                }
+                diag += Cond;
+                rhs += Cond * d_ref;
+            }
+        }
+        if (*(data_STR + index_geo) != 1)
+        {
+            /* no channel: Qc stays as it is, as in Soil_Satu_Move() */
+            rhs += (*data_STREAM + index_geo)->Qc;
+        }
+        else if (stream_depth > *(system->z_lin + c))
+        {
+            /* Qc = 4 * L / W * G * (stream_depth - z'), see Soil_Satu_Stream() */
+            Cond = 4 * step_space / stream_width * *(system->G + c);
+            diag += Cond;
+            rhs += Cond * stream_depth;
+        }
+        *(system->val + *(system->row_start + c)) = diag;
+        *(system->M_inv + c) = 1.0 / diag;
+        *(system->b + c) = rhs;
+    }
+}
+
+void Soil_Satu_Move_Implicit(
+    SATU_SYSTEM *system,
+    int *cell_index,
+    int cell_count,
+    int *data_STR,
+    CELL_VAR_STREAM **data_STREAM,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    double Soil_d1,
+    double stream_depth,
+    double stream_width,
+    int ncols,
+    double step_space,
+    int step_time)
+{
+    /******************************************
+     * 1. Picard iterations: assemble the system at z_lin (Soil_Satu_Assemble()),
+     *    solve the water tables at the end of the step, x, by PCG,
+     *    and move z_lin towards x (bounded by the soil profile), until z_lin settles
+     * 2. the outflow q[8] of each cell, from the conductances of the last system and x
+     * 3. the inflow of each cell and the update of z (Soil_Satu_Update()),
+     *    as in the second pass of Soil_Satu_Move()
+    */
+    double cell_area;   // the area of the grid cell, m2
+    cell_area = step_space * step_space;
+    int offset[8] = {- ncols - 1, - ncols, - ncols + 1, 1, ncols + 1, ncols, ncols - 1, -1};
+    // direction where the rid cell receiving from other cells yielding outflow
+    int in_dir[8] = {4, 5, 6, 7, 0, 1, 2, 3};
+    int iter, picard;
+    double dx_max;  // the largest change of z_lin in a Picard iteration, [m]
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int c = 0; c < cell_count; c++)
+    {
+        *(system->z_lin + c) = *(data_SOIL->z + *(cell_index + c));
+        *(system->x + c) = *(system->z_lin + c);
+    }
+    for (picard = 1; picard <= SATU_PICARD_MAX; picard++)
+    {
+        Soil_Satu_Assemble(
+            system, cell_index, cell_count, data_STR, data_STREAM, data_SOIL, data_NEIGHBOR, soil_para,
+            Soil_Thickness, Soil_d1, stream_depth, stream_width, ncols, step_space, step_time);
+        iter = Soil_Satu_PCG(system);
+        if (iter < 0)
+        {
+            system->fail_count++;
+            system->iter_total += system->iter_max;
+        }
+        else
+        {
+            system->iter_total += iter;
+        }
+        dx_max = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:dx_max)
+#endif
+        for (int c = 0; c < cell_count; c++)
+        {
+            double x = *(system->x + c);
+            if (x < 0.0)
+            {
+                x = 0.0;
+            }
+            else if (x > Soil_Thickness)
+            {
+                x = Soil_Thickness;
+            }
+            if (fabs(x - *(system->z_lin + c)) > dx_max)
+            {
+                dx_max = fabs(x - *(system->z_lin + c));
+            }
+        }
+        if (dx_max <= SATU_PICARD_TOL || picard == SATU_PICARD_MAX)
+        {
+            break;
+        }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int c = 0; c < cell_count; c++)
+        {
+            double x = *(system->x + c);
+            if (x < 0.0)
+            {
+                x = 0.0;
+            }
+            else if (x > Soil_Thickness)
+            {
+                x = Soil_Thickness;
+            }
+            *(system->z_lin + c) += SATU_PICARD_RELAX * (x - *(system->z_lin + c));
+        }
+    }
+    system->solve_count++;
+    system->picard_total += picard;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int c = 0; c < cell_count; c++)
+    {
+        int index_geo, index_nb, r_nb;
+        double x, x_nb;
+        double d, d_ref;
+        double Cond, q;
+        double Qout = 0.0;
+        index_geo = *(cell_index + c);
+        x = *(system->x + c);
+        for (int k = 0; k < 8; k++)
+        {
+            q = 0.0;
+            if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
+            {
+                index_nb = index_geo + offset[k];
+                r_nb = *(system->row + index_nb);
+                d_ref = *(data_NEIGHBOR->z_offset_neighbor[k] + index_geo) - *(data_NEIGHBOR->z_offset + index_geo);
+                if (r_nb >= 0)
+                {
+                    d = (*(system->z_lin + r_nb) - *(system->z_lin + c)) + d_ref;
+                    Cond = Soil_Satu_Conduct(d, *(system->G + c), *(system->G + r_nb), 1);
+                    x_nb = *(system->x + r_nb);
+                }
+                else
+                {
+                    x_nb = *(data_SOIL->z + index_nb);
+                    d = (x_nb - *(system->z_lin + c)) + d_ref;
+                    Cond = Soil_Satu_Conduct(d, *(system->G + c), 0.0, 0);
+                }
+                q = Cond * ((x_nb - x) + d_ref);
+                if (q < 0.0)
+                {
+                    q = 0.0;  // inflow, counted as the outflow of the neighbour
+                }
+            }
+            *(data_SOIL->q[k] + index_geo) = q;
+            Qout += q;
+        }
+        *(data_SOIL->Qout + index_geo) = Qout;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int c = 0; c < cell_count; c++)
+    {
+        int index_geo;
+        index_geo = *(cell_index + c);
+        *(data_SOIL->Qin + index_geo) = 0.0;
+        for (int k = 0; k < 8; k++)
+        {
+            if (*(data_NEIGHBOR->neighbor[k] + index_geo) == 1)
+            {
+                *(data_SOIL->Qin + index_geo) += *(data_SOIL->q[in_dir[k]] + index_geo + offset[k]);
+            }
+        }
+        if (*(data_STR + index_geo) == 1)
+        {
+            if (stream_depth > *(system->z_lin + c))
+            {
+                (*data_STREAM + index_geo)->Qc = 4 * step_space / stream_width * *(system->G + c) *
+                                                 (stream_depth - *(system->x + c));
+            }
+            else
+            {
+                (*data_STREAM + index_geo)->Qc = 0.0;
+            }
+        }
+        Soil_Satu_Update(
+            index_geo,
+            data_SOIL,
+            soil_para,
+            (*data_STREAM + index_geo)->Qc,
+            *(data_SOIL->SW_Percolation_Lower + index_geo),
+            Soil_Thickness,
+            Soil_d1,
+            cell_area,
+            step_time,
+            data_SOIL->SW_rise_lower + index_geo,
+            data_SOIL->SW_rise_upper + index_geo,
+            data_SOIL->SW_rf + index_geo);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef SOIL_SATURATEDIMPLICIT
+#define SOIL_SATURATEDIMPLICIT
+
+#include "HM_ST.h"
+#include "Lookup_SoilLib.h"
+
+/* SOIL_SATU_SOLVER: the time stepping of the water table in the saturated lateral flow */
+#define SATU_SOLVER_EXPLICIT 0  // Soil_Satu_Move(): outflow from the water tables at the start of the step
+#define SATU_SOLVER_IMPLICIT 1  // Soil_Satu_Move_Implicit(): linearized backward Euler, solved by PCG
+#define SATU_PICARD_MAX 20      // maximum Picard iterations (re-linearizations) per step
+#define SATU_PICARD_TOL 1e-3    // Picard iterations stop when the water tables change less than this, [m]
+#define SATU_PICARD_RELAX 0.3   // relaxation of the linearization water table between Picard iterations
+
+typedef struct
+{
+    /******
+     * the linear system of the implicit saturated lateral flow, one row per
+     * active cell (the order of cell_index), in CSR format: the diagonal entry
+     * first, then the active neighbours in the order of the 8 directions;
+     * the pattern is built once by Soil_Satu_System_Build(),
+     * the coefficients are assembled at every Picard iteration
+     */
+    int row_count;     /* number of rows: the active cells */
+    int *row;          /* the row of each raster cell (index_geo); -1: not an active cell */
+    int *row_start;    /* the entries of row r: row_start[r], ..., row_start[r + 1] - 1 */
+    int *col;          /* the column (row of the neighbour) of each entry */
+    double *val;       /* the coefficient of each entry, [m2/h] */
+    double *z_lin;     /* the water table the system is linearized at, [m] */
+    double *G;         /* transmissivity of each row at z_lin, h * Ksat * D / n, [m2/h] */
+    double *b;         /* right-hand side, [m3/h] */
+    double *x;         /* the solution: water table at the end of the step, [m] */
+    double *r;         /* PCG: residual */
+    double *s;         /* PCG: preconditioned residual */
+    double *p;         /* PCG: search direction */
+    double *Ap;        /* PCG: matrix times search direction */
+    double *M_inv;     /* PCG: Jacobi preconditioner, the inverse of the diagonal */
+    double tol;        /* PCG: convergence tolerance of the residual, relative to the right-hand side */
+    int iter_max;      /* PCG: maximum number of iterations per step */
+    long iter_total;   /* PCG iterations of all the steps so far */
+    long picard_total; /* Picard iterations of all the steps so far */
+    int solve_count;   /* number of steps solved so far */
+    int fail_count;    /* number of PCG solves that did not converge within iter_max */
+} SATU_SYSTEM;
+
+void Soil_Satu_System_Build(
+    SATU_SYSTEM *system,
+    int *cell_index,
+    int cell_count,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    int ncols,
+    int cell_counts_total,
+    double tol,
+    int iter_max);
+
+void Soil_Satu_System_Free(
+    SATU_SYSTEM *system);
+
+int Soil_Satu_PCG(
+    SATU_SYSTEM *system);
+
+void Soil_Satu_Move_Implicit(
+    SATU_SYSTEM *system,
+    int *cell_index,
+    int cell_count,
+    int *data_STR,
+    CELL_VAR_STREAM **data_STREAM,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_NEIGHBOR *data_NEIGHBOR,
+    ST_SOIL_PARA_CELL *soil_para,
+    double Soil_Thickness,
+    double Soil_d1,
+    double stream_depth,
+    double stream_width,
+    int ncols,
+    double step_space,
+    int step_time);
+
+#endif
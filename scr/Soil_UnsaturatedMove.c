@@ -37,7 +37,7 @@
     double *SW_Run_Satur              - generated surface runoff from soil saturation, [m]
     double Soil_thickness_upper       - the thickness of upper soil layer, [m]
     double Soil_thickness_lower       - the thickness of lower soil layer, [m]
-    ST_SOIL_LIB_CELL *cell_soil_lib   - soil parameters library for a cell, see "Lookup_SoilLib.h"
+    ST_SOIL_PARA_CELL *cell_soil_para - derived soil parameters for a cell, see "Lookup_SoilLib.h"
     int STEP_TIME                     - time step of model simulation
 
 ******************************/
@@ -66,7 +66,7 @@ void UnsaturatedWaterMove(
     double *SW_Run_Satur,
     double Soil_thickness_upper,
     double Soil_thickness_lower,
-    ST_SOIL_LIB_CELL *cell_soil_lib,
+    ST_SOIL_PARA_CELL *cell_soil_para,
     int STEP_TIME
 )
 {
@@ -79,10 +79,9 @@ void UnsaturatedWaterMove(
     {
         *SW_Infiltration = Soil_Infiltration(
             Water_input, *Soil_Moisture_upper,
-            cell_soil_lib->Topsoil->Porosity / 100,
-            cell_soil_lib->Topsoil->SatHydrauCond,
-            cell_soil_lib->Topsoil->AirEntryPresHead,
-            cell_soil_lib->Topsoil->PoreSizeDisP,
+            cell_soil_para->Porosity_upper,
+            cell_soil_para->Ksat_upper,
+            cell_soil_para->Tension_effective,
             STEP_TIME);
         if (Water_input * STEP_TIME > *SW_Infiltration)
         {
@@ -103,20 +102,20 @@ void UnsaturatedWaterMove(
         *Soil_Moisture_upper,
         *SW_Infiltration,
         Soil_thickness_upper,
-        cell_soil_lib->Topsoil->Porosity / 100,
-        cell_soil_lib->Topsoil->Residual / 100,
-        cell_soil_lib->Topsoil->SatHydrauCond,
-        cell_soil_lib->Topsoil->PoreSizeDisP,
+        cell_soil_para->Porosity_upper,
+        cell_soil_para->Residual_upper,
+        cell_soil_para->Ksat_upper,
+        cell_soil_para->BC_exp_upper,
         STEP_TIME);
     
     *SW_Percolation_Lower = Percolation(
         *Soil_Moisture_lower,
         *SW_Percolation_Upper,
         Soil_thickness_lower,
-        cell_soil_lib->Subsoil->Porosity / 100,
-        cell_soil_lib->Subsoil->Residual / 100,
-        cell_soil_lib->Subsoil->SatHydrauCond,
-        cell_soil_lib->Subsoil->PoreSizeDisP,
+        cell_soil_para->Porosity_lower,
+        cell_soil_para->Residual_lower,
+        cell_soil_para->Ksat_lower,
+        cell_soil_para->BC_exp_lower,
         STEP_TIME);
 
     double SM_buff;
@@ -142,10 +141,10 @@ void UnsaturatedWaterMove(
     // SM_buff = (*SW_Infiltration - *SW_Percolation_Upper - ET_o - ET_u - Es + SW_rise_upper) /
     //               Soil_thickness_upper +
     //           *Soil_Moisture_upper;
-    if (SM_buff > cell_soil_lib->Topsoil->Porosity / 100)
+    if (SM_buff > cell_soil_para->Porosity_upper)
     {
-        *SW_Run_Satur += (SM_buff - cell_soil_lib->Topsoil->Porosity / 100) * Soil_thickness_upper;
-        *Soil_Moisture_upper = cell_soil_lib->Topsoil->Porosity / 100;
+        *SW_Run_Satur += (SM_buff - cell_soil_para->Porosity_upper) * Soil_thickness_upper;
+        *Soil_Moisture_upper = cell_soil_para->Porosity_upper;
     }
     else
     {
@@ -168,10 +167,10 @@ void UnsaturatedWaterMove(
     // SM_buff = (*SW_Percolation_Upper - *SW_Percolation_Lower - ET_o_lowersoil + SW_rise_lower) /
     //               Soil_thickness_lower +
     //           *Soil_Moisture_lower;
-    if (SM_buff > cell_soil_lib->Subsoil->Porosity / 100)
+    if (SM_buff > cell_soil_para->Porosity_lower)
     {
-        *SW_Run_Satur += (SM_buff - cell_soil_lib->Subsoil->Porosity / 100) * Soil_thickness_lower;
-        *Soil_Moisture_lower = cell_soil_lib->Subsoil->Porosity / 100;
+        *SW_Run_Satur += (SM_buff - cell_soil_para->Porosity_lower) * Soil_thickness_lower;
+        *Soil_Moisture_lower = cell_soil_para->Porosity_lower;
     }
     else
     {
@@ -20,7 +20,7 @@ void UnsaturatedWaterMove(
     double *SW_Run_Satur,
     double Soil_thickness_upper,
     double Soil_thickness_lower,
-    ST_SOIL_LIB_CELL *cell_soil_lib,
+    ST_SOIL_PARA_CELL *cell_soil_para,
     int STEP_TIME
 );
 
@@ -0,0 +1,95 @@
+/*
+ * SUMMARY:      Spinup.c
+ * USAGE:        convergence of the model state in the spin-up cycles
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  in the spin-up mode (SPINUP_STEPS > 0) the first SPINUP_STEPS
+ *               steps of the simulation period are simulated repeatedly, without
+ *               any output, until the state no longer changes from one cycle to
+ *               the next; the main run then starts from the spun-up state
+ * DESCRIP-END.
+ * FUNCTIONS:    Spinup_Means(); Spinup_Cycle()
+ *
+ * COMMENTS:
+ * the state is considered converged when the domain means (over the active
+ * cells) of the water table z [m] and of the soil moisture of both layers
+ * [FRAC] change by less than SPINUP_TOL between two consecutive cycles
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * CELL_VAR_SOIL *data_SOIL         - soil water variables
+ * int *cell_index                  - 1D raster index of the active cells
+ * int cell_count                   - number of active cells
+ * double *mean                     - domain means of z, SM_Upper, SM_Lower (SPINUP_VARS)
+ * double *mean_last                - the means at the end of the last cycle (or the initial state)
+ * int cycle                        - the number of the cycle just completed, from 1
+ * double tol                       - convergence tolerance of the means
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "HM_ST.h"
+#include "Spinup.h"
+
+void Spinup_Means(
+    CELL_VAR_SOIL *data_SOIL,
+    int *cell_index,
+    int cell_count,
+    double *mean
+)
+{
+    int index_geo;
+    for (size_t k = 0; k < SPINUP_VARS; k++)
+    {
+        *(mean + k) = 0.0;
+    }
+    for (int c = 0; c < cell_count; c++)
+    {
+        index_geo = *(cell_index + c);
+        *(mean + 0) += *(data_SOIL->z + index_geo);
+        *(mean + 1) += *(data_SOIL->SM_Upper + index_geo);
+        *(mean + 2) += *(data_SOIL->SM_Lower + index_geo);
+    }
+    for (size_t k = 0; k < SPINUP_VARS; k++)
+    {
+        *(mean + k) = *(mean + k) / cell_count;
+    }
+}
+
+int Spinup_Cycle(
+    CELL_VAR_SOIL *data_SOIL,
+    int *cell_index,
+    int cell_count,
+    double *mean_last,
+    int cycle,
+    double tol
+)
+{
+    /**********
+     * compare the state at the end of a cycle with the one at the end of
+     * the last cycle; mean_last is updated to the current means;
+     * returns 1 when all the changes are below tol
+     */
+    double mean[SPINUP_VARS];
+    double change[SPINUP_VARS];
+    int converged = 1;
+    Spinup_Means(data_SOIL, cell_index, cell_count, mean);
+    for (size_t k = 0; k < SPINUP_VARS; k++)
+    {
+        change[k] = fabs(mean[k] - *(mean_last + k));
+        if (change[k] >= tol)
+        {
+            converged = 0;
+        }
+        *(mean_last + k) = mean[k];
+    }
+    printf("* spin-up cycle %3d: mean z %.4f m, SM_Upper %.4f, SM_Lower %.4f; change %.2e, %.2e, %.2e\n",
+           cycle, mean[0], mean[1], mean[2], change[0], change[1], change[2]);
+    return converged;
+}
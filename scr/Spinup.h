@@ -0,0 +1,23 @@
+#ifndef SPINUP
+#define SPINUP
+
+#include "HM_ST.h"
+
+/* the domain means compared between spin-up cycles */
+#define SPINUP_VARS 3  // z, SM_Upper, SM_Lower
+
+void Spinup_Means(
+    CELL_VAR_SOIL *data_SOIL,
+    int *cell_index,
+    int cell_count,
+    double *mean);
+
+int Spinup_Cycle(
+    CELL_VAR_SOIL *data_SOIL,
+    int *cell_index,
+    int cell_count,
+    double *mean_last,
+    int cycle,
+    double tol);
+
+#endif
@@ -0,0 +1,299 @@
+/*
+ * SUMMARY:      State_IO.c
+ * USAGE:        warm start: import and export the model state as NetCDF
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the state variables carried from one step to the next are
+ *               written to a NetCDF state file at the end of a run (FP_STATE_OUT),
+ *               and read as the initial conditions of another run (FP_STATE_IN),
+ *               instead of the uniform initial values of Initialize_SOIL() and
+ *               Initialize_Soil_Satur() that need a long spin-up
+ * DESCRIP-END.
+ * FUNCTIONS:    State_Import(); State_Export(); State_Copy(); State_Arrays()
+ *
+ * COMMENTS:
+ * the state file has the layout of the GEO data (dimensions lat and lon,
+ * the global attributes of FP_GEO), one NC_DOUBLE map per state variable,
+ * NODATA_value outside the active cells (channel variables: outside the
+ * channel cells); the global attribute "state_time" is the time the state
+ * is valid for, i.e. the start of the step following the run.
+ * The surface runoff in transit to the outlets (UH routing) is not part
+ * of the state: it drains within the UH length.
+ * State_Copy() copies the state of one model to another, e.g. the state
+ * imported once to the members of a parameter ensemble.
+ *
+ */
+
+/*****************************************************************
+ * VARIABLEs:
+ * char FP_STATE[]                  - file path of the NetCDF state file
+ * int ncID_GEO                     - ID of the opened GEO nc file
+ * long start_time                  - start of the simulation, time_t
+ * long state_time                  - the time the exported state is valid for, time_t
+ * CELL_VAR_ET *data_ET             - evapotranspiration variables (interception storages)
+ * CELL_VAR_SOIL *data_SOIL         - soil water variables (soil moisture, water table)
+ * CELL_VAR_STREAM *data_STREAM     - channel variables (water volume, discharge)
+ * CELL_LIST *cell_list             - the active cells and the channel cells
+ *
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <netcdf.h>
+#include "HM_ST.h"
+#include "NC_copy_global_att.h"
+#include "Check_Data.h"
+#include "State_IO.h"
+
+char *state_name[STATE_VARS_CELL + STATE_VARS_STREAM] = {
+    "SM_Upper", "SM_Lower", "z", "SW_rise_upper", "SW_rise_lower", "Interception_o", "Interception_u",
+    "V", "Q_Channel"};
+static char *state_unit[STATE_VARS_CELL + STATE_VARS_STREAM] = {
+    "FRAC", "FRAC", "m", "m", "m", "m", "m",
+    "m3", "m3/h"};
+static char *state_longname[STATE_VARS_CELL + STATE_VARS_STREAM] = {
+    "soil moisture of upper soil layer",
+    "soil moisture of lower soil layer",
+    "subsurface water table, positive downward",
+    "water supplied by rising water table to upper soil layer in the last step",
+    "water supplied by rising water table to lower soil layer in the last step",
+    "intercepted water by overstory",
+    "intercepted water by understory",
+    "water volume of the channel",
+    "discharge out of the channel reach"};
+
+static void State_Arrays(
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    double **cell_var
+)
+{
+    /* the cell state arrays, in the order of state_name */
+    cell_var[0] = data_SOIL->SM_Upper;
+    cell_var[1] = data_SOIL->SM_Lower;
+    cell_var[2] = data_SOIL->z;
+    cell_var[3] = data_SOIL->SW_rise_upper;
+    cell_var[4] = data_SOIL->SW_rise_lower;
+    cell_var[5] = data_ET->Interception_o;
+    cell_var[6] = data_ET->Interception_u;
+}
+
+void State_Import(
+    char FP_STATE[],
+    int ncID_GEO,
+    long start_time,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    CELL_LIST *cell_list,
+    int cell_counts_total,
+    int NODATA_value
+)
+{
+    int status_nc;
+    int ncID_STATE;
+    int varID;
+    int index_geo;
+    double *cell_var[STATE_VARS_CELL];
+    double *data;
+    double state_time;
+    status_nc = nc_open(FP_STATE, NC_NOWRITE, &ncID_STATE);
+    handle_error(status_nc, FP_STATE);
+    Check_State(ncID_GEO, ncID_STATE, FP_STATE);   // the grid of the GEO data, all the state variables
+
+    data = (double *)malloc(sizeof(double) * cell_counts_total);
+    if (data == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    State_Arrays(data_ET, data_SOIL, cell_var);
+    for (size_t v = 0; v < STATE_VARS_CELL + STATE_VARS_STREAM; v++)
+    {
+        nc_inq_varid(ncID_STATE, state_name[v], &varID);
+        status_nc = nc_get_var_double(ncID_STATE, varID, data);
+        handle_error(status_nc, FP_STATE);
+        if (v < STATE_VARS_CELL)
+        {
+            for (int c = 0; c < cell_list->cell_count; c++)
+            {
+                index_geo = *(cell_list->cell_index + c);
+                if (*(data + index_geo) == NODATA_value)
+                {
+                    printf("Error: %s in %s has no value at the active cell %d\n", state_name[v], FP_STATE, index_geo);
+                    exit(-2);
+                }
+                *(cell_var[v] + index_geo) = *(data + index_geo);
+            }
+        }
+        else
+        {
+            for (int c = 0; c < cell_list->stream_count; c++)
+            {
+                index_geo = *(cell_list->stream_index + c);
+                if (*(data + index_geo) == NODATA_value)
+                {
+                    printf("Error: %s in %s has no value at the channel cell %d\n", state_name[v], FP_STATE, index_geo);
+                    exit(-2);
+                }
+                if (v == STATE_VARS_CELL)
+                {
+                    (data_STREAM + index_geo)->V = *(data + index_geo);
+                }
+                else
+                {
+                    (data_STREAM + index_geo)->Qout = *(data + index_geo);
+                }
+            }
+        }
+    }
+    free(data);
+
+    if (nc_get_att_double(ncID_STATE, NC_GLOBAL, "state_time", &state_time) == NC_NOERR &&
+        (long)state_time != start_time)
+    {
+        printf("* warning: the state in %s is valid for %.0f h %s the simulation start\n",
+               FP_STATE, (double)labs((long)state_time - start_time) / 3600,
+               ((long)state_time < start_time) ? "before" : "after");
+    }
+    nc_close(ncID_STATE);
+}
+
+void State_Export(
+    char FP_STATE[],
+    int ncID_GEO,
+    long state_time,
+    int STEP_TIME,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    CELL_LIST *cell_list,
+    int cell_counts_total,
+    int NODATA_value
+)
+{
+    int status_nc;
+    int ncID_STATE;
+    int ncols, nrows;
+    int dimID_lon, dimID_lat;
+    int dims[2];
+    int varID_lon, varID_lat;
+    int varID[STATE_VARS_CELL + STATE_VARS_STREAM];
+    int index_geo;
+    double *cell_var[STATE_VARS_CELL];
+    double *data_lon, *data_lat;
+    double *data;
+    double time_value;
+    double nodata;
+    char date[30];
+    time_t tm_state;
+
+    nc_get_att_int(ncID_GEO, NC_GLOBAL, "ncols", &ncols);
+    nc_get_att_int(ncID_GEO, NC_GLOBAL, "nrows", &nrows);
+    data_lon = (double *)malloc(sizeof(double) * ncols);
+    data_lat = (double *)malloc(sizeof(double) * nrows);
+    data = (double *)malloc(sizeof(double) * cell_counts_total);
+    if (data_lon == NULL || data_lat == NULL || data == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    nc_inq_varid(ncID_GEO, "lon", &varID_lon);
+    nc_get_var_double(ncID_GEO, varID_lon, data_lon);
+    nc_inq_varid(ncID_GEO, "lat", &varID_lat);
+    nc_get_var_double(ncID_GEO, varID_lat, data_lat);
+
+    status_nc = nc_create(FP_STATE, NC_CLOBBER, &ncID_STATE);
+    handle_error(status_nc, FP_STATE);
+    nc_def_dim(ncID_STATE, "lon", ncols, &dimID_lon);
+    nc_def_dim(ncID_STATE, "lat", nrows, &dimID_lat);
+    dims[0] = dimID_lat;
+    dims[1] = dimID_lon;
+    nc_def_var(ncID_STATE, "lon", NC_DOUBLE, 1, &dimID_lon, &varID_lon);
+    nc_def_var(ncID_STATE, "lat", NC_DOUBLE, 1, &dimID_lat, &varID_lat);
+    nodata = NODATA_value;
+    for (size_t v = 0; v < STATE_VARS_CELL + STATE_VARS_STREAM; v++)
+    {
+        nc_def_var(ncID_STATE, state_name[v], NC_DOUBLE, 2, dims, &varID[v]);
+        nc_put_att_text(ncID_STATE, varID[v], "Units", strlen(state_unit[v]), state_unit[v]);
+        nc_put_att_text(ncID_STATE, varID[v], "long_name", strlen(state_longname[v]), state_longname[v]);
+        nc_put_att_double(ncID_STATE, varID[v], "NODATA_value", NC_DOUBLE, 1, &nodata);
+    }
+    copy_global_attributes(ncID_GEO, ncID_STATE);
+    // the time the state is valid for: seconds since 1970-01-01, and as a date
+    time_value = (double)state_time;
+    tm_state = (time_t)state_time - 3600;  // times are kept one hour ahead (tm_hour = START_HOUR + 1), see xHM_main.c
+    strftime(date, 30, "%Y-%m-%d %H:%M", localtime(&tm_state));
+    nc_put_att_double(ncID_STATE, NC_GLOBAL, "state_time", NC_DOUBLE, 1, &time_value);
+    nc_put_att_text(ncID_STATE, NC_GLOBAL, "state_date", strlen(date), date);
+    nc_put_att_int(ncID_STATE, NC_GLOBAL, "STEP_TIME", NC_INT, 1, &STEP_TIME);
+    status_nc = nc_enddef(ncID_STATE);
+    handle_error(status_nc, FP_STATE);
+
+    nc_put_var_double(ncID_STATE, varID_lon, data_lon);
+    nc_put_var_double(ncID_STATE, varID_lat, data_lat);
+    State_Arrays(data_ET, data_SOIL, cell_var);
+    for (size_t v = 0; v < STATE_VARS_CELL + STATE_VARS_STREAM; v++)
+    {
+        for (int i = 0; i < cell_counts_total; i++)
+        {
+            *(data + i) = nodata;
+        }
+        if (v < STATE_VARS_CELL)
+        {
+            for (int c = 0; c < cell_list->cell_count; c++)
+            {
+                index_geo = *(cell_list->cell_index + c);
+                *(data + index_geo) = *(cell_var[v] + index_geo);
+            }
+        }
+        else
+        {
+            for (int c = 0; c < cell_list->stream_count; c++)
+            {
+                index_geo = *(cell_list->stream_index + c);
+                *(data + index_geo) = (v == STATE_VARS_CELL) ? (data_STREAM + index_geo)->V : (data_STREAM + index_geo)->Qout;
+            }
+        }
+        status_nc = nc_put_var_double(ncID_STATE, varID[v], data);
+        handle_error(status_nc, FP_STATE);
+    }
+    nc_close(ncID_STATE);
+    free(data_lon); free(data_lat); free(data);
+}
+
+void State_Copy(
+    CELL_VAR_ET *src_ET,
+    CELL_VAR_SOIL *src_SOIL,
+    CELL_VAR_STREAM *src_STREAM,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    CELL_LIST *cell_list
+)
+{
+    /* the state variables of State_Import(), at the active and the channel cells */
+    int index_geo;
+    double *src_var[STATE_VARS_CELL];
+    double *cell_var[STATE_VARS_CELL];
+    State_Arrays(src_ET, src_SOIL, src_var);
+    State_Arrays(data_ET, data_SOIL, cell_var);
+    for (size_t v = 0; v < STATE_VARS_CELL; v++)
+    {
+        for (int c = 0; c < cell_list->cell_count; c++)
+        {
+            index_geo = *(cell_list->cell_index + c);
+            *(cell_var[v] + index_geo) = *(src_var[v] + index_geo);
+        }
+    }
+    for (int c = 0; c < cell_list->stream_count; c++)
+    {
+        index_geo = *(cell_list->stream_index + c);
+        (data_STREAM + index_geo)->V = (src_STREAM + index_geo)->V;
+        (data_STREAM + index_geo)->Qout = (src_STREAM + index_geo)->Qout;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef STATE_IO
+#define STATE_IO
+
+#include "HM_ST.h"
+
+/* the state variables in the NetCDF state file, see State_IO.c */
+#define STATE_VARS_CELL 7    // active cells: soil moisture, water table, rising water table supply, interception
+#define STATE_VARS_STREAM 2  // channel cells: water volume, discharge
+
+extern char *state_name[STATE_VARS_CELL + STATE_VARS_STREAM];  // the NetCDF variable names, also checked by Check_State()
+
+void State_Import(
+    char FP_STATE[],
+    int ncID_GEO,
+    long start_time,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    CELL_LIST *cell_list,
+    int cell_counts_total,
+    int NODATA_value);
+
+void State_Export(
+    char FP_STATE[],
+    int ncID_GEO,
+    long state_time,
+    int STEP_TIME,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    CELL_LIST *cell_list,
+    int cell_counts_total,
+    int NODATA_value);
+
+void State_Copy(
+    CELL_VAR_ET *src_ET,
+    CELL_VAR_SOIL *src_SOIL,
+    CELL_VAR_STREAM *src_STREAM,
+    CELL_VAR_ET *data_ET,
+    CELL_VAR_SOIL *data_SOIL,
+    CELL_VAR_STREAM *data_STREAM,
+    CELL_LIST *cell_list);
+
+#endif
@@ -9,7 +9,8 @@
  *               the UH is derived based on topography (DEM). 
  * DESCRIP-END.
  * FUNCTIONS:    Grid_Slope(), Grid_SlopeArea(), Grid_Velocity()
- *                  Grid_FlowTime(), Grid_UH(), Grid_Outlets(), 
+ *                  Grid_FlowTime(), Grid_UH(), UH_Cell_Kernel(), Grid_Outlets(), 
+ *                  UH_Sparse_Window(), UH_Sparse_Offset(), UH_Sparse_Free(),
  *                  Grid_OutletMask(), UH_Generation()
  * 
  * COMMENTS:
@@ -18,6 +19,10 @@
  * - Grid_Velocity():       assign flow velocity to each grid cell
  * - Grid_FlowTime():       compute the flow time of each grid to the outlet
  * - Grid_UH():             generate UH for each grid cell
+ * - UH_Cell_Kernel():      the UH of one grid cell, given its flow time
+ * - UH_Sparse_Window():    the window of nonzero (non-negligible) lags of a cell UH
+ * - UH_Sparse_Offset():    locate the cell windows in the sparse UH values
+ * - UH_Sparse_Free():      free the sparse UH
  * - Grid_Outlets():        extract the number and coordinates (row and col index) of outlets
  * - Grid_OutletMask():     extract the mask (the upstream region) of an outlet (based on coordinates)
  * - UH_Generation():       generate the Unit Hydrograph for multiple outlets
@@ -52,7 +57,8 @@
  * int time_steps            - the steps(length) of a UH 
  * double beta               - parameter in h(t) formula in UH, 
  *                             ratio of the residence time flow water in the reservoir to the total flow time
- * double **data_UH          - a pointer to a pointer pointing to the gridded 2D UH data for a specific outlet
+ * UH_SPARSE *uh_sparse      - the sparse UH of a specific outlet, see "UH_Generation.h"
+ * double *kernel            - the UH series of one grid cell
  * 
 ******************************************************************************/
 
@@ -554,7 +560,7 @@ void Grid_FlowTime(
 void Grid_UH(
     int *data_mask,
     double *data_FlowTime,
-    double **data_UH,
+    UH_SPARSE *uh_sparse,
     int *time_steps,
     double beta,
     int step_time,
@@ -566,8 +572,6 @@ void Grid_UH(
     int i,j,t;
     double FlowTime_max = 0.0;
     double FlowTime_cell;
-    double step;
-    step = (double)step_time;
     for (i = 0; i < nrows; i++)
     {
         for (j = 0; j < ncols; j++)
@@ -588,101 +592,163 @@ void Grid_UH(
     // printf("time_steps: %d\n", *time_steps);
     // printf("size of double: %d\n", sizeof(double));
     // printf("size: %d\n", (*time_steps) * ncols * nrows);
-    *data_UH = (double *)malloc(sizeof(double) * (*time_steps) * ncols * nrows);
-    double UH_value;
-    double Ts, Tr;
-    for (t = 0; t < *time_steps; t++)
+    double *kernel;
+    kernel = (double *)malloc(sizeof(double) * (*time_steps));
+    uh_sparse->UH_steps = *time_steps;
+    uh_sparse->lag0 = (int *)malloc(sizeof(int) * ncols * nrows);
+    uh_sparse->nnz = (int *)malloc(sizeof(int) * ncols * nrows);
+    if (kernel == NULL || uh_sparse->lag0 == NULL || uh_sparse->nnz == NULL)
     {
-        for (i = 0; i < nrows; i++)
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    /* first pass: the window of the stored lags of each cell */
+    for (i = 0; i < nrows; i++)
+    {
+        for (j = 0; j < ncols; j++)
         {
-            for (j = 0; j < ncols; j++)
+            if (*(data_mask + i * ncols + j) == NODATA_value)
             {
-                if (*(data_mask + i * ncols + j) == NODATA_value)
-                {
-                    UH_value = (double)NODATA_value;
-                }
-                else 
+                *(uh_sparse->lag0 + i * ncols + j) = NODATA_value;
+                *(uh_sparse->nnz + i * ncols + j) = 0;
+            }
+            else
+            {
+                FlowTime_cell = *(data_FlowTime + i * ncols + j);
+                UH_Cell_Kernel(FlowTime_cell, beta, step_time, *time_steps, kernel);
+                UH_Sparse_Window(kernel, *time_steps, step_time,
+                                 uh_sparse->lag0 + i * ncols + j, uh_sparse->nnz + i * ncols + j);
+            }
+        }
+    }
+    UH_Sparse_Offset(uh_sparse, ncols * nrows);
+    /* second pass: the stored values */
+    for (i = 0; i < nrows; i++)
+    {
+        for (j = 0; j < ncols; j++)
+        {
+            if (*(data_mask + i * ncols + j) != NODATA_value)
+            {
+                FlowTime_cell = *(data_FlowTime + i * ncols + j);
+                UH_Cell_Kernel(FlowTime_cell, beta, step_time, *time_steps, kernel);
+                for (t = 0; t < *(uh_sparse->nnz + i * ncols + j); t++)
                 {
-                    FlowTime_cell = *(data_FlowTime + i * ncols + j);
-                    Ts = FlowTime_cell * (1 - beta);
-                    Tr = FlowTime_cell * beta;
-                    if ( (t + 1) * step < Ts)
-                    {
-                        UH_value = 0.0;
-                    } else if ((t + 1) * step <= (Ts + step))
-                    {
-                        UH_value = (1 / step) * (exp(1) - exp(1 - ((t + 1) * step - Ts) / Tr));
-                    } else {
-                        UH_value = (1 / step) * exp(- ((t + 1) * step - Ts) / Tr) * (exp(step / Tr) - 1);
-                    }
+                    *(uh_sparse->values + *(uh_sparse->offset + i * ncols + j) + t) = *(kernel + *(uh_sparse->lag0 + i * ncols + j) + t);
                 }
-                
-                *(*data_UH + t * ncols * nrows + i * ncols + j) = UH_value;
             }
         }
     }
-    UH_scale(data_mask, data_UH, *time_steps, step_time, ncols, nrows, NODATA_value);
+    free(kernel);
     printf("Grid_UH: done!\n");
 }
 
-void UH_scale(
-    int *data_mask,
-    double **data_UH,
-    int time_steps,
+void UH_Cell_Kernel(
+    double FlowTime,
+    double beta,
     int step_time,
-    int ncols,
-    int nrows,
-    int NODATA_value
+    int time_steps,
+    double *kernel
 )
 {
-    int index;
-    int n;
-    n = ncols * nrows;
-    double *sum;
-    sum = (double *)malloc(sizeof(double) * n);
-
     /*********
-     * calculate the sum (toals) of UH series
-     * for each grid cell.
+     * the UH of a grid cell with the flow time FlowTime [h]:
+     * it depends only on the flow time (and beta), and
+     * is scaled so that the series sums up to 1/step_time
      */
-    for (size_t i = 0; i < nrows; i++)
+    int t;
+    double UH_value;
+    double Ts, Tr;
+    double step;
+    double sum = 0.0;
+    step = (double)step_time;
+    Ts = FlowTime * (1 - beta);
+    Tr = FlowTime * beta;
+    for (t = 0; t < time_steps; t++)
     {
-        for (size_t j = 0; j < ncols; j++)
+        if ( (t + 1) * step < Ts)
         {
-            index = i * ncols + j;
-            if (*(data_mask + index) == NODATA_value)
-            {
-                *(sum + index) = (double)NODATA_value;
-            }
-            else
-            {
-                *(sum + index) = 0.0;
-                for (size_t t = 0; t < time_steps; t++)
-                {
-                    *(sum + index) += *(*data_UH + t * n + index);
-                }
-                // printf("%.6f\n", *(sum + index));
-            }
+            UH_value = 0.0;
+        } else if ((t + 1) * step <= (Ts + step))
+        {
+            UH_value = (1 / step) * (exp(1) - exp(1 - ((t + 1) * step - Ts) / Tr));
+        } else {
+            UH_value = (1 / step) * exp(- ((t + 1) * step - Ts) / Tr) * (exp(step / Tr) - 1);
         }
+        *(kernel + t) = UH_value;
+        sum += UH_value;
     }
     /**************
      * scale
      */
-    for (size_t i = 0; i < nrows; i++)
+    for (t = 0; t < time_steps; t++)
     {
-        for (size_t j = 0; j < ncols; j++)
-        {
-            index = i * ncols + j;
-            if (*(data_mask + index) != NODATA_value)
-            {
-                for (size_t t = 0; t < time_steps; t++)
-                {
-                    *(*data_UH + t * n + index) = *(*data_UH + t * n + index) * 1.0 / step_time / *(sum + index);
-                }
-            }
-        }
+        *(kernel + t) = *(kernel + t) * 1.0 / step_time / sum;
     }
-    free(sum);
+}
+
+void UH_Sparse_Window(
+    double *kernel,
+    int time_steps,
+    int step_time,
+    int *lag0,
+    int *nnz
+)
+{
+    /*********
+     * the window of lags stored for a cell UH (kernel):
+     * the leading zeros are skipped, and the trailing values are dropped
+     * as long as their sum stays below UH_SPARSE_TOL of the UH total (1/step_time)
+     */
+    int t_end;
+    double tail = 0.0;
+    *lag0 = 0;
+    while (*lag0 < time_steps && *(kernel + *lag0) == 0.0)
+    {
+        *lag0 += 1;
+    }
+    t_end = time_steps;
+    while (t_end > *lag0 && (tail + *(kernel + t_end - 1)) * step_time < UH_SPARSE_TOL)
+    {
+        tail += *(kernel + t_end - 1);
+        t_end -= 1;
+    }
+    *nnz = t_end - *lag0;
+}
+
+void UH_Sparse_Offset(
+    UH_SPARSE *uh_sparse,
+    int cell_counts_total
+)
+{
+    /* positions of the cell windows in values (row-major order), and allocate values */
+    uh_sparse->offset = (size_t *)malloc(sizeof(size_t) * cell_counts_total);
+    if (uh_sparse->offset == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    uh_sparse->nvalues = 0;
+    for (size_t i = 0; i < cell_counts_total; i++)
+    {
+        *(uh_sparse->offset + i) = uh_sparse->nvalues;
+        uh_sparse->nvalues += *(uh_sparse->nnz + i);
+    }
+    uh_sparse->values = (double *)malloc(sizeof(double) * uh_sparse->nvalues);
+    if (uh_sparse->values == NULL && uh_sparse->nvalues > 0)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+}
+
+void UH_Sparse_Free(
+    UH_SPARSE *uh_sparse
+)
+{
+    free(uh_sparse->lag0);
+    free(uh_sparse->nnz);
+    free(uh_sparse->offset);
+    free(uh_sparse->values);
 }
 
 void UH_Generation(
@@ -901,17 +967,25 @@ void UH_Generation(
                           GEO_header.nrows,
                           GEO_header.NODATA_value);
 
-            double *data_UH;
+            UH_SPARSE uh_sparse;
             int time_steps;
             int step_time = 24; // 1 hour
-            double beta = 0.5;
-            Grid_UH(data_Mask, data_FlowTime, &data_UH,
+            double beta = UH_BETA;
+            Grid_UH(data_Mask, data_FlowTime, &uh_sparse,
                     &time_steps, beta, step_time,
                     GEO_header.ncols,
                     GEO_header.nrows,
                     GEO_header.NODATA_value);
 
             printf("* total time steps in UH%d: %d\n", c, time_steps);
+            printf("* stored UH values: %zu (dense: %zu)\n", uh_sparse.nvalues, (size_t)time_steps * cell_counts_total);
+            if (uh_sparse.nvalues == 0)
+            {
+                // a dimension of length 0 would be the unlimited dimension of UH.nc
+                printf("Error: the UH of outlet %zu (row %d, col %d) is empty: no cell drains to the outlet\n",
+                       c, outlet_index_row[c], outlet_index_col[c]);
+                exit(0);
+            }
 
             char varUH_name[40] = "UH";
             char varFlowTime_name[40] = "FlowTime";
@@ -929,7 +1003,16 @@ void UH_Generation(
             nc_def_var(ncID_UH, varOutletMask_name, NC_INT, 2, dims + 1, &varID_OutletMask);
             nc_put_att_int(ncID_UH, varID_OutletMask, "mask_value", NC_INT, 1, (int[]){1});
 
-            nc_def_var(ncID_UH, varUH_name, NC_DOUBLE, 3, dims, &varID_UH);
+            /* sparse UH: the lag windows of the cells and the values, see UH_SPARSE */
+            int dimID_values, varID_lag0, varID_nnz;
+            char varName[60];
+            sprintf(varName, "%s_values", varUH_name);
+            nc_def_dim(ncID_UH, varName, uh_sparse.nvalues, &dimID_values);
+            sprintf(varName, "%s_lag0", varUH_name);
+            nc_def_var(ncID_UH, varName, NC_INT, 2, dims + 1, &varID_lag0);
+            sprintf(varName, "%s_nnz", varUH_name);
+            nc_def_var(ncID_UH, varName, NC_INT, 2, dims + 1, &varID_nnz);
+            nc_def_var(ncID_UH, varUH_name, NC_DOUBLE, 1, &dimID_values, &varID_UH);
             nc_put_att_text(ncID_UH, varID_UH, "units", 40L, "h-1");
             nc_put_att_int(ncID_UH, varID_UH, "step_time", NC_INT, 1, &step_time);
             nc_put_att_int(ncID_UH, varID_UH, "varID", NC_INT, 1, &varID_UH);
@@ -945,16 +1028,15 @@ void UH_Generation(
             nc_put_var_double(ncID_UH, varID_FlowTime, data_FlowTime);
             nc_put_var_int(ncID_UH, varID_OutletMask, data_Mask);
 
-            int out_start[3] = {0, 0, 0};
-            int out_count[3];
-            out_count[0] = time_steps;
-            out_count[1] = GEO_header.nrows;
-            out_count[2] = GEO_header.ncols;
-            status_nc = nc_put_vara_double(ncID_UH, varID_UH, out_start, out_count, data_UH);
+            status_nc = nc_put_var_int(ncID_UH, varID_lag0, uh_sparse.lag0);
+            handle_error(status_nc, FP_UH);
+            status_nc = nc_put_var_int(ncID_UH, varID_nnz, uh_sparse.nnz);
+            handle_error(status_nc, FP_UH);
+            status_nc = nc_put_var_double(ncID_UH, varID_UH, uh_sparse.values);
             handle_error(status_nc, FP_UH);
             free(data_FlowTime);
             free(data_Mask);
-            free(data_UH);
+            UH_Sparse_Free(&uh_sparse);
         }
 
         nc_close(ncID_GEO);
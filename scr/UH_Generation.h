@@ -4,6 +4,24 @@
 
 #include "GEO_ST.h"
 #define MAX_OUTLETS 100     // maximum number of outlets
+#define UH_BETA 0.5         // ratio of the residence time in the reservoir to the total flow time, in h(t) of the UH
+#define UH_SPARSE_TOL 1e-12 // the tail of a cell UH below this fraction of the UH total is not stored
+
+typedef struct
+{
+    /******
+     * sparse UH of one outlet: the UH of a cell is zero before the lag
+     * Ts / step_time and negligible a few multiples of Tr later, so only the
+     * window of lags [lag0, lag0 + nnz) is stored, cell by cell in row-major order;
+     * in UH.nc: the maps UH%d_lag0 and UH%d_nnz, and the values in UH%d
+     */
+    int UH_steps;      /* length of the UH */
+    int *lag0;         /* 2D map: first stored lag of the cell, NODATA_value outside the outlet mask */
+    int *nnz;          /* 2D map: number of stored lags of the cell, 0 outside the outlet mask */
+    size_t *offset;    /* 2D map: position of the first stored value of the cell in values */
+    size_t nvalues;    /* number of stored values */
+    double *values;    /* the stored UH values */
+} UH_SPARSE;
 
 void Grid_Slope(
     int *data_DEM,
@@ -79,7 +97,7 @@ void Grid_FlowTime(
 void Grid_UH(
     int *data_mask,
     double *data_FlowTime,
-    double **data_UH,
+    UH_SPARSE *uh_sparse,
     int *time_steps,
     double beta,
     int step_time,
@@ -88,14 +106,29 @@ void Grid_UH(
     int NODATA_value
 );
 
-void UH_scale(
-    int *data_mask,
-    double **data_UH,
+void UH_Cell_Kernel(
+    double FlowTime,
+    double beta,
+    int step_time,
+    int time_steps,
+    double *kernel
+);
+
+void UH_Sparse_Window(
+    double *kernel,
     int time_steps,
     int step_time,
-    int ncols,
-    int nrows,
-    int NODATA_value
+    int *lag0,
+    int *nnz
+);
+
+void UH_Sparse_Offset(
+    UH_SPARSE *uh_sparse,
+    int cell_counts_total
+);
+
+void UH_Sparse_Free(
+    UH_SPARSE *uh_sparse
 );
 
 void UH_Generation(
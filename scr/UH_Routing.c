@@ -7,12 +7,17 @@
  * ORIG-DATE:    Jan-2024
  * DESCRIPTION:  simulate the surface runoff-induced discharge by using unit hydrograph
  * DESCRIP-END.
- * FUNCTIONS:    UH_Read(), UH_Import(), UH_Routing()
+ * FUNCTIONS:    UH_Read(), UH_Import(), UH_Routing(), UH_Routing_Step(),
+ *               UH_Class_Build(), UH_Class_Routing_Step(), UH_Class_Free()
  *
  * COMMENTS:
  * - UH_Read():          read the main UH attributes from UH.nc
- * - UH_Import():        import the UH fromUH.nc file
+ * - UH_Import():        import the (sparse) UH from UH.nc file
  * - UH_Routing():       route the surface runoff using UH
+ * - UH_Routing_Step():  route the surface runoff of one step using UH (streaming)
+ * - UH_Class_Build():   group the cells of an outlet into flow-time classes sharing one UH
+ * - UH_Class_Routing_Step(): route the surface runoff of one step using the class UH
+ * - UH_Class_Free():    free the flow-time classes
  * - IsNODATA():         
  *
  * REFERENCES:
@@ -22,12 +27,22 @@
 
 /*******************************************************************************
  * VARIABLEs:
+ * int *data_RUNOFF_sf       - surface runoff, [0.1 mm]
+ * UH_SPARSE *uh_sparse      - sparse UH of an outlet, see "UH_Generation.h"
+ * double *Qout              - discharge series at the outlet, [m3/h]
+ * int UH_steps              - length of the UH of an outlet
+ * int *cell_index           - 1D raster index of the active cells
+ * int cell_count            - number of active cells
+ * double class_width        - width of the flow-time classes, [h]
+ * UH_CLASS *uh_class        - flow-time classes of an outlet, see "UH_Routing.h"
+ * double *ring              - runoff sums of the classes over the last UH_steps steps
  *
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <netcdf.h>
 #include "GEO_ST.h"
 #include "NC_copy_global_att.h"
@@ -64,40 +79,118 @@ void UH_Import(
     int ncID_UH,
     int *varID_UH,
     int outlet_count,
-    int cell_counts_total,
+    int ncols,
+    int nrows,
     int *UH_steps,
-    double **data_UH
+    int NODATA_value,
+    UH_SPARSE *uh_sparse
 )
 {
-    int index_begin = 0;
-    for (size_t i = 0; i < outlet_count; i++)
+    /**********
+     * import the sparse UH of each outlet; a UH.nc file with the
+     * dense UH (time_steps 2D maps) is converted into the sparse form
+     */
+    int status_nc;
+    int ndims;
+    int varID;
+    int step_time;
+    int cell_counts_total;
+    char varName[60];
+    char varUH_Name[32];
+    double *data_UH;
+    double *kernel;
+    cell_counts_total = ncols * nrows;
+    for (size_t s = 0; s < outlet_count; s++)
     {
-        // printf("varID_UH: %d\nUH_STEPs: %d\n", *(varID_UH + i), *(UH_steps + i));
-        nc_get_var_double(
-            ncID_UH, *(varID_UH + i), (*data_UH + index_begin)
-        );
-        index_begin += *(UH_steps + i) * cell_counts_total;
+        snprintf(varUH_Name, sizeof(varUH_Name), "UH%zu", s);
+        (uh_sparse + s)->UH_steps = *(UH_steps + s);
+        (uh_sparse + s)->lag0 = (int *)malloc(sizeof(int) * cell_counts_total);
+        (uh_sparse + s)->nnz = (int *)malloc(sizeof(int) * cell_counts_total);
+        if ((uh_sparse + s)->lag0 == NULL || (uh_sparse + s)->nnz == NULL)
+        {
+            printf("memory allocation failed!\n");
+            exit(-3);
+        }
+        status_nc = nc_inq_varndims(ncID_UH, *(varID_UH + s), &ndims); handle_error(status_nc, "UH.nc");
+        if (ndims == 1)
+        {
+            snprintf(varName, sizeof(varName), "%s_lag0", varUH_Name);
+            status_nc = nc_inq_varid(ncID_UH, varName, &varID); handle_error(status_nc, "UH.nc");
+            status_nc = nc_get_var_int(ncID_UH, varID, (uh_sparse + s)->lag0); handle_error(status_nc, "UH.nc");
+            snprintf(varName, sizeof(varName), "%s_nnz", varUH_Name);
+            status_nc = nc_inq_varid(ncID_UH, varName, &varID); handle_error(status_nc, "UH.nc");
+            status_nc = nc_get_var_int(ncID_UH, varID, (uh_sparse + s)->nnz); handle_error(status_nc, "UH.nc");
+            UH_Sparse_Offset(uh_sparse + s, cell_counts_total);
+            status_nc = nc_get_var_double(ncID_UH, *(varID_UH + s), (uh_sparse + s)->values); handle_error(status_nc, "UH.nc");
+        }
+        else
+        {
+            // dense UH from an earlier UH.nc: UH_steps 2D maps
+            status_nc = nc_get_att_int(ncID_UH, *(varID_UH + s), "step_time", &step_time); handle_error(status_nc, "UH.nc");
+            data_UH = (double *)malloc(sizeof(double) * cell_counts_total * *(UH_steps + s));
+            kernel = (double *)malloc(sizeof(double) * *(UH_steps + s));
+            if (data_UH == NULL || kernel == NULL)
+            {
+                printf("memory allocation failed!\n");
+                exit(-3);
+            }
+            status_nc = nc_get_var_double(ncID_UH, *(varID_UH + s), data_UH); handle_error(status_nc, "UH.nc");
+            for (size_t i = 0; i < cell_counts_total; i++)
+            {
+                if (IsNODATA(*(data_UH + i), NODATA_value) == 1)
+                {
+                    *((uh_sparse + s)->lag0 + i) = NODATA_value;
+                    *((uh_sparse + s)->nnz + i) = 0;
+                }
+                else
+                {
+                    for (size_t t = 0; t < *(UH_steps + s); t++)
+                    {
+                        *(kernel + t) = *(data_UH + t * cell_counts_total + i);
+                    }
+                    UH_Sparse_Window(kernel, *(UH_steps + s), step_time,
+                                     (uh_sparse + s)->lag0 + i, (uh_sparse + s)->nnz + i);
+                }
+            }
+            UH_Sparse_Offset(uh_sparse + s, cell_counts_total);
+            for (size_t i = 0; i < cell_counts_total; i++)
+            {
+                for (size_t k = 0; k < *((uh_sparse + s)->nnz + i); k++)
+                {
+                    *((uh_sparse + s)->values + *((uh_sparse + s)->offset + i) + k) =
+                        *(data_UH + (*((uh_sparse + s)->lag0 + i) + k) * cell_counts_total + i);
+                }
+            }
+            free(data_UH); free(kernel);
+        }
     }
 }
 
 
 void UH_Routing(
     int *data_RUNOFF_sf,  // unit: 0.1mm 
-    double *data_UH,
+    UH_SPARSE *uh_sparse,
     double *Qout,
-    int UH_steps,
     int ncols,
     int nrows,
+    int *cell_index,
+    int cell_count,
     int time_steps_run,
     int cellsize_m,
     int NODATA_value,
     int STEP_TIME
 )
 {
+    /**********
+     * only the stored lags [lag0, lag0 + nnz) of each cell are visited:
+     * the zero lags before Ts and the negligible tail are skipped
+     */
     double cell_area;
+    double *values;
     int index_geo;
-    int index_uh;
     int index_run;
+    int lag0;
+    int nnz;
 
     int cell_counts_total;
     cell_counts_total = ncols * nrows;
@@ -107,26 +200,20 @@ void UH_Routing(
     {
         // each simulation step
         *(Qout + r) = 0.0;
-        for (int t = 0; t < UH_steps; t++)
+        for (size_t c = 0; c < cell_count; c++)
         {
-            // each UH step
-            if (r - t >= 0)
+            index_geo = *(cell_index + c);
+            lag0 = *(uh_sparse->lag0 + index_geo);
+            if (lag0 != NODATA_value)
             {
-                // check:
-                // the beginning steps within the length of UH series
-                index_uh = t * cell_counts_total;
-                index_run = (r - t) * cell_counts_total;
-                for (size_t i = 0; i < nrows; i++)
+                nnz = *(uh_sparse->nnz + index_geo);
+                values = uh_sparse->values + *(uh_sparse->offset + index_geo);
+                for (int k = 0; k < nnz && lag0 + k <= r; k++)
                 {
-                    for (size_t j = 0; j < ncols; j++)
-                    {
-                        index_geo = i * ncols + j;
-                        if (IsNODATA(*(data_UH + index_geo), NODATA_value) != 1)
-                        {
-                            // data_RUNOFF_sf: unit: 0.1 mm -> m
-                            *(Qout + r) += *(data_UH + index_uh + index_geo) * *(data_RUNOFF_sf + index_run + index_geo) / 10000; 
-                        }
-                    }
+                    // each stored UH step
+                    index_run = (r - lag0 - k) * cell_counts_total;
+                    // data_RUNOFF_sf: unit: 0.1 mm -> m
+                    *(Qout + r) += *(values + k) * *(data_RUNOFF_sf + index_run + index_geo) / 10000;
                 }
             }
         }
@@ -134,6 +221,262 @@ void UH_Routing(
     }
 }
 
+void UH_Routing_Step(
+    int *data_RUNOFF_sf,  // unit: 0.1mm, the map of step r only
+    UH_SPARSE *uh_sparse,
+    double *Q_ring,
+    double *Qout,
+    int r,
+    int *cell_index,
+    int cell_count,
+    int cellsize_m,
+    int NODATA_value,
+    int STEP_TIME
+)
+{
+    /**********
+     * streaming form of UH_Routing(): the runoff of step r contributes to
+     * the outlet discharge of steps r, r+1, ..., r+UH_steps-1 through UH lags 0, 1, ...
+     * Q_ring holds UH_steps partial sums, *(Q_ring + (r + t) % UH_steps) for step r + t;
+     * the discharge of step r is complete once step r has been added.
+     * The sums are the same as UH_Routing(), only accumulated in another order.
+     */
+    double cell_area;
+    double *values;
+    double runoff;
+    int index_geo;
+    int index_ring;
+    int lag0;
+    int nnz;
+    int UH_steps;
+
+    UH_steps = uh_sparse->UH_steps;
+    cell_area = cellsize_m * cellsize_m;
+
+    for (size_t c = 0; c < cell_count; c++)
+    {
+        index_geo = *(cell_index + c);
+        lag0 = *(uh_sparse->lag0 + index_geo);
+        if (lag0 != NODATA_value)
+        {
+            nnz = *(uh_sparse->nnz + index_geo);
+            values = uh_sparse->values + *(uh_sparse->offset + index_geo);
+            runoff = *(data_RUNOFF_sf + index_geo);
+            for (int k = 0; k < nnz; k++)
+            {
+                // each stored UH step
+                index_ring = (r + lag0 + k) % UH_steps;
+                // data_RUNOFF_sf: unit: 0.1 mm -> m
+                *(Q_ring + index_ring) += *(values + k) * runoff / 10000;
+            }
+        }
+    }
+    index_ring = r % UH_steps;
+    *(Qout + r) = *(Q_ring + index_ring) * cell_area * STEP_TIME; // unit: m3/h
+    *(Q_ring + index_ring) = 0.0;  // reused for step r + UH_steps
+}
+
+void UH_Class_Build(
+    int ncID_UH,
+    int varID_UH,
+    int outlet,
+    int UH_steps,
+    int *cell_index,
+    int cell_count,
+    int cell_counts_total,
+    double class_width,
+    int NODATA_value,
+    UH_CLASS *uh_class
+)
+{
+    /**********
+     * bin the cells upstream of the outlet by their flow time (FlowTime%d in UH.nc):
+     * class = (FlowTime - FlowTime_min) / class_width; empty classes are dropped.
+     * The routing then costs O(K * U + N) per step instead of O(U * N).
+     */
+    int status_nc;
+    int varID_FlowTime;
+    int step_time;
+    char varFT_Name[20];
+    double *data_FlowTime;
+    double *FlowTime_sum;
+    double *kernel_cell;
+    int *class_size;
+    int *class_new;
+    int bin_count;
+    int k;
+    double FlowTime_min, FlowTime_max, FlowTime_cell;
+    double error_cell;
+
+    sprintf(varFT_Name, "FlowTime%d", outlet);
+    status_nc = nc_inq_varid(ncID_UH, varFT_Name, &varID_FlowTime); handle_error(status_nc, "UH.nc");
+    status_nc = nc_get_att_int(ncID_UH, varID_UH, "step_time", &step_time); handle_error(status_nc, "UH.nc");
+    data_FlowTime = (double *)malloc(sizeof(double) * cell_counts_total);
+    uh_class->cell_class = (int *)malloc(sizeof(int) * cell_count);
+    kernel_cell = (double *)malloc(sizeof(double) * UH_steps);
+    if (data_FlowTime == NULL || uh_class->cell_class == NULL || kernel_cell == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    status_nc = nc_get_var_double(ncID_UH, varID_FlowTime, data_FlowTime); handle_error(status_nc, "UH.nc");
+
+    FlowTime_min = -1.0; FlowTime_max = -1.0;
+    for (size_t c = 0; c < cell_count; c++)
+    {
+        FlowTime_cell = *(data_FlowTime + *(cell_index + c));
+        if (IsNODATA(FlowTime_cell, NODATA_value) != 1)
+        {
+            if (FlowTime_min < 0 || FlowTime_cell < FlowTime_min)
+            {
+                FlowTime_min = FlowTime_cell;
+            }
+            if (FlowTime_cell > FlowTime_max)
+            {
+                FlowTime_max = FlowTime_cell;
+            }
+        }
+    }
+    bin_count = (int)((FlowTime_max - FlowTime_min) / class_width) + 1;
+    if (FlowTime_max < 0)
+    {
+        bin_count = 0;  // no cell upstream of the outlet
+    }
+    FlowTime_sum = (double *)calloc(bin_count + 1, sizeof(double));
+    class_size = (int *)calloc(bin_count + 1, sizeof(int));
+    class_new = (int *)malloc(sizeof(int) * (bin_count + 1));
+    if (FlowTime_sum == NULL || class_size == NULL || class_new == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (size_t c = 0; c < cell_count; c++)
+    {
+        FlowTime_cell = *(data_FlowTime + *(cell_index + c));
+        if (IsNODATA(FlowTime_cell, NODATA_value) == 1)
+        {
+            *(uh_class->cell_class + c) = -1;
+        }
+        else
+        {
+            k = (int)((FlowTime_cell - FlowTime_min) / class_width);
+            *(uh_class->cell_class + c) = k;
+            *(FlowTime_sum + k) += FlowTime_cell;
+            *(class_size + k) += 1;
+        }
+    }
+    /* drop the empty classes; the UH of a class is built from its mean flow time */
+    uh_class->class_count = 0;
+    for (k = 0; k < bin_count; k++)
+    {
+        if (*(class_size + k) > 0)
+        {
+            *(class_new + k) = uh_class->class_count;
+            *(FlowTime_sum + uh_class->class_count) = *(FlowTime_sum + k) / *(class_size + k);
+            uh_class->class_count += 1;
+        }
+    }
+    uh_class->UH_steps = UH_steps;
+    uh_class->kernel = (double *)malloc(sizeof(double) * uh_class->class_count * UH_steps);
+    uh_class->ring_Infil = (double *)calloc(uh_class->class_count * UH_steps, sizeof(double));
+    uh_class->ring_Satur = (double *)calloc(uh_class->class_count * UH_steps, sizeof(double));
+    if (uh_class->class_count > 0 &&
+        (uh_class->kernel == NULL || uh_class->ring_Infil == NULL || uh_class->ring_Satur == NULL))
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    for (k = 0; k < uh_class->class_count; k++)
+    {
+        UH_Cell_Kernel(*(FlowTime_sum + k), UH_BETA, step_time, UH_steps, uh_class->kernel + k * UH_steps);
+    }
+    /* the largest deviation of a cell UH from the UH of its class */
+    uh_class->error = 0.0;
+    for (size_t c = 0; c < cell_count; c++)
+    {
+        if (*(uh_class->cell_class + c) >= 0)
+        {
+            k = *(class_new + *(uh_class->cell_class + c));
+            *(uh_class->cell_class + c) = k;
+            UH_Cell_Kernel(*(data_FlowTime + *(cell_index + c)), UH_BETA, step_time, UH_steps, kernel_cell);
+            error_cell = 0.0;
+            for (int t = 0; t < UH_steps; t++)
+            {
+                error_cell += fabs(*(kernel_cell + t) - *(uh_class->kernel + k * UH_steps + t));
+            }
+            error_cell = error_cell * step_time;
+            if (error_cell > uh_class->error)
+            {
+                uh_class->error = error_cell;
+            }
+        }
+    }
+    free(data_FlowTime); free(FlowTime_sum); free(kernel_cell);
+    free(class_size); free(class_new);
+}
+
+void UH_Class_Routing_Step(
+    int *data_RUNOFF_sf,  // unit: 0.1mm, the map of step r only
+    UH_CLASS *uh_class,
+    double *ring,
+    double *Qout,
+    int r,
+    int *cell_index,
+    int cell_count,
+    int cellsize_m,
+    int STEP_TIME
+)
+{
+    /**********
+     * factorized form of UH_Routing_Step(): the runoff of step r is summed
+     * per flow-time class into *(ring + k * U + r % U), and the discharge of
+     * step r is the convolution of the K class series with the K class UH.
+     * The relative deviation from the dense routing is at most uh_class->error.
+     */
+    double cell_area;
+    int k;
+    int U;
+    int index_ring;
+    U = uh_class->UH_steps;
+    cell_area = cellsize_m * cellsize_m;
+
+    index_ring = r % U;
+    for (k = 0; k < uh_class->class_count; k++)
+    {
+        *(ring + k * U + index_ring) = 0.0;  // the sums of step r - U are not used any more
+    }
+    for (size_t c = 0; c < cell_count; c++)
+    {
+        k = *(uh_class->cell_class + c);
+        if (k >= 0)
+        {
+            // data_RUNOFF_sf: unit: 0.1 mm -> m
+            *(ring + k * U + index_ring) += (double)*(data_RUNOFF_sf + *(cell_index + c)) / 10000;
+        }
+    }
+    *(Qout + r) = 0.0;
+    for (int t = 0; t < U && t <= r; t++)
+    {
+        // each UH step
+        index_ring = (r - t) % U;
+        for (k = 0; k < uh_class->class_count; k++)
+        {
+            *(Qout + r) += *(uh_class->kernel + k * U + t) * *(ring + k * U + index_ring);
+        }
+    }
+    *(Qout + r) = *(Qout + r) * cell_area * STEP_TIME; // unit: m3/h
+}
+
+void UH_Class_Free(
+    UH_CLASS *uh_class
+)
+{
+    free(uh_class->cell_class);
+    free(uh_class->kernel);
+    free(uh_class->ring_Infil);
+    free(uh_class->ring_Satur);
+}
+
 int IsNODATA(
     double value,
     int NODATA_value
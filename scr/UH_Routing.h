@@ -3,6 +3,29 @@
 #include "GEO_ST.h"
 #include "UH_Generation.h"
 
+/* UH_MODE: how the surface runoff is routed to the outlets */
+#define UH_MODE_BATCH 0    // sparse UH (UH_SPARSE), after the simulation, from the stored runoff series
+#define UH_MODE_STREAM 1   // sparse UH (UH_SPARSE), at every step
+#define UH_MODE_CLASS 2    // flow-time classes sharing one UH, at every step
+
+typedef struct
+{
+    /******
+     * flow-time classes of the cells upstream of one outlet:
+     * the UH of a cell depends only on its flow time, the cells whose
+     * flow times fall into the same class share one UH (built from the
+     * mean flow time of the class); set by UH_Class_Build()
+     */
+    int class_count;      /* number of (non-empty) flow-time classes, K */
+    int UH_steps;         /* length of the UH, U */
+    int *cell_class;      /* class of each active cell (order of cell_index), -1: outside the outlet mask */
+    double *kernel;       /* UH of the classes, K * U; class k starts at k * U */
+    double *ring_Infil;   /* runoff sums of the classes over the last U steps, K * U, [m] */
+    double *ring_Satur;
+    double error;         /* max over the cells of sum(|UH_cell - UH_class|) * step_time:
+                             bound of the relative deviation from the dense UH routing */
+} UH_CLASS;
+
 void UH_Read(
     int ncID_UH,
     int *varID_UH,
@@ -16,24 +39,69 @@ void UH_Import(
     int ncID_UH,
     int *varID_UH,
     int outlet_count,
-    int cell_counts_total,
+    int ncols,
+    int nrows,
     int *UH_steps,
-    double **data_UH
+    int NODATA_value,
+    UH_SPARSE *uh_sparse
 );
 
 void UH_Routing(
     int *data_RUNOFF_sf,
-    double *data_UH,
+    UH_SPARSE *uh_sparse,
     double *Qout,
-    int UH_steps,
     int ncols,
     int nrows,
+    int *cell_index,
+    int cell_count,
     int time_steps_run,
     int cellsize_m,
     int NODATA_value,
     int STEP_TIME
 );
 
+void UH_Routing_Step(
+    int *data_RUNOFF_sf,
+    UH_SPARSE *uh_sparse,
+    double *Q_ring,
+    double *Qout,
+    int r,
+    int *cell_index,
+    int cell_count,
+    int cellsize_m,
+    int NODATA_value,
+    int STEP_TIME
+);
+
+void UH_Class_Build(
+    int ncID_UH,
+    int varID_UH,
+    int outlet,
+    int UH_steps,
+    int *cell_index,
+    int cell_count,
+    int cell_counts_total,
+    double class_width,
+    int NODATA_value,
+    UH_CLASS *uh_class
+);
+
+void UH_Class_Routing_Step(
+    int *data_RUNOFF_sf,
+    UH_CLASS *uh_class,
+    double *ring,
+    double *Qout,
+    int r,
+    int *cell_index,
+    int cell_count,
+    int cellsize_m,
+    int STEP_TIME
+);
+
+void UH_Class_Free(
+    UH_CLASS *uh_class
+);
+
 int IsNODATA(
     double value,
     int NODATA_value
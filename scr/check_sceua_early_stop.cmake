@@ -0,0 +1,54 @@
+# check_sceua_early_stop.cmake
+# Runs xHM_CALIB twice on one calibration global parameter file, with
+# CALIB_EARLY_STOP 0 and 1, and fails if the SCEUA_history.txt differ:
+# aborting a run early must not change the search.
+#
+# cmake -DXHM_CALIB=<xHM_CALIB> -DGP=<global parameter file> -DWORK=<directory> -P check_sceua_early_stop.cmake
+
+foreach(v XHM_CALIB GP WORK)
+    if(NOT DEFINED ${v})
+        message(FATAL_ERROR "check_sceua_early_stop: -D${v}=... is missing")
+    endif()
+endforeach()
+
+file(STRINGS "${GP}" gp_lines)
+
+foreach(mode 0 1)
+    set(out "${WORK}/early_stop_${mode}/")
+    file(REMOVE_RECURSE "${out}")
+    file(MAKE_DIRECTORY "${out}")
+    # the global parameter file with PATH_OUT and CALIB_EARLY_STOP replaced
+    set(gp_text "")
+    foreach(line IN LISTS gp_lines)
+        if(line MATCHES "^PATH_OUT,")
+            set(line "PATH_OUT,${out}")
+        elseif(line MATCHES "^CALIB_EARLY_STOP,")
+            set(line "# ${line}")
+        endif()
+        string(APPEND gp_text "${line}\n")
+    endforeach()
+    string(APPEND gp_text "CALIB_EARLY_STOP,${mode}\n")
+    file(WRITE "${WORK}/gp_early_stop_${mode}.txt" "${gp_text}")
+
+    # xHM_CALIB returns 1 when done and exits with 0 on bad input: look for its last line
+    execute_process(
+        COMMAND "${XHM_CALIB}" "${WORK}/gp_early_stop_${mode}.txt"
+        OUTPUT_VARIABLE log
+        ERROR_VARIABLE log
+    )
+    file(WRITE "${WORK}/early_stop_${mode}.log" "${log}")
+    if(NOT log MATCHES "xHM calibration: Done!")
+        message(FATAL_ERROR "check_sceua_early_stop: xHM_CALIB failed with CALIB_EARLY_STOP ${mode}, see ${WORK}/early_stop_${mode}.log")
+    endif()
+endforeach()
+
+execute_process(
+    COMMAND "${CMAKE_COMMAND}" -E compare_files
+        "${WORK}/early_stop_0/SCEUA_history.txt"
+        "${WORK}/early_stop_1/SCEUA_history.txt"
+    RESULT_VARIABLE rc
+)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "check_sceua_early_stop: SCEUA_history.txt differs between CALIB_EARLY_STOP 0 and 1")
+endif()
+message(STATUS "check_sceua_early_stop: SCEUA_history.txt identical with CALIB_EARLY_STOP 0 and 1")
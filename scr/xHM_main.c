@@ -24,6 +24,9 @@
 #include <math.h>
 #include <netcdf.h>
 #include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "constants.h"
 #include "Calendar.h"
 #include "HM_ST.h"
@@ -35,6 +38,7 @@
 #include "Evapotranspiration.h"
 #include "Evapotranspiration_Energy.h"
 #include "Evaporation_soil.h"
+#include "Func_Tem.h"
 #include "Soil_Desorption.h"
 #include "GEO_ST.h"
 #include "Resistance.h"
@@ -46,8 +50,16 @@
 #include "UH_Routing.h"
 #include "Soil_UnsaturatedMove.h"
 #include "Soil_SaturatedFlow.h"
+#include "Soil_SaturatedImplicit.h"
 #include "Route_Channel.h"
 #include "Route_Outlet.h"
+#include "Forcing_Reader.h"
+#include "Checkpoint.h"
+#include "State_IO.h"
+#include "Spinup.h"
+#include "Ensemble.h"
+#include "SCEUA.h"
+#include "ET_Batch.h"
 
 void malloc_error(
     int *data);
@@ -56,6 +68,8 @@ char *DateString(
     time_t *tm
 );
 
+double Wall_Time(void);
+
 int main(int argc, char *argv[])
 {
     time_t tm;  //datatype from <time.h>
@@ -67,9 +81,37 @@ int main(int argc, char *argv[])
     GLOBAL_PARA GP;
     Initialize_GlobalPara(&GP);
     Import_GlobalPara(*(++argv), &GP); printf("Done! \n");
+    int restart = 0;  // 1: "--restart", resume the run from the checkpoint FP_CHECKPOINT
+    if (argc > 2)
+    {
+        if (strcmp(*(argv + 1), "--restart") == 0)
+        {
+            restart = 1;
+        }
+        else
+        {
+            printf("Unrecognized option: %s (--restart)\n", *(argv + 1));
+            exit(0);
+        }
+    }
+    if (strlen(GP.FP_CHECKPOINT) == 0)
+    {
+        strcat(strcpy(GP.FP_CHECKPOINT, GP.PATH_OUT), "xHM_checkpoint.bin");
+    }
     Print_GlobalPara(&GP); // print the field-value pairs to screen
     double ws_obs_z;       /* the measurement height of wind speed, [m] */
     ws_obs_z = GP.WIN_H;
+#ifdef _OPENMP
+    if (GP.NUM_THREADS > 0)
+    {
+        omp_set_num_threads(GP.NUM_THREADS);
+    }
+    printf("* threads for the cell loops: %d\n", omp_get_max_threads());
+#endif
+    Func_Tem_Init();  // tables of the saturated vapor pressure, with FUNC_TEM_TABLE
+#ifdef FUNC_TEM_TABLE
+    Func_Tem_Report();
+#endif
     time(&tm); printf("--------- %s read outnamelist: ", DateString(&tm));
     char WS_OUT[MAXCHAR];
     strcpy(WS_OUT, GP.PATH_OUT);
@@ -166,6 +208,17 @@ int main(int argc, char *argv[])
     nc_get_att_int(ncID_GEO, varID_DEM, "NODATA_value", &GEO_header.NODATA_value);
 
     Check_GEO(ncID_GEO);   // check the GEO data
+
+    CELL_LIST cell_list;   // compacted lists of the active cells and channel cells
+    Initialize_CELL_LIST(
+        &cell_list,
+        data_DEM,
+        data_SOILTYPE,
+        data_STR,
+        GEO_header.NODATA_value,
+        GEO_header.ncols,
+        GEO_header.nrows);
+    printf("* active cells: %d\n* channel cells: %d\n", cell_list.cell_count, cell_list.stream_count);
     time(&tm); printf("--------- %s read GEO data: ", DateString(&tm)); printf("Done! \n");
 
     /******************************************************************************
@@ -182,10 +235,18 @@ int main(int argc, char *argv[])
     Import_soil_HWSD_ID(GP.FP_SOIL_HWSD_ID, soilID);
     printf("Done! \n");
 
-    ST_CELL_VEG *cell_veg;
-    ST_SOIL_LIB_CELL *cell_soil;
+    ST_CELL_VEG *cell_veg;          // per-cell vegetation class and canopy fraction
+    ST_VEG_CLASS veg_table[VEG_CLASS_COUNT * 12];  // the vegetation parameters of the classes and months
+    ST_SOIL_LIB_CELL cell_soil;     // library entries of one cell, only needed while deriving the soil table
+    ST_SOIL_PARA_CELL *soil_para;   // per-cell soil parameters read by the soil kernels in the time loop
     cell_veg = (ST_CELL_VEG *)malloc(sizeof(ST_CELL_VEG) * cell_counts_total);
-    cell_soil = (ST_SOIL_LIB_CELL *)malloc(sizeof(ST_SOIL_LIB_CELL) * cell_counts_total);
+    soil_para = (ST_SOIL_PARA_CELL *)malloc(sizeof(ST_SOIL_PARA_CELL) * cell_counts_total);
+    if (cell_veg == NULL || soil_para == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
+    Lookup_VegLib_Table(veglib, ws_obs_z, veg_table);
     int ig;
     for (size_t i = 0; i < GEO_header.nrows; i++)
     {
@@ -195,8 +256,14 @@ int main(int argc, char *argv[])
             if (*(data_SOILTYPE + ig) != GEO_header.NODATA_value)
             {
                 (cell_veg + ig)->CAN_FRAC = *(data_VEGFRAC + ig) / 100;
-                Lookup_VegLib_CELL(veglib, *(data_VEGTYPE + ig), cell_veg + ig);
-                Lookup_Soil_CELL(*(data_SOILTYPE + ig), cell_soil + ig, soillib, soilID);
+                (cell_veg + ig)->CLASS = *(data_VEGTYPE + ig);
+                if (*(data_VEGTYPE + ig) < 0 || *(data_VEGTYPE + ig) >= VEG_CLASS_COUNT)
+                {
+                    printf("Unrecognized vegetation type: %d. Program failled\n", *(data_VEGTYPE + ig));
+                    exit(0);
+                }
+                Lookup_Soil_CELL(*(data_SOILTYPE + ig), &cell_soil, soillib, soilID);
+                Derive_Soil_Para_CELL(&cell_soil, soil_para + ig);
             }
         }
     }
@@ -207,6 +274,7 @@ int main(int argc, char *argv[])
     time(&tm); printf("--------- %s read weather forcing: \n", DateString(&tm));
     int ncID_PRE, ncID_PRS, ncID_RHU, ncID_SSD, ncID_WIN, ncID_TEM_AVG, ncID_TEM_MAX, ncID_TEM_MIN;
     int varID_PRE, varID_PRS, varID_RHU, varID_SSD, varID_WIN, varID_TEM_AVG, varID_TEM_MAX, varID_TEM_MIN;
+    // maps of the current step, owned by the forcing reader (see Forcing_Reader.h)
     int *data_PRE;
     int *data_PRS;
     int *data_SSD;
@@ -328,32 +396,7 @@ int main(int argc, char *argv[])
     status_nc = nc_inq_varid(ncID_TEM_MIN, "TEM_MIN", &varID_TEM_MIN);
     handle_error(status_nc, GP.FP_TEM_MIN);
     
-    // allocate memory for only one-step data (2D raster)
-    data_PRE = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_PRE);
-    data_PRS = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_PRS);
-    data_SSD = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_SSD);
-    data_RHU = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_RHU);
-    data_WIN = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_WIN);
-    data_TEM_AVG = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_TEM_AVG);
-    data_TEM_MAX = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_TEM_MAX);
-    data_TEM_MIN = (int *)malloc(sizeof(int) * cell_counts_total);
-    malloc_error(data_TEM_MIN);
-
-    // read relevant (corresponding simulation period) weather forcing into memory
-    // nc_get_vara_*: extract variable ARRAY from nc dataset
-    int nc_start[3] = {0, 0, 0};
-    int nc_count[3] = {0, 0, 0};
-    nc_count[0] = 1;
-    nc_count[1] = GEO_header.nrows;
-    nc_count[2] = GEO_header.ncols;
-    
+
     nc_get_att_int(ncID_PRE, varID_PRE, "NODATA_value", &GEO_header.NODATA_value);
     // the scale_factor and offset parameters for NC variables
     double scale_PRE, scale_PRS, scale_SSD, scale_RHU, scale_WIN, scale_TEM_AVG, scale_TEM_MAX, scale_TEM_MIN;
@@ -381,7 +424,9 @@ int main(int argc, char *argv[])
     time_t run_time;
     run_time = start_time;
     int index_run;
+    int run_offset;  // index of the current step in the surface runoff arrays
     int index_geo;
+    int index_row;  // row index of the cell, for the latitude
 
     /***********************************************************************************
      *                      surface runoff routing - UH
@@ -398,6 +443,31 @@ int main(int argc, char *argv[])
     int outlet_index_col[MAX_OUTLETS];
     int UH_steps[MAX_OUTLETS];
     int UH_steps_total = 0;
+    int UH_mode;    // UH_MODE_BATCH, UH_MODE_STREAM or UH_MODE_CLASS, see "UH_Routing.h"
+    int UH_stream;  // 1: UH routing at every step (STREAM, CLASS), 0: after the simulation (BATCH)
+    if (strcmp(GP.UH_MODE, "STREAM") == 0)
+    {
+        UH_mode = UH_MODE_STREAM;
+    }
+    else if (strcmp(GP.UH_MODE, "BATCH") == 0)
+    {
+        UH_mode = UH_MODE_BATCH;
+    }
+    else if (strcmp(GP.UH_MODE, "CLASS") == 0)
+    {
+        UH_mode = UH_MODE_CLASS;
+        if (GP.UH_CLASS_WIDTH <= 0.0)
+        {
+            printf("UH_CLASS_WIDTH should be positive: %f\n", GP.UH_CLASS_WIDTH);
+            exit(0);
+        }
+    }
+    else
+    {
+        printf("Unrecognized UH_MODE: %s (BATCH, STREAM or CLASS)\n", GP.UH_MODE);
+        exit(0);
+    }
+    UH_stream = (UH_mode == UH_MODE_BATCH) ? 0 : 1;
     UH_Read(
         ncID_UH,
         varID_UH,
@@ -409,57 +479,88 @@ int main(int argc, char *argv[])
     printf("* %6s%6s%6s%6s\n", "outlet", "row", "col", "steps");
     for (size_t s = 0; s < outlet_count; s++)
     {
-        printf("* %6d%6d%6d%6d\n", s, outlet_index_row[s], outlet_index_col[s], UH_steps[s]);
+        printf("* %6zu%6d%6d%6d\n", s, outlet_index_row[s], outlet_index_col[s], UH_steps[s]);
         UH_steps_total += UH_steps[s];
     }
     // printf("* UH_steps_total: %d\n", UH_steps_total);
-    double *data_UH;
-    data_UH = (double *)malloc(sizeof(double) * cell_counts_total * UH_steps_total);
-    UH_Import(
-        ncID_UH,
-        varID_UH,
-        outlet_count,
-        cell_counts_total,
-        UH_steps,
-        &data_UH);
+    UH_SPARSE uh_sparse[MAX_OUTLETS];
+    UH_CLASS uh_class[MAX_OUTLETS];
+    if (UH_mode == UH_MODE_CLASS)
+    {
+        // the dense UH maps are not needed: one UH per flow-time class
+        for (size_t s = 0; s < outlet_count; s++)
+        {
+            UH_Class_Build(
+                ncID_UH, varID_UH[s], s, UH_steps[s],
+                cell_list.cell_index, cell_list.cell_count, cell_counts_total,
+                GP.UH_CLASS_WIDTH, GEO_header.NODATA_value, &uh_class[s]);
+            printf("* outlet %zu: %d flow-time classes (width %.2f h), max relative deviation from the dense UH: %.2e\n",
+                   s, uh_class[s].class_count, GP.UH_CLASS_WIDTH, uh_class[s].error);
+        }
+    }
+    else
+    {
+        UH_Import(
+            ncID_UH,
+            varID_UH,
+            outlet_count,
+            GEO_header.ncols,
+            GEO_header.nrows,
+            UH_steps,
+            GEO_header.NODATA_value,
+            uh_sparse);
+        for (size_t s = 0; s < outlet_count; s++)
+        {
+            printf("* outlet %zu: %zu UH values stored (%.1f MB; dense: %.1f MB)\n",
+                   s, uh_sparse[s].nvalues, uh_sparse[s].nvalues * sizeof(double) / 1048576.0,
+                   (double)UH_steps[s] * cell_counts_total * sizeof(double) / 1048576.0);
+        }
+    }
+    /******
+     * streaming UH routing: partial sums of the outlet discharge
+     * of the coming UH_steps[s] steps, for each outlet
+     */
+    double *UH_ring_Infil, *UH_ring_Satur;
+    int index_UH_ring;  // offset of the partial sums of an outlet in UH_ring_*
+    UH_ring_Infil = (double *)calloc(UH_steps_total, sizeof(double));
+    UH_ring_Satur = (double *)calloc(UH_steps_total, sizeof(double));
+    if (UH_ring_Infil == NULL || UH_ring_Satur == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
     time(&tm); printf("--------- %s prepare UH: ", DateString(&tm)); printf("Done!\n");
     /***********************************************************************************
      *              define and initialize the intermediate variables
      ***********************************************************************************/
     time(&tm); printf("--------- %s initialize intermediate data structures: \n", DateString(&tm));
-    CELL_VAR_RADIA *data_RADIA;
-    data_RADIA = (CELL_VAR_RADIA *)malloc(sizeof(CELL_VAR_RADIA) * cell_counts_total);
-    
-    CELL_VAR_ET *data_ET;
-    data_ET = (CELL_VAR_ET *)malloc(sizeof(CELL_VAR_ET) * cell_counts_total);
-    
-    CELL_VAR_SOIL *data_SOIL;
-    data_SOIL = (CELL_VAR_SOIL *)malloc(sizeof(CELL_VAR_SOIL) * cell_counts_total);
-    
-    CELL_VAR_STREAM *data_STREAM;
-    data_STREAM = (CELL_VAR_STREAM *)malloc(sizeof(CELL_VAR_STREAM) * cell_counts_total);
-    
-    for (size_t i = 0; i < GEO_header.nrows; i++)
-    {
-        for (size_t j = 0; j < GEO_header.ncols; j++)
-        {
-            index_geo = i * GEO_header.ncols + j;
-            Initialize_RADIA(data_RADIA + index_geo);
-            Initialize_ET(data_ET + index_geo);
-            Initialize_SOIL(data_SOIL + index_geo);
-        }
-    }
+    CELL_VAR_RADIA data_RADIA;
+    Allocate_RADIA(&data_RADIA, cell_counts_total);
+    Initialize_RADIA(&data_RADIA, cell_counts_total);
     printf("* data_RADIA\n");
+
+    CELL_VAR_ET data_ET;
+    Allocate_ET(&data_ET, cell_counts_total);
+    Initialize_ET(&data_ET, cell_counts_total);
     printf("* data_ET\n");
 
+    CELL_VAR_SOIL data_SOIL;
+    CELL_NEIGHBOR data_NEIGHBOR;
+    Allocate_SOIL(&data_SOIL, cell_counts_total);
+    Allocate_NEIGHBOR(&data_NEIGHBOR, cell_counts_total);
+    Initialize_SOIL(&data_SOIL, cell_counts_total);
     Initialize_Soil_Satur(
-        data_SOIL,
+        &data_SOIL,
+        &data_NEIGHBOR,
         data_DEM,
         GEO_header.NODATA_value,
         GEO_header.ncols,
         GEO_header.nrows);
     printf("* data_SOIL\n");
 
+    CELL_VAR_STREAM *data_STREAM;
+    data_STREAM = (CELL_VAR_STREAM *)malloc(sizeof(CELL_VAR_STREAM) * cell_counts_total);
+
     Initialize_STREAM(
         &data_STREAM,
         data_STR,
@@ -468,9 +569,245 @@ int main(int argc, char *argv[])
         GEO_header.NODATA_value,
         GEO_header.ncols,
         GEO_header.nrows);
-    printf("* data_STREAM\n");
+    CHANNEL_NETWORK channel_network;  // the channel cells sorted upstream-to-downstream
+    int route_order;
+    if (strcmp(GP.ROUTE_CHANNEL_ORDER, "TOPO") == 0)
+    {
+        route_order = CHANNEL_TOPO;
+    }
+    else if (strcmp(GP.ROUTE_CHANNEL_ORDER, "LEVEL") == 0)
+    {
+        route_order = CHANNEL_LEVEL;
+    }
+    else if (strcmp(GP.ROUTE_CHANNEL_ORDER, "LAGGED") == 0)
+    {
+        route_order = CHANNEL_LAGGED;
+    }
+    else
+    {
+        printf("Unrecognized ROUTE_CHANNEL_ORDER: %s (TOPO, LEVEL or LAGGED)\n", GP.ROUTE_CHANNEL_ORDER);
+        exit(0);
+    }
+    Initialize_Channel_Network(
+        &channel_network,
+        data_STREAM,
+        cell_list.stream_index,
+        cell_list.stream_count,
+        GEO_header.ncols,
+        GEO_header.nrows);
+    printf("* data_STREAM: %d reaches in %d levels\n", channel_network.reach_count, channel_network.level_count);
+    if (strlen(GP.FP_STATE_IN) > 0)
+    {
+        // warm start: the state at the end of a previous run replaces the uniform initial values
+        State_Import(
+            GP.FP_STATE_IN,
+            ncID_GEO,
+            (long)start_time,
+            &data_ET,
+            &data_SOIL,
+            data_STREAM,
+            &cell_list,
+            cell_counts_total,
+            GEO_header.NODATA_value);
+        printf("* initial state: %s\n", GP.FP_STATE_IN);
+    }
+    int satu_kernel;
+    if (strcmp(GP.SOIL_SATU_KERNEL, "SIMD") == 0)
+    {
+        satu_kernel = SATU_KERNEL_SIMD;
+    }
+    else if (strcmp(GP.SOIL_SATU_KERNEL, "SCALAR") == 0)
+    {
+        satu_kernel = SATU_KERNEL_SCALAR;
+    }
+    else
+    {
+        printf("Unrecognized SOIL_SATU_KERNEL: %s (SIMD or SCALAR)\n", GP.SOIL_SATU_KERNEL);
+        exit(0);
+    }
+    int satu_solver;
+    SATU_SYSTEM satu_system;  // the linear system of the implicit saturated lateral flow
+    if (strcmp(GP.SOIL_SATU_SOLVER, "EXPLICIT") == 0)
+    {
+        satu_solver = SATU_SOLVER_EXPLICIT;
+    }
+    else if (strcmp(GP.SOIL_SATU_SOLVER, "IMPLICIT") == 0)
+    {
+        satu_solver = SATU_SOLVER_IMPLICIT;
+        Soil_Satu_System_Build(
+            &satu_system,
+            cell_list.cell_index,
+            cell_list.cell_count,
+            &data_NEIGHBOR,
+            GEO_header.ncols,
+            cell_counts_total,
+            GP.SOIL_SATU_CG_TOL,
+            GP.SOIL_SATU_CG_ITER);
+        printf("* satu_system: %d rows, %d entries\n",
+               satu_system.row_count, *(satu_system.row_start + satu_system.row_count));
+    }
+    else
+    {
+        printf("Unrecognized SOIL_SATU_SOLVER: %s (EXPLICIT or IMPLICIT)\n", GP.SOIL_SATU_SOLVER);
+        exit(0);
+    }
+    int et_kernel;
+    ET_BATCH_PLAN et_plan;   // the active cells sorted by kind, for ET_KERNEL BATCH and CHECK
+    long et_check_diff = 0;  // CHECK: cell steps where the batch differs from the reference
+    long et_check_count = 0; // CHECK: cell steps compared
+    if (strcmp(GP.ET_KERNEL, "BATCH") == 0)
+    {
+        et_kernel = ET_KERNEL_BATCH;
+    }
+    else if (strcmp(GP.ET_KERNEL, "CHECK") == 0)
+    {
+        et_kernel = ET_KERNEL_CHECK;
+    }
+    else if (strcmp(GP.ET_KERNEL, "SCALAR") == 0)
+    {
+        et_kernel = ET_KERNEL_SCALAR;
+    }
+    else
+    {
+        printf("Unrecognized ET_KERNEL: %s (BATCH, SCALAR or CHECK)\n", GP.ET_KERNEL);
+        exit(0);
+    }
+    if (et_kernel != ET_KERNEL_SCALAR)
+    {
+        ET_Batch_Plan(&et_plan, &cell_list, cell_veg, veg_table);
+        printf("* ET batches: %d, cells by kind (OU, O, U, S, MIX):", et_plan.batch_count);
+        for (int k = 0; k < ET_KIND_COUNT; k++)
+        {
+            printf(" %d", et_plan.kind_start[k + 1] - et_plan.kind_start[k]);
+        }
+        printf("\n");
+    }
+    double scale_forcing[FORCING_VARS] = {scale_PRE, scale_PRS, scale_SSD, scale_RHU, scale_WIN, scale_TEM_AVG, scale_TEM_MAX, scale_TEM_MIN};
+    int satu_substeps = 1;   // sub-steps of the saturated lateral flow in this step (EXPLICIT)
+    long satu_substeps_total = 0;
+    int satu_substeps_max = 1;
+    double time_satu = 0.0;  // time spent in the saturated lateral flow, [s]
+    double time_satu_begin;
 
     time(&tm); printf("--------- %s initialize intermediate data structures: ", DateString(&tm)); printf("Done!\n");
+    /***********************************************************************************
+     *              parameter ensemble: the parameter sets of FP_ENSEMBLE
+     *              share the data read so far, see Ensemble.c;
+     *              calibration (xHM_CALIB): SCE-UA by ensembles, see SCEUA.c
+     ***********************************************************************************/
+    int calib = 0;
+#ifdef XHM_CALIB
+    calib = 1;
+#endif
+    if (strlen(GP.FP_ENSEMBLE) > 0 || calib == 1)
+    {
+        ENSEMBLE_DATA ens;
+        ENSEMBLE_PARA *ens_para;
+        ENSEMBLE_MEMBER *ens_member;
+        int member_count;
+        // the options of a single run, not applied to the members (ET_KERNEL: the members run cell by cell, as SCALAR)
+        char *ens_mode = (calib == 1) ? "calibration" : "parameter ensemble";
+        if (GP.SPINUP_STEPS > 0)
+        {
+            printf("* warning: SPINUP_STEPS is ignored by the %s\n", ens_mode);
+        }
+        if (GP.CHECKPOINT_STEPS > 0 || restart == 1)
+        {
+            printf("* warning: CHECKPOINT_STEPS and --restart are ignored by the %s\n", ens_mode);
+        }
+        if (strlen(GP.FP_STATE_OUT) > 0)
+        {
+            printf("* warning: FP_STATE_OUT is ignored by the %s\n", ens_mode);
+        }
+        if (et_kernel == ET_KERNEL_CHECK)
+        {
+            printf("* warning: ET_KERNEL CHECK is ignored by the %s\n", ens_mode);
+        }
+        ens.GP = &GP;
+        ens.ncID_GEO = ncID_GEO;
+        ens.GEO_header = GEO_header;
+        ens.cellsize_m = cellsize_m;
+        ens.cell_counts_total = cell_counts_total;
+        ens.cell_list = &cell_list;
+        ens.data_STR = data_STR;
+        ens.data_FDR = data_FDR;
+        ens.data_DEM = data_DEM;
+        ens.data_lat = data_lat;
+        ens.cell_veg = cell_veg;
+        ens.veg_table = veg_table;
+        ens.soil_para = soil_para;
+        ens.data_NEIGHBOR = &data_NEIGHBOR;
+        ens.channel_network = &channel_network;
+        ens.route_order = route_order;
+        ens.satu_solver = satu_solver;
+        ens.satu_kernel = satu_kernel;
+        ens.start_time = start_time;
+        ens.time_steps_run = time_steps_run;
+        int ens_ncID[FORCING_VARS] = {ncID_PRE, ncID_PRS, ncID_SSD, ncID_RHU, ncID_WIN, ncID_TEM_AVG, ncID_TEM_MAX, ncID_TEM_MIN};
+        int ens_varID[FORCING_VARS] = {varID_PRE, varID_PRS, varID_SSD, varID_RHU, varID_WIN, varID_TEM_AVG, varID_TEM_MAX, varID_TEM_MIN};
+        int ens_t_offset[FORCING_VARS] = {t_offset_PRE, t_offset_PRS, t_offset_SSD, t_offset_RHU, t_offset_WIN, t_offset_TEM_AVG, t_offset_TEM_MAX, t_offset_TEM_MIN};
+        char *ens_FP[FORCING_VARS] = {GP.FP_PRE, GP.FP_PRS, GP.FP_SSD, GP.FP_RHU, GP.FP_WIN, GP.FP_TEM_AVG, GP.FP_TEM_MAX, GP.FP_TEM_MIN};
+        double ens_scale[FORCING_VARS] = {scale_PRE, scale_PRS, scale_SSD, scale_RHU, scale_WIN, scale_TEM_AVG, scale_TEM_MAX, scale_TEM_MIN};
+        for (size_t v = 0; v < FORCING_VARS; v++)
+        {
+            ens.ncID_forcing[v] = ens_ncID[v];
+            ens.varID_forcing[v] = ens_varID[v];
+            ens.t_offset_forcing[v] = ens_t_offset[v];
+            ens.FP_forcing[v] = ens_FP[v];
+            ens.scale_forcing[v] = ens_scale[v];
+            ens.forcing_all[v] = NULL;
+        }
+        if (GP.FORCING_BLOCK > 0)
+        {
+            ens.forcing_block = (GP.FORCING_BLOCK < time_steps_run) ? GP.FORCING_BLOCK : time_steps_run;
+        }
+        else
+        {
+            ens.forcing_block = Forcing_Block_Size(GP.FORCING_MEMORY, GEO_header.nrows, GEO_header.ncols, time_steps_run);
+        }
+        ens.outlet_count = outlet_count;
+        ens.outlet_index_row = outlet_index_row;
+        ens.outlet_index_col = outlet_index_col;
+        if (UH_mode == UH_MODE_CLASS)
+        {
+            // the members share the sparse UH of FP_UH (UH_MODE CLASS did not import it)
+            UH_Import(ncID_UH, varID_UH, outlet_count, GEO_header.ncols, GEO_header.nrows,
+                      UH_steps, GEO_header.NODATA_value, uh_sparse);
+        }
+        ens.uh_sparse = uh_sparse;
+        Ensemble_UH_Base(&ens);
+        Ensemble_State_Load(&ens);
+        if (calib == 1)
+        {
+            time(&tm); printf("--------- %s calibration (SCE-UA): \n", DateString(&tm));
+            SCEUA_Calibrate(&ens);
+            time(&tm); printf("--------- %s xHM calibration: Done!\n", DateString(&tm));
+            return 1;
+        }
+
+        time(&tm); printf("--------- %s parameter ensemble: \n", DateString(&tm));
+        member_count = Ensemble_Import(GP.FP_ENSEMBLE, &GP, &ens_para);
+        ens_member = (ENSEMBLE_MEMBER *)malloc(sizeof(ENSEMBLE_MEMBER) * member_count);
+        if (ens_member == NULL)
+        {
+            printf("memory allocation failed!\n");
+            exit(-3);
+        }
+        for (int k = 0; k < member_count; k++)
+        {
+            Ensemble_Allocate(&ens, ens_member + k);
+        }
+        Ensemble_Reset(&ens, ens_para, ens_member, member_count);
+        printf("* members: %d\n", member_count);
+        time(&tm); printf("--------- %s xHM hydrological processes simulating (ensemble): ", DateString(&tm));
+        Ensemble_Run(&ens, ens_para, ens_member, member_count);
+        printf("Done!\n");
+        Ensemble_Write_Qout(&ens, ens_para, ens_member, member_count);
+        Ensemble_Free(&ens, ens_member, member_count);
+        free(ens_member); free(ens_para);
+        time(&tm); printf("--------- %s xHM modelling (ensemble): Done!\n", DateString(&tm));
+        return 1;
+    }
     /***********************************************************************************
      *              define the output variables (results) from simulation
      ***********************************************************************************/
@@ -494,9 +831,12 @@ int main(int argc, char *argv[])
         &out_SW_Infiltration, 
         &out_SW_SUB_Qin, &out_SW_SUB_Qout, &out_SW_SUB_z, 
         &out_SW_SUB_rise_upper, &out_SW_SUB_rise_lower, 
-        &out_SW_SUB_rf, &out_SW_SUB_Qc, &out_Q_Channel);
-    out_SW_Run_Infil = (int *)malloc(sizeof(int) * time_steps_run * cell_counts_total); malloc_error(out_SW_Run_Infil);
-    out_SW_Run_Satur = (int *)malloc(sizeof(int) * time_steps_run * cell_counts_total); malloc_error(out_SW_Run_Satur);
+        &out_SW_SUB_rf, &out_SW_SUB_Qc, &out_Q_Channel, restart);
+    malloc_Outnamelist_Runoff(
+        outnl, &outnl_ncid,
+        cell_counts_total, time_steps_run,
+        &data_DEM, GEO_header, GP, UH_stream,
+        &out_SW_Run_Infil, &out_SW_Run_Satur, restart);
 
     double *Qout_SF_Infil, *Qout_SF_Satur, *Qout_Sub, *Qout_outlet;
     Qout_SF_Infil = (double *)malloc(sizeof(double) * outlet_count * time_steps_run);
@@ -504,18 +844,65 @@ int main(int argc, char *argv[])
     Qout_Sub = (double *)malloc(sizeof(double) * outlet_count * time_steps_run);
     Qout_outlet = (double *)malloc(sizeof(double) * outlet_count * time_steps_run);
     printf("Done!\n");
+    /***********************************************************************************
+     *          checkpoint: the model state is saved every CHECKPOINT_STEPS steps,
+     *          and restored with "--restart", see Checkpoint.c
+     ***********************************************************************************/
+    CHECKPOINT_HEADER checkpoint;
+    int UH_ring_count = 0;
+    int t_restart = 0;  // the step the run starts with: 0, or the steps completed in the checkpoint
+    if (UH_mode == UH_MODE_STREAM)
+    {
+        UH_ring_count = UH_steps_total;
+    }
+    else if (UH_mode == UH_MODE_CLASS)
+    {
+        for (size_t s = 0; s < outlet_count; s++)
+        {
+            UH_ring_count += uh_class[s].class_count * uh_class[s].UH_steps;
+        }
+    }
+    Checkpoint_Header(
+        &checkpoint,
+        GEO_header.ncols,
+        GEO_header.nrows,
+        cell_list.cell_count,
+        GP.STEP_TIME,
+        (long)start_time,
+        time_steps_run,
+        UH_mode,
+        outlet_count,
+        UH_ring_count);
+    if (restart == 1)
+    {
+        time(&tm); printf("--------- %s restart from checkpoint %s: ", DateString(&tm), GP.FP_CHECKPOINT);
+        t_restart = Checkpoint_Read(
+            GP.FP_CHECKPOINT, &checkpoint,
+            &data_RADIA, &data_ET, &data_SOIL, data_STREAM, cell_counts_total,
+            UH_ring_Infil, UH_ring_Satur, uh_class,
+            Qout_SF_Infil, Qout_SF_Satur, Qout_Sub,
+            out_SW_Run_Infil, out_SW_Run_Satur);
+        printf("%d of %d steps completed\n", t_restart, time_steps_run);
+    }
     /***********************************************************************************
      *                       define the iteration variables
      ***********************************************************************************/
-    int t = 0;
+    int t = t_restart;
     double cell_PRE, cell_WIN, cell_SSD, cell_RHU, cell_PRS, cell_TEM_AVG, cell_TEM_MAX, cell_TEM_MIN;
-    double cell_lat;
+    RADIA_ASTRO *radia_astro;  // the astronomical radiation terms of the rows, at the current step
+    ST_VEG_CLASS *cell_veg_mon;  // the vegetation parameters of the class of the cell, in the current month
     int year;
     int month;
     int day;
     struct tm *tm_run;
     double Soil_Fe = 0.0;
     int i_m; // the index of month
+    radia_astro = (RADIA_ASTRO *)malloc(sizeof(RADIA_ASTRO) * GEO_header.nrows);
+    if (radia_astro == NULL)
+    {
+        printf("memory allocation failed!\n");
+        exit(-3);
+    }
 
     /***********************************************************************************
      *                     hydrological parameters
@@ -526,10 +913,73 @@ int main(int argc, char *argv[])
     Soil_d2 = GP.SOIL_d2;
     stream_depth = GP.STREAM_D;
     stream_width = GP.STREAM_W;
+    /***********************************************************************************
+     *                       weather forcing reader
+     * the forcing maps are read (nc_get_vara_*) in blocks of forcing_block steps,
+     * the next block in the background while the current one is simulated,
+     * see Forcing_Reader.c
+     ***********************************************************************************/
+    FORCING_READER forcing_reader;
+    int forcing_block;
+    if (GP.FORCING_BLOCK > 0)
+    {
+        forcing_block = (GP.FORCING_BLOCK < time_steps_run - t_restart) ? GP.FORCING_BLOCK : time_steps_run - t_restart;
+    }
+    else
+    {
+        forcing_block = Forcing_Block_Size(GP.FORCING_MEMORY, GEO_header.nrows, GEO_header.ncols, time_steps_run - t_restart);
+    }
+    printf("* forcing block: %d steps, %.1f MB buffers\n", forcing_block,
+           2.0 * FORCING_VARS * sizeof(int) * forcing_block * cell_counts_total / 1024 / 1024);
+    int *data_forcing[FORCING_VARS];
+    int ncID_forcing[FORCING_VARS] = {ncID_PRE, ncID_PRS, ncID_SSD, ncID_RHU, ncID_WIN, ncID_TEM_AVG, ncID_TEM_MAX, ncID_TEM_MIN};
+    int varID_forcing[FORCING_VARS] = {varID_PRE, varID_PRS, varID_SSD, varID_RHU, varID_WIN, varID_TEM_AVG, varID_TEM_MAX, varID_TEM_MIN};
+    int t_offset_forcing[FORCING_VARS] = {t_offset_PRE, t_offset_PRS, t_offset_SSD, t_offset_RHU, t_offset_WIN, t_offset_TEM_AVG, t_offset_TEM_MAX, t_offset_TEM_MIN};
+    for (size_t v = 0; v < FORCING_VARS; v++)
+    {
+        // a restarted run reads the forcing from step t_restart on
+        t_offset_forcing[v] += t_restart;
+    }
+    char *FP_forcing[FORCING_VARS] = {GP.FP_PRE, GP.FP_PRS, GP.FP_SSD, GP.FP_RHU, GP.FP_WIN, GP.FP_TEM_AVG, GP.FP_TEM_MAX, GP.FP_TEM_MIN};
+    /***********************************************************************************
+     *                       spin-up
+     * the first spinup_steps steps are simulated in cycles, without any output,
+     * until the state converges (see Spinup.c); the run then starts over from
+     * the spun-up state. A restarted run is spun up already.
+     ***********************************************************************************/
+    int spinup = 0;
+    int spinup_steps = 0;
+    int spinup_cycle = 0;
+    double spinup_mean[SPINUP_VARS];
+    if (GP.SPINUP_STEPS > 0 && restart == 0)
+    {
+        spinup = 1;
+        spinup_steps = (GP.SPINUP_STEPS < time_steps_run) ? GP.SPINUP_STEPS : time_steps_run;
+        Spinup_Means(&data_SOIL, cell_list.cell_index, cell_list.cell_count, spinup_mean);
+    }
+    Forcing_Reader_Start(
+        &forcing_reader,
+        ncID_forcing,
+        varID_forcing,
+        t_offset_forcing,
+        FP_forcing,
+        GEO_header.nrows,
+        GEO_header.ncols,
+        (spinup == 1) ? spinup_steps : time_steps_run - t_restart,
+        forcing_block,
+        GP.FORCING_ASYNC);
+    run_time = start_time + 3600 * GP.STEP_TIME * t_restart;
     /***********************************************************************************
      *                       xHM model iteration
      ***********************************************************************************/
-    time(&tm); printf("--------- %s xHM hydrological processes simulating: ", DateString(&tm));
+    if (spinup == 1)
+    {
+        time(&tm); printf("--------- %s xHM spin-up, cycles of %d steps:\n", DateString(&tm), spinup_steps);
+    }
+    else
+    {
+        time(&tm); printf("--------- %s xHM hydrological processes simulating: ", DateString(&tm));
+    }
     while (run_time <= end_time)
     {
         tm_run = gmtime(&run_time);
@@ -538,7 +988,7 @@ int main(int argc, char *argv[])
         i_m = month - 1;
         day = tm_run->tm_mday;
         // printf("%d-%02d-%02d\n", year, month, day);
-        if (t % 730 == 0)
+        if (t % 730 == 0 && spinup == 0)
         {
             printf("*");
         }
@@ -547,271 +997,314 @@ int main(int argc, char *argv[])
          * a map (time step) of forcing data is extracted into memory
          * for process simulation 
         */
-        nc_start[0] = t_offset_PRE + t;
-        status_nc = nc_get_vara_int(ncID_PRE, varID_PRE, nc_start, nc_count, data_PRE); // status_nc = nc_get_var_int(ncID_PRE, varID_PRE, data_PRE);
-        handle_error(status_nc, GP.FP_PRE);
-
-        nc_start[0] = t_offset_PRS + t;
-        status_nc = nc_get_vara_int(ncID_PRS, varID_PRS, nc_start, nc_count, data_PRS);
-        handle_error(status_nc, GP.FP_PRS);
-
-        nc_start[0] = t_offset_SSD + t;
-        status_nc = nc_get_vara_int(ncID_SSD, varID_SSD, nc_start, nc_count, data_SSD);
-        handle_error(status_nc, GP.FP_SSD);
-
-        nc_start[0] = t_offset_RHU + t;
-        status_nc = nc_get_vara_int(ncID_RHU, varID_RHU, nc_start, nc_count, data_RHU);
-        handle_error(status_nc, GP.FP_RHU);
-
-        nc_start[0] = t_offset_WIN + t;
-        status_nc = nc_get_vara_int(ncID_WIN, varID_WIN, nc_start, nc_count, data_WIN);
-        handle_error(status_nc, GP.FP_WIN);
-
-        nc_start[0] = t_offset_TEM_AVG + t;
-        status_nc = nc_get_vara_int(ncID_TEM_AVG, varID_TEM_AVG, nc_start, nc_count, data_TEM_AVG);
-        handle_error(status_nc, GP.FP_TEM_AVG);
-
-        nc_start[0] = t_offset_TEM_MAX + t;
-        status_nc = nc_get_vara_int(ncID_TEM_MAX, varID_TEM_MAX, nc_start, nc_count, data_TEM_MAX);
-        handle_error(status_nc, GP.FP_TEM_MAX);
+        Forcing_Reader_Fetch(&forcing_reader, t - t_restart, data_forcing);
+        data_PRE = data_forcing[FORCING_PRE];
+        data_PRS = data_forcing[FORCING_PRS];
+        data_SSD = data_forcing[FORCING_SSD];
+        data_RHU = data_forcing[FORCING_RHU];
+        data_WIN = data_forcing[FORCING_WIN];
+        data_TEM_AVG = data_forcing[FORCING_TEM_AVG];
+        data_TEM_MAX = data_forcing[FORCING_TEM_MAX];
+        data_TEM_MIN = data_forcing[FORCING_TEM_MIN];
 
-        nc_start[0] = t_offset_TEM_MIN + t;
-        status_nc = nc_get_vara_int(ncID_TEM_MIN, varID_TEM_MIN, nc_start, nc_count, data_TEM_MIN);
-        handle_error(status_nc, GP.FP_TEM_MIN);
-
-        for (size_t i = 0; i < GEO_header.nrows; i++)
+        // the runoff arrays hold the whole series (BATCH) or only the current step (STREAM)
+        if (UH_stream == 1)
+        {
+            run_offset = 0;
+        }
+        else
         {
-            for (size_t j = 0; j < GEO_header.ncols; j++)
+            run_offset = t * cell_counts_total;
+        }
+        // the radiation terms depending only on the date and the latitude, once per row
+        Radiation_Astro_Rows(year, month, day, data_lat, GEO_header.nrows, radia_astro);
+        if (et_kernel != ET_KERNEL_SCALAR)
+        {
+            // the evapotranspiration and unsaturated zone of all the cells ahead of the cell loop, batch by batch
+            ET_Batch_Step(
+                &et_plan, et_kernel,
+                data_forcing, scale_forcing, radia_astro, GEO_header.ncols,
+                cell_veg, veg_table, i_m,
+                &data_RADIA, &data_ET, &data_SOIL, soil_para, Soil_d1, Soil_d2,
+                GP.STEP_TIME, &et_check_diff);
+            et_check_count += et_plan.cell_count;
+        }
+        /*****
+         * the vertical processes (ET and unsaturated zone) are independent among cells:
+         * rows are distributed over the threads, each cell writes only to its own index,
+         * so the results are identical to the serial run
+        */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64) private(index_geo, index_row, index_run, cell_PRE, cell_PRS, cell_SSD, cell_RHU, cell_WIN, cell_TEM_AVG, cell_TEM_MAX, cell_TEM_MIN, cell_veg_mon, Soil_Fe)
+#endif
+        for (int c = 0; c < cell_list.cell_count; c++)
+        {
+            index_geo = *(cell_list.cell_index + c);
+            index_row = index_geo / GEO_header.ncols;
+            /********************** indexing **************************/
+            index_run = run_offset + index_geo;
+            // printf("t: %d\n", t);
+            // printf("index_run: %d\n", index_run);
+            /************** weather forcing for cell ******************/
+            cell_PRE = *(data_PRE + index_geo) * scale_PRE / 1000; // [m]
+            cell_PRS = *(data_PRS + index_geo) * scale_PRS;
+            cell_SSD = *(data_SSD + index_geo) * scale_SSD;
+            cell_RHU = *(data_RHU + index_geo) * scale_RHU;
+            cell_WIN = *(data_WIN + index_geo) * scale_WIN;
+            cell_TEM_AVG = *(data_TEM_AVG + index_geo) * scale_TEM_AVG;
+            cell_TEM_MAX = *(data_TEM_MAX + index_geo) * scale_TEM_MAX;
+            cell_TEM_MIN = *(data_TEM_MIN + index_geo) * scale_TEM_MIN;
+            // printf(
+            //     "\n%8s%8s%8s%8s%8s%8s%8s%8s\n",
+            //     "PRE", "TEM_AVG", "TEM_MAX", "TEM_MIN", "WIN", "SSD", "RHU", "PRS");
+            // printf("%8.2f%8.2f%8.2f%8.2f%8.1f%8.0f%8.1f%8.1f\n",
+            //        cell_PRE * 1000, cell_TEM_AVG, cell_TEM_MAX, cell_TEM_MIN, cell_WIN, cell_SSD, cell_RHU, cell_PRS);
+            /******************* evapotranspiration *******************/
+            if (et_kernel == ET_KERNEL_SCALAR)
             {
-                index_geo = i * GEO_header.ncols + j;
-                if (*(data_SOILTYPE + index_geo) != GEO_header.NODATA_value)
-                {
-                    /********************** indexing **************************/
-                    index_run = t * cell_counts_total + index_geo;
-                    // printf("t: %d\n", t);
-                    // printf("index_run: %d\n", index_run);
-                    /************** weather forcing for cell ******************/
-                    cell_PRE = *(data_PRE + index_geo) * scale_PRE / 1000; // [m]
-                    cell_PRS = *(data_PRS + index_geo) * scale_PRS;
-                    cell_SSD = *(data_SSD + index_geo) * scale_SSD;
-                    cell_RHU = *(data_RHU + index_geo) * scale_RHU;
-                    cell_WIN = *(data_WIN + index_geo) * scale_WIN;
-                    cell_TEM_AVG = *(data_TEM_AVG + index_geo) * scale_TEM_AVG;
-                    cell_TEM_MAX = *(data_TEM_MAX + index_geo) * scale_TEM_MAX;
-                    cell_TEM_MIN = *(data_TEM_MIN + index_geo) * scale_TEM_MIN;
-                    // printf(
-                    //     "\n%8s%8s%8s%8s%8s%8s%8s%8s\n",
-                    //     "PRE", "TEM_AVG", "TEM_MAX", "TEM_MIN", "WIN", "SSD", "RHU", "PRS");
-                    // printf("%8.2f%8.2f%8.2f%8.2f%8.1f%8.0f%8.1f%8.1f\n",
-                    //        cell_PRE * 1000, cell_TEM_AVG, cell_TEM_MAX, cell_TEM_MIN, cell_WIN, cell_SSD, cell_RHU, cell_PRS);
-                    /**************** parameter preparation *****************/
-                    cell_lat = *(data_lat + i);
-
-                    /******************* evapotranspiration *******************/
-                    Soil_Fe = Soil_Desorption(
-                        (data_SOIL + index_geo)->SM_Upper,
-                        (cell_soil + index_geo)->Topsoil->SatHydrauCond,
-                        (1.0 / (cell_soil + index_geo)->Topsoil->PoreSizeDisP),
-                        ((cell_soil + index_geo)->Topsoil->Porosity / 100.0),
-                        (cell_soil + index_geo)->Topsoil->Bubbling,
-                        GP.STEP_TIME); // unit: m
-                    // printf("Soil_Fe\n");
-                    ET_CELL(
-                        year, month, day, cell_lat,
-                        cell_PRE, cell_TEM_AVG, cell_TEM_MIN, cell_TEM_MAX, cell_RHU, cell_PRS, cell_WIN,
-                        ws_obs_z, cell_SSD,
-                        &((data_RADIA + index_geo)->Rs),
-                        &((data_RADIA + index_geo)->L_sky),
-                        &((data_RADIA + index_geo)->Rno),
-                        &((data_RADIA + index_geo)->Rno_short),
-                        &((data_RADIA + index_geo)->Rnu),
-                        &((data_RADIA + index_geo)->Rnu_short),
-                        &((data_RADIA + index_geo)->Rns),
-                        (cell_veg + index_geo)->CAN_FRAC,
-                        (cell_veg + index_geo)->Albedo_o[i_m], (cell_veg + index_geo)->Albedo_u[i_m], ALBEDO_SOIL,
-                        (cell_veg + index_geo)->LAI_o[i_m], (cell_veg + index_geo)->LAI_u[i_m],
-                        (cell_veg + index_geo)->Rpc, (cell_veg + index_geo)->rs_min_o, RS_MAX,
-                        (cell_veg + index_geo)->Rpc, (cell_veg + index_geo)->rs_min_o, RS_MAX,
-
-                        (cell_veg + index_geo)->CAN_RZ, (cell_veg + index_geo)->CAN_H,
-                        (cell_veg + index_geo)->d_o[i_m], (cell_veg + index_geo)->z0_o[i_m],
-                        (cell_veg + index_geo)->d_u[i_m], (cell_veg + index_geo)->z0_u[i_m],
-                        (data_SOIL + index_geo)->SM_Upper,
-                        (cell_soil + index_geo)->Topsoil->WiltingPoint / 100,
-                        (cell_soil + index_geo)->Topsoil->FieldCapacity / 100,
-                        Soil_Fe,
-                        &((data_ET + index_geo)->Prec_throughfall),
-                        &((data_ET + index_geo)->Prec_net),
-                        &((data_ET + index_geo)->Ep),
-                        &((data_ET + index_geo)->EI_o),
-                        &((data_ET + index_geo)->ET_o),
-                        &((data_ET + index_geo)->EI_u),
-                        &((data_ET + index_geo)->ET_u),
-                        &((data_ET + index_geo)->ET_s),
-                        &((data_ET + index_geo)->Interception_o),
-                        &((data_ET + index_geo)->Interception_u),
-                        (cell_veg + index_geo)->Understory,
-                        GP.STEP_TIME);
-                        
-                    /******  save the intermiate stage variable values   ******/ 
-                    if (outnl.Rs == 1)
-                    {
-                        *(out_Rs + index_geo) = (int)((data_RADIA + index_geo)->Rs * 10);
-                    }
-                    if (outnl.L_sky == 1)
-                    {
-                        *(out_L_sky + index_geo) = (int)((data_RADIA + index_geo)->L_sky * 10);
-                    }
-                    if (outnl.Rno == 1)
-                    {
-                        *(out_Rno + index_geo) = (int)((data_RADIA + index_geo)->Rno * 10);
-                    }
-                    if (outnl.Rnu == 1)
-                    {
-                        *(out_Rnu + index_geo) = (int)((data_RADIA + index_geo)->Rnu * 10);
-                    }
-                    if (outnl.Ep == 1)
-                    {
-                        *(out_Ep + index_geo) = (int)((data_ET + index_geo)->Ep * GP.STEP_TIME * 10000);
-                    }
-                    if (outnl.EI_o == 1)
-                    {
-                        *(out_EI_o + index_geo) = (int)((data_ET + index_geo)->EI_o * 10000);
-                    }
-                    if (outnl.EI_u == 1)
-                    {
-                        *(out_EI_u + index_geo) = (int)((data_ET + index_geo)->EI_u * 10000);
-                    }
-                    if (outnl.ET_o == 1)
-                    {
-                        *(out_ET_o + index_geo) = (int)((data_ET + index_geo)->ET_o * 10000);
-                    }
-                    if (outnl.ET_u == 1)
-                    {
-                        *(out_ET_u + index_geo) = (int)((data_ET + index_geo)->ET_u * 10000);
-                    }
-                    if (outnl.ET_s == 1)
-                    {
-                        *(out_ET_s + index_geo) = (int)((data_ET + index_geo)->ET_s * 10000);
-                    }
-                    if (outnl.Prec_net == 1)
-                    {
-                        *(out_Prec_net + index_geo) = (int)((data_ET + index_geo)->Prec_net * 10000);
-                    }
-                    if (outnl.Interception_o == 1)
-                    {
-                        *(out_Interception_o + index_geo) = (int)((data_ET + index_geo)->Interception_o * 10000);
-                    }
-                    if (outnl.Interception_u == 1)
-                    {
-                        *(out_Interception_u + index_geo) = (int)((data_ET + index_geo)->Interception_u * 10000);
-                    }
-                    /**************** unsaturated soil zone water movement *****************/
-                    UnsaturatedWaterMove(
-                        (data_ET + index_geo)->Prec_net / GP.STEP_TIME,
-                        (data_ET + index_geo)->ET_o,
-                        (data_ET + index_geo)->ET_u,
-                        (data_ET + index_geo)->ET_s,
-                        &((data_SOIL + index_geo)->SM_Upper),
-                        &((data_SOIL + index_geo)->SM_Lower),
-                        &((data_SOIL + index_geo)->SW_Infiltration),
-                        &((data_SOIL + index_geo)->SW_Percolation_Upper),
-                        &((data_SOIL + index_geo)->SW_Percolation_Lower),
-                        (data_SOIL + index_geo)->SW_rise_lower,
-                        (data_SOIL + index_geo)->SW_rise_upper,
-                        &((data_SOIL + index_geo)->SW_SR_Infil),
-                        &((data_SOIL + index_geo)->SW_SR_Satur),
-                        Soil_d1,
-                        Soil_d2,
-                        cell_soil + index_geo,
-                        GP.STEP_TIME);
-                    
-                    /************************* save variables *************************/
-                    // mandatory
-                    *(out_SW_Run_Infil + index_run) = (int)((data_SOIL + index_geo)->SW_SR_Infil * 10000); // 0.1 mm
-                    *(out_SW_Run_Satur + index_run) = (int)((data_SOIL + index_geo)->SW_SR_Satur * 10000);
-                    // optional variable
-                    if (outnl.SM_Upper == 1)
-                    {
-                        *(out_SM_Upper + index_geo) = (int)((data_SOIL + index_geo)->SM_Upper * 100);
-                    }
-                    if (outnl.SM_Lower == 1)
-                    {
-                        *(out_SM_Lower + index_geo) = (int)((data_SOIL + index_geo)->SM_Lower * 100);
-                    }
-                    if (outnl.SW_Infiltration == 1)
-                    {
-                        *(out_SW_Infiltration + index_geo) = (int)((data_SOIL + index_geo)->SW_Infiltration * 10000);
-                    }
-                    if (outnl.SW_Percolation_Lower == 1)
-                    {
-                        *(out_SW_Percolation_Lower + index_geo) = (int)((data_SOIL + index_geo)->SW_Percolation_Lower * 10000);
-                    }
-                    if (outnl.SW_Percolation_Upper == 1)
-                    {
-                        *(out_SW_Percolation_Upper + index_geo) = (int)((data_SOIL + index_geo)->SW_Percolation_Upper * 10000);
-                    }
-                }
+                cell_veg_mon = veg_table + (cell_veg + index_geo)->CLASS * 12 + i_m;
+                Soil_Fe = Soil_Desorption(
+                    *(data_SOIL.SM_Upper + index_geo),
+                    (soil_para + index_geo)->Ksat_upper,
+                    (soil_para + index_geo)->PoreSize_index,
+                    (soil_para + index_geo)->Porosity_upper,
+                    (soil_para + index_geo)->Bubbling,
+                    GP.STEP_TIME); // unit: m
+                // printf("Soil_Fe\n");
+                ET_CELL(
+                    radia_astro + index_row,
+                    cell_PRE, cell_TEM_AVG, cell_TEM_MIN, cell_TEM_MAX, cell_RHU, cell_PRS, cell_WIN,
+                    cell_SSD,
+                    data_RADIA.Rs + index_geo,
+                    data_RADIA.L_sky + index_geo,
+                    data_RADIA.Rno + index_geo,
+                    data_RADIA.Rno_short + index_geo,
+                    data_RADIA.Rnu + index_geo,
+                    data_RADIA.Rnu_short + index_geo,
+                    data_RADIA.Rns + index_geo,
+                    (cell_veg + index_geo)->CAN_FRAC,
+                    cell_veg_mon->Albedo_o, cell_veg_mon->Albedo_u, ALBEDO_SOIL,
+                    cell_veg_mon->LAI_o, cell_veg_mon->LAI_u,
+                    cell_veg_mon->Rpc, cell_veg_mon->rs_min_o, RS_MAX,
+                    cell_veg_mon->Rpc, cell_veg_mon->rs_min_o, RS_MAX,
+                    &cell_veg_mon->aero,
+                    *(data_SOIL.SM_Upper + index_geo),
+                    (soil_para + index_geo)->WiltingPoint,
+                    (soil_para + index_geo)->FieldCapacity,
+                    Soil_Fe,
+                    data_ET.Prec_throughfall + index_geo,
+                    data_ET.Prec_net + index_geo,
+                    data_ET.Ep + index_geo,
+                    data_ET.EI_o + index_geo,
+                    data_ET.ET_o + index_geo,
+                    data_ET.EI_u + index_geo,
+                    data_ET.ET_u + index_geo,
+                    data_ET.ET_s + index_geo,
+                    data_ET.Interception_o + index_geo,
+                    data_ET.Interception_u + index_geo,
+                    cell_veg_mon->Understory,
+                    GP.STEP_TIME);
+            }
+                
+            /******  save the intermiate stage variable values   ******/ 
+            if (outnl.Rs == 1)
+            {
+                *(out_Rs + index_geo) = (int)(*(data_RADIA.Rs + index_geo) * 10);
+            }
+            if (outnl.L_sky == 1)
+            {
+                *(out_L_sky + index_geo) = (int)(*(data_RADIA.L_sky + index_geo) * 10);
+            }
+            if (outnl.Rno == 1)
+            {
+                *(out_Rno + index_geo) = (int)(*(data_RADIA.Rno + index_geo) * 10);
+            }
+            if (outnl.Rnu == 1)
+            {
+                *(out_Rnu + index_geo) = (int)(*(data_RADIA.Rnu + index_geo) * 10);
+            }
+            if (outnl.Ep == 1)
+            {
+                *(out_Ep + index_geo) = (int)(*(data_ET.Ep + index_geo) * GP.STEP_TIME * 10000);
+            }
+            if (outnl.EI_o == 1)
+            {
+                *(out_EI_o + index_geo) = (int)(*(data_ET.EI_o + index_geo) * 10000);
+            }
+            if (outnl.EI_u == 1)
+            {
+                *(out_EI_u + index_geo) = (int)(*(data_ET.EI_u + index_geo) * 10000);
+            }
+            if (outnl.ET_o == 1)
+            {
+                *(out_ET_o + index_geo) = (int)(*(data_ET.ET_o + index_geo) * 10000);
+            }
+            if (outnl.ET_u == 1)
+            {
+                *(out_ET_u + index_geo) = (int)(*(data_ET.ET_u + index_geo) * 10000);
+            }
+            if (outnl.ET_s == 1)
+            {
+                *(out_ET_s + index_geo) = (int)(*(data_ET.ET_s + index_geo) * 10000);
+            }
+            if (outnl.Prec_net == 1)
+            {
+                *(out_Prec_net + index_geo) = (int)(*(data_ET.Prec_net + index_geo) * 10000);
+            }
+            if (outnl.Interception_o == 1)
+            {
+                *(out_Interception_o + index_geo) = (int)(*(data_ET.Interception_o + index_geo) * 10000);
+            }
+            if (outnl.Interception_u == 1)
+            {
+                *(out_Interception_u + index_geo) = (int)(*(data_ET.Interception_u + index_geo) * 10000);
+            }
+            /**************** unsaturated soil zone water movement *****************/
+            if (et_kernel == ET_KERNEL_SCALAR)
+            {
+                UnsaturatedWaterMove(
+                    *(data_ET.Prec_net + index_geo) / GP.STEP_TIME,
+                    *(data_ET.ET_o + index_geo),
+                    *(data_ET.ET_u + index_geo),
+                    *(data_ET.ET_s + index_geo),
+                    data_SOIL.SM_Upper + index_geo,
+                    data_SOIL.SM_Lower + index_geo,
+                    data_SOIL.SW_Infiltration + index_geo,
+                    data_SOIL.SW_Percolation_Upper + index_geo,
+                    data_SOIL.SW_Percolation_Lower + index_geo,
+                    *(data_SOIL.SW_rise_lower + index_geo),
+                    *(data_SOIL.SW_rise_upper + index_geo),
+                    data_SOIL.SW_SR_Infil + index_geo,
+                    data_SOIL.SW_SR_Satur + index_geo,
+                    Soil_d1,
+                    Soil_d2,
+                    soil_para + index_geo,
+                    GP.STEP_TIME);
+            }
+            
+            /************************* save variables *************************/
+            // mandatory
+            *(out_SW_Run_Infil + index_run) = (int)(*(data_SOIL.SW_SR_Infil + index_geo) * 10000); // 0.1 mm
+            *(out_SW_Run_Satur + index_run) = (int)(*(data_SOIL.SW_SR_Satur + index_geo) * 10000);
+            // optional variable
+            if (outnl.SM_Upper == 1)
+            {
+                *(out_SM_Upper + index_geo) = (int)(*(data_SOIL.SM_Upper + index_geo) * 100);
+            }
+            if (outnl.SM_Lower == 1)
+            {
+                *(out_SM_Lower + index_geo) = (int)(*(data_SOIL.SM_Lower + index_geo) * 100);
+            }
+            if (outnl.SW_Infiltration == 1)
+            {
+                *(out_SW_Infiltration + index_geo) = (int)(*(data_SOIL.SW_Infiltration + index_geo) * 10000);
+            }
+            if (outnl.SW_Percolation_Lower == 1)
+            {
+                *(out_SW_Percolation_Lower + index_geo) = (int)(*(data_SOIL.SW_Percolation_Lower + index_geo) * 10000);
+            }
+            if (outnl.SW_Percolation_Upper == 1)
+            {
+                *(out_SW_Percolation_Upper + index_geo) = (int)(*(data_SOIL.SW_Percolation_Upper + index_geo) * 10000);
             }
         }
         /**************** water movement in saturated soil zone *****************/
 
-        Soil_Satu_Move(
-            data_DEM,
-            data_STR,
-            data_SOILTYPE,
-            &data_STREAM,
-            &data_SOIL,
-            soillib,
-            soilID,
-            Soil_Thickness,
-            Soil_d1,
-            Soil_d2,
-            stream_depth,
-            stream_width,
-            GEO_header.NODATA_value,
-            GEO_header.ncols,
-            GEO_header.nrows,
-            (double) cellsize_m,
-            GP.STEP_TIME);
+        time_satu_begin = Wall_Time();
+        if (satu_solver == SATU_SOLVER_IMPLICIT)
+        {
+            Soil_Satu_Move_Implicit(
+                &satu_system,
+                cell_list.cell_index,
+                cell_list.cell_count,
+                data_STR,
+                &data_STREAM,
+                &data_SOIL,
+                &data_NEIGHBOR,
+                soil_para,
+                Soil_Thickness,
+                Soil_d1,
+                stream_depth,
+                stream_width,
+                GEO_header.ncols,
+                (double) cellsize_m,
+                GP.STEP_TIME);
+        }
+        else
+        {
+            if (GP.SOIL_SATU_CFL > 0.0)
+            {
+                satu_substeps = Soil_Satu_Substeps(
+                    cell_list.cell_index,
+                    cell_list.cell_count,
+                    data_STR,
+                    &data_SOIL,
+                    soil_para,
+                    Soil_Thickness,
+                    Soil_d1,
+                    stream_width,
+                    (double) cellsize_m,
+                    GP.STEP_TIME,
+                    GP.SOIL_SATU_CFL);
+            }
+            satu_substeps_total += satu_substeps;
+            if (satu_substeps > satu_substeps_max)
+            {
+                satu_substeps_max = satu_substeps;
+            }
+            Soil_Satu_Move(
+                cell_list.cell_index,
+                cell_list.cell_count,
+                data_STR,
+                &data_STREAM,
+                &data_SOIL,
+                &data_NEIGHBOR,
+                soil_para,
+                Soil_Thickness,
+                Soil_d1,
+                Soil_d2,
+                stream_depth,
+                stream_width,
+                GEO_header.NODATA_value,
+                GEO_header.ncols,
+                (double) cellsize_m,
+                GP.STEP_TIME,
+                satu_kernel,
+                satu_substeps);
+        }
+        time_satu += Wall_Time() - time_satu_begin;
         
         /***** save soil stage variables ******/
         int tog;
         tog = outnl.SW_SUB_Qin + outnl.SW_SUB_Qout + outnl.SW_SUB_z + outnl.SW_SUB_rise_lower + outnl.SW_SUB_rise_upper + outnl.SW_SUB_rf; 
-        if (tog > 0)
+        if (tog > 0 && spinup == 0)
         {
-            for (size_t i = 0; i < GEO_header.nrows; i++)
+            for (int c = 0; c < cell_list.cell_count; c++)
             {
-                for (size_t j = 0; j < GEO_header.ncols; j++)
+                index_geo = *(cell_list.cell_index + c);
+                if (outnl.SW_SUB_Qin == 1)
                 {
-                    index_geo = i * GEO_header.ncols + j;
-                    if (*(data_DEM + index_geo) != GEO_header.NODATA_value)
-                    {
-                        if (outnl.SW_SUB_Qin == 1)
-                        {
-                            *(out_SW_SUB_Qin + index_geo) = (int)((data_SOIL + index_geo)->Qin / cellarea_m * GP.STEP_TIME * 10000);
-                        }
-                        if (outnl.SW_SUB_Qout == 1)
-                        {
-                            *(out_SW_SUB_Qout + index_geo) = (int)((data_SOIL + index_geo)->Qout / cellarea_m * GP.STEP_TIME * 10000);
-                        }
-                        if (outnl.SW_SUB_z == 1)
-                        {
-                            *(out_SW_SUB_z + index_geo) = (int)((data_SOIL + index_geo)->z * 100);
-                        }
-                        if (outnl.SW_SUB_rise_lower == 1)
-                        {
-                            *(out_SW_SUB_rise_lower + index_geo) = (int)((data_SOIL + index_geo)->SW_rise_lower * 10000);
-                        }
-                        if (outnl.SW_SUB_rise_upper == 1)
-                        {
-                            *(out_SW_SUB_rise_upper + index_geo) = (int)((data_SOIL + index_geo)->SW_rise_upper * 10000);
-                        }
-                        if (outnl.SW_SUB_rf == 1)
-                        {
-                            *(out_SW_SUB_rf + index_geo) = (int)((data_SOIL + index_geo)->SW_rf * 10000);
-                        }
-                    }
+                    *(out_SW_SUB_Qin + index_geo) = (int)(*(data_SOIL.Qin + index_geo) / cellarea_m * GP.STEP_TIME * 10000);
+                }
+                if (outnl.SW_SUB_Qout == 1)
+                {
+                    *(out_SW_SUB_Qout + index_geo) = (int)(*(data_SOIL.Qout + index_geo) / cellarea_m * GP.STEP_TIME * 10000);
+                }
+                if (outnl.SW_SUB_z == 1)
+                {
+                    *(out_SW_SUB_z + index_geo) = (int)(*(data_SOIL.z + index_geo) * 100);
+                }
+                if (outnl.SW_SUB_rise_lower == 1)
+                {
+                    *(out_SW_SUB_rise_lower + index_geo) = (int)(*(data_SOIL.SW_rise_lower + index_geo) * 10000);
+                }
+                if (outnl.SW_SUB_rise_upper == 1)
+                {
+                    *(out_SW_SUB_rise_upper + index_geo) = (int)(*(data_SOIL.SW_rise_upper + index_geo) * 10000);
+                }
+                if (outnl.SW_SUB_rf == 1)
+                {
+                    *(out_SW_SUB_rf + index_geo) = (int)(*(data_SOIL.SW_rf + index_geo) * 10000);
                 }
             }
         }
@@ -819,28 +1312,71 @@ int main(int argc, char *argv[])
         /********************* river channel flow routing ****************/
         Channel_Network_Routing(
             &data_STREAM,
-            data_STR,
-            GEO_header.ncols,
-            GEO_header.nrows,
+            &channel_network,
+            route_order,
             GP.STEP_TIME);
-        if (outnl.SW_SUB_Qc + outnl.Q_Channel > 0)
+        if (spinup == 1)
         {
-            for (size_t i = 0; i < GEO_header.nrows; i++)
+            /********************* spin-up: no output, no surface runoff routing ****************/
+            t += 1;
+            run_time += 3600 * GP.STEP_TIME;
+            if (t == spinup_steps)
             {
-                for (size_t j = 0; j < GEO_header.ncols; j++)
+                spinup_cycle += 1;
+                if (Spinup_Cycle(&data_SOIL, cell_list.cell_index, cell_list.cell_count,
+                                 spinup_mean, spinup_cycle, GP.SPINUP_TOL) == 1 ||
+                    spinup_cycle >= GP.SPINUP_CYCLES_MAX)
                 {
-                    index_geo = i * GEO_header.ncols + j;
-                    if (*(data_STR + index_geo) == 1)
+                    if (spinup_cycle >= GP.SPINUP_CYCLES_MAX)
                     {
-                        if (outnl.SW_SUB_Qc == 1)
-                        {
-                            *(out_SW_SUB_Qc + index_geo) = (int)((data_STREAM + index_geo)->Qc / cellarea_m * GP.STEP_TIME * 10000);
-                        }
-                        if (outnl.Q_Channel == 1)
-                        {
-                            *(out_Q_Channel + index_geo) = (int)((data_STREAM + index_geo)->Qout / 3600 * 1000);
-                        }
+                        printf("* warning: spin-up not converged within SPINUP_CYCLES_MAX = %d cycles\n", GP.SPINUP_CYCLES_MAX);
                     }
+                    spinup = 0;
+                    // the statistics of the saturated lateral flow and the ET_KERNEL CHECK cover the run only
+                    satu_substeps_total = 0;
+                    satu_substeps_max = 1;
+                    time_satu = 0.0;
+                    et_check_diff = 0;
+                    et_check_count = 0;
+                    if (satu_solver == SATU_SOLVER_IMPLICIT)
+                    {
+                        satu_system.iter_total = 0;
+                        satu_system.picard_total = 0;
+                        satu_system.solve_count = 0;
+                        satu_system.fail_count = 0;
+                    }
+                    time(&tm); printf("--------- %s xHM hydrological processes simulating: ", DateString(&tm));
+                }
+                // the next cycle, or the run, from the start of the forcing
+                Forcing_Reader_Stop(&forcing_reader);
+                Forcing_Reader_Start(
+                    &forcing_reader,
+                    ncID_forcing,
+                    varID_forcing,
+                    t_offset_forcing,
+                    FP_forcing,
+                    GEO_header.nrows,
+                    GEO_header.ncols,
+                    (spinup == 1) ? spinup_steps : time_steps_run,
+                    forcing_block,
+                    GP.FORCING_ASYNC);
+                t = 0;
+                run_time = start_time;
+            }
+            continue;
+        }
+        if (outnl.SW_SUB_Qc + outnl.Q_Channel > 0)
+        {
+            for (int c = 0; c < cell_list.stream_count; c++)
+            {
+                index_geo = *(cell_list.stream_index + c);
+                if (outnl.SW_SUB_Qc == 1)
+                {
+                    *(out_SW_SUB_Qc + index_geo) = (int)((data_STREAM + index_geo)->Qc / cellarea_m * GP.STEP_TIME * 10000);
+                }
+                if (outnl.Q_Channel == 1)
+                {
+                    *(out_Q_Channel + index_geo) = (int)((data_STREAM + index_geo)->Qout / 3600 * 1000);
                 }
             }
         }
@@ -849,7 +1385,66 @@ int main(int argc, char *argv[])
         {
             *(Qout_Sub + s * time_steps_run + t) = (data_STREAM + outlet_index_row[s] * GEO_header.ncols + outlet_index_col[s])->Qout;
         }
+        if (UH_mode == UH_MODE_STREAM)
+        {
+            /********************* surface runoff routing: UH, streaming ****************/
+            index_UH_ring = 0;
+            for (size_t s = 0; s < outlet_count; s++)
+            {
+                UH_Routing_Step(
+                    out_SW_Run_Infil,
+                    &uh_sparse[s],
+                    UH_ring_Infil + index_UH_ring,
+                    Qout_SF_Infil + time_steps_run * s,
+                    t,
+                    cell_list.cell_index,
+                    cell_list.cell_count,
+                    cellsize_m,
+                    GEO_header.NODATA_value,
+                    GP.STEP_TIME);
+                UH_Routing_Step(
+                    out_SW_Run_Satur,
+                    &uh_sparse[s],
+                    UH_ring_Satur + index_UH_ring,
+                    Qout_SF_Satur + time_steps_run * s,
+                    t,
+                    cell_list.cell_index,
+                    cell_list.cell_count,
+                    cellsize_m,
+                    GEO_header.NODATA_value,
+                    GP.STEP_TIME);
+                index_UH_ring += UH_steps[s];
+            }
+        }
+        else if (UH_mode == UH_MODE_CLASS)
+        {
+            /********************* surface runoff routing: UH of flow-time classes ****************/
+            for (size_t s = 0; s < outlet_count; s++)
+            {
+                UH_Class_Routing_Step(
+                    out_SW_Run_Infil,
+                    &uh_class[s],
+                    uh_class[s].ring_Infil,
+                    Qout_SF_Infil + time_steps_run * s,
+                    t,
+                    cell_list.cell_index,
+                    cell_list.cell_count,
+                    cellsize_m,
+                    GP.STEP_TIME);
+                UH_Class_Routing_Step(
+                    out_SW_Run_Satur,
+                    &uh_class[s],
+                    uh_class[s].ring_Satur,
+                    Qout_SF_Satur + time_steps_run * s,
+                    t,
+                    cell_list.cell_index,
+                    cell_list.cell_count,
+                    cellsize_m,
+                    GP.STEP_TIME);
+            }
+        }
         /********************* write state variable to .nc ***************/
+        Forcing_Reader_Lock_NC(&forcing_reader);
         Write_Outnamelist(
             t,
             outnl,
@@ -881,46 +1476,90 @@ int main(int argc, char *argv[])
             &out_SW_SUB_rf,
             &out_SW_SUB_Qc,
             &out_Q_Channel);
+        if (UH_stream == 1)
+        {
+            Write_Outnamelist_Runoff(t, outnl, outnl_ncid, GEO_header, &out_SW_Run_Infil, &out_SW_Run_Satur);
+        }
+        Forcing_Reader_Unlock_NC(&forcing_reader);
+        /********************* checkpoint: the state after t + 1 steps ***************/
+        if (GP.CHECKPOINT_STEPS > 0 && (t + 1) % GP.CHECKPOINT_STEPS == 0 && t + 1 < time_steps_run)
+        {
+            // the exported steps on disk first: a restart from this checkpoint continues the nc files
+            Forcing_Reader_Lock_NC(&forcing_reader);
+            OUTVAR_nc_sync(outnl, outnl_ncid, UH_stream);
+            Forcing_Reader_Unlock_NC(&forcing_reader);
+            Checkpoint_Write(
+                GP.FP_CHECKPOINT, &checkpoint, t + 1,
+                &data_RADIA, &data_ET, &data_SOIL, data_STREAM, cell_counts_total,
+                UH_ring_Infil, UH_ring_Satur, uh_class,
+                Qout_SF_Infil, Qout_SF_Satur, Qout_Sub,
+                out_SW_Run_Infil, out_SW_Run_Satur);
+        }
         /********************* next iteration ****************/
         t += 1;
         run_time += 3600 * GP.STEP_TIME;
     }
+    Forcing_Reader_Stop(&forcing_reader);
     OUTVAR_nc_close(outnl, outnl_ncid);
+    if (strlen(GP.FP_STATE_OUT) > 0)
+    {
+        // the state at run_time: the initial state of a run starting after end_time
+        State_Export(
+            GP.FP_STATE_OUT,
+            ncID_GEO,
+            (long)run_time,
+            GP.STEP_TIME,
+            &data_ET,
+            &data_SOIL,
+            data_STREAM,
+            &cell_list,
+            cell_counts_total,
+            GEO_header.NODATA_value);
+    }
     /***************************************************************************************************
      *                               export the variables: runoff generation
      ****************************************************************************************************/
-    Write2NC_Outnamelist(outnl, time_steps_run, &out_SW_Run_Infil, &out_SW_Run_Satur, GP);
+    if (UH_stream == 1)
+    {
+        OUTVAR_nc_close_Runoff(outnl, outnl_ncid);
+    }
+    else
+    {
+        Write2NC_Outnamelist(outnl, time_steps_run, &out_SW_Run_Infil, &out_SW_Run_Satur, GP);
+    }
     printf(" Done!\n");
     /************************ surface runoff routing **********************/
-    // UH method for multiple outlets
+    // UH method for multiple outlets; already routed at every step in STREAM mode
     time(&tm); printf("--------- %s xHM overland runoff routing with UH method: ", DateString(&tm));
-    int index_UH_gap;
-    index_UH_gap = 0;
-    for (size_t s = 0; s < outlet_count; s++)
+    if (UH_stream == 0)
     {
-        UH_Routing(
-            out_SW_Run_Infil, 
-            data_UH + index_UH_gap,
-            Qout_SF_Infil + time_steps_run * s,
-            UH_steps[s],
-            GEO_header.ncols,
-            GEO_header.nrows,
-            time_steps_run,
-            cellsize_m,
-            GEO_header.NODATA_value,
-            GP.STEP_TIME);
-        UH_Routing(
-            out_SW_Run_Satur, 
-            data_UH + index_UH_gap,
-            Qout_SF_Satur + time_steps_run * s,
-            UH_steps[s],
-            GEO_header.ncols,
-            GEO_header.nrows,
-            time_steps_run,
-            cellsize_m,
-            GEO_header.NODATA_value,
-            GP.STEP_TIME);
-        index_UH_gap += UH_steps[s] * cell_counts_total;
+        for (size_t s = 0; s < outlet_count; s++)
+        {
+            UH_Routing(
+                out_SW_Run_Infil, 
+                &uh_sparse[s],
+                Qout_SF_Infil + time_steps_run * s,
+                GEO_header.ncols,
+                GEO_header.nrows,
+                cell_list.cell_index,
+                cell_list.cell_count,
+                time_steps_run,
+                cellsize_m,
+                GEO_header.NODATA_value,
+                GP.STEP_TIME);
+            UH_Routing(
+                out_SW_Run_Satur, 
+                &uh_sparse[s],
+                Qout_SF_Satur + time_steps_run * s,
+                GEO_header.ncols,
+                GEO_header.nrows,
+                cell_list.cell_index,
+                cell_list.cell_count,
+                time_steps_run,
+                cellsize_m,
+                GEO_header.NODATA_value,
+                GP.STEP_TIME);
+        }
     }
     printf("Done!\n");
     /******************** total discharge at outlets ************************/
@@ -948,11 +1587,34 @@ int main(int argc, char *argv[])
     /***************************************************************************************************
      *                               finalize the program
      ****************************************************************************************************/
-    free(data_lon);free(data_lat);
+    free(data_lon);free(data_lat);free(radia_astro);
     free(data_DEM);free(data_FDR);free(data_SOILTYPE);free(data_STR);free(data_VEGFRAC);free(data_VEGTYPE);
-    free(data_PRE);free(data_PRS);free(data_RHU);free(data_SSD);free(data_WIN);free(data_TEM_AVG);free(data_TEM_MAX);free(data_TEM_MIN);
-    free(data_UH);
-    free(data_RADIA);free(data_SOIL);free(data_STREAM);free(data_ET);
+    free(UH_ring_Infil);free(UH_ring_Satur);
+    for (size_t s = 0; s < outlet_count; s++)
+    {
+        if (UH_mode == UH_MODE_CLASS)
+        {
+            UH_Class_Free(&uh_class[s]);
+        }
+        else
+        {
+            UH_Sparse_Free(&uh_sparse[s]);
+        }
+    }
+    free(out_SW_Run_Infil);free(out_SW_Run_Satur);
+    Free_RADIA(&data_RADIA);Free_ET(&data_ET);Free_SOIL(&data_SOIL);Free_NEIGHBOR(&data_NEIGHBOR);
+    free(data_STREAM);
+    Free_Channel_Network(&channel_network);
+    if (satu_solver == SATU_SOLVER_IMPLICIT)
+    {
+        Soil_Satu_System_Free(&satu_system);
+    }
+    free(cell_list.cell_index);free(cell_list.stream_index);
+    free(cell_veg);free(soil_para);
+    if (et_kernel != ET_KERNEL_SCALAR)
+    {
+        ET_Batch_Free(&et_plan);
+    }
 
     nc_close(ncID_PRE);
     nc_close(ncID_PRS);
@@ -964,6 +1626,23 @@ int main(int argc, char *argv[])
     nc_close(ncID_TEM_MIN);
     nc_close(ncID_GEO);
     nc_close(ncID_UH);
+    if (satu_solver == SATU_SOLVER_IMPLICIT)
+    {
+        printf("* saturated lateral flow (implicit): %.3f s, %.1f Picard and %.1f PCG iterations per step, %d solves not converged\n",
+               time_satu, (double)satu_system.picard_total / satu_system.solve_count,
+               (double)satu_system.iter_total / satu_system.solve_count, satu_system.fail_count);
+    }
+    else
+    {
+        printf("* saturated lateral flow (%s kernel): %.3f s, %ld sub-steps (%.2f per step, at most %d)\n",
+               GP.SOIL_SATU_KERNEL, time_satu, satu_substeps_total,
+               (double)satu_substeps_total / (time_steps_run - t_restart), satu_substeps_max);
+    }
+    if (et_kernel == ET_KERNEL_CHECK)
+    {
+        printf("* ET_KERNEL CHECK: %ld of %ld cell steps differ from ET_CELL() and UnsaturatedWaterMove()\n",
+               et_check_diff, et_check_count);
+    }
     time(&tm); printf("--------- %s xHM modelling: Done!\n", DateString(&tm));
     return 1;
 }
@@ -990,3 +1669,13 @@ char *DateString(
     return buf;
 }
 
+double Wall_Time(void)
+{
+    /* elapsed time in seconds, for timing the model components */
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+